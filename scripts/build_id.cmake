@@ -0,0 +1,23 @@
+# Copyright (c) Prevail Verifier contributors.
+# SPDX-License-Identifier: MIT
+
+# Write to OUTPUT a header that defines VERIFIER_BUILD_ID as a hash of the files listed in SOURCES_FILE, one per line.
+# The header is only rewritten when the id changes, so that what includes it is not rebuilt for nothing.
+file(STRINGS "${SOURCES_FILE}" sources)
+list(SORT sources)
+set(hashes "")
+foreach (source IN LISTS sources)
+    file(SHA256 "${source}" hash)
+    string(APPEND hashes "${hash}\n")
+endforeach ()
+string(SHA256 build_id "${hashes}")
+
+set(content "// Generated by scripts/build_id.cmake from the sources of the verifier.\n")
+string(APPEND content "#define VERIFIER_BUILD_ID \"${build_id}\"\n")
+set(old_content "")
+if (EXISTS "${OUTPUT}")
+    file(READ "${OUTPUT}" old_content)
+endif ()
+if (NOT content STREQUAL old_content)
+    file(WRITE "${OUTPUT}" "${content}")
+endif ()
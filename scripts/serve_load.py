@@ -0,0 +1,81 @@
+#!/usr/bin/python3
+# Copyright (c) Prevail Verifier contributors.
+# SPDX-License-Identifier: MIT
+#
+# Usage: python3 serve_load.py [--jobs N] [--in-flight N] [--rounds N] FILE.o...
+#
+# Send the programs of the ELF files to ./serve, keeping up to --in-flight requests waiting at once,
+# and report how many it answered per second and how long they waited for their answer.
+import argparse
+import subprocess
+import sys
+import threading
+import time
+
+
+def list_programs(filename):
+    out = subprocess.run(['./check', filename, '-l'], capture_output=True, text=True).stdout
+    for line in out.splitlines():
+        words = dict(word.split('=', 1) for word in line.split() if '=' in word)
+        if 'section' in words and 'function' in words:
+            yield 'elf={} section={} function={}'.format(filename, words['section'], words['function'])
+
+
+def percentile(values, p):
+    return values[min(len(values) - 1, int(len(values) * p / 100))]
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Measure the throughput and latency of ./serve.')
+    parser.add_argument('files', nargs='+', help='ELF files whose programs are sent')
+    parser.add_argument('--jobs', type=int, default=0, help='--jobs of ./serve, default: one per core')
+    parser.add_argument('--in-flight', type=int, default=64, help='requests sent before waiting for an answer')
+    parser.add_argument('--rounds', type=int, default=1, help='times each program is sent')
+    args = parser.parse_args()
+
+    programs = [p for filename in args.files for p in list_programs(filename)] * args.rounds
+    if not programs:
+        print('no programs found', file=sys.stderr)
+        return 1
+
+    command = ['./serve'] + (['--jobs', str(args.jobs)] if args.jobs else [])
+    server = subprocess.Popen(command, stdin=subprocess.PIPE, stdout=subprocess.PIPE, text=True, bufsize=1)
+    slots = threading.Semaphore(args.in_flight)
+    sent = {}
+    latencies = []
+    outcomes = {}
+
+    def read_responses():
+        for line in server.stdout:
+            words = line.split(' ', 2)
+            if len(words) < 2 or words[1] == 'warning':
+                continue
+            id = words[0]
+            latencies.append(time.perf_counter() - sent.pop(id))
+            outcomes[words[1]] = outcomes.get(words[1], 0) + 1
+            slots.release()
+
+    reader = threading.Thread(target=read_responses)
+    reader.start()
+    begin = time.perf_counter()
+    for i, program in enumerate(programs):
+        slots.acquire()
+        sent[str(i)] = time.perf_counter()
+        server.stdin.write('id={} {}\n'.format(i, program))
+    server.stdin.close()
+    reader.join()
+    server.wait()
+    elapsed = time.perf_counter() - begin
+
+    latencies.sort()
+    print('requests: {}'.format(len(latencies)))
+    for outcome, count in sorted(outcomes.items()):
+        print('  {}: {}'.format(outcome, count))
+    print('throughput: {:.1f} requests/s'.format(len(latencies) / elapsed))
+    print('latency p50: {:.4f} s'.format(percentile(latencies, 50)))
+    print('latency p99: {:.4f} s'.format(percentile(latencies, 99)))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -4,6 +4,7 @@
 #include <cassert>
 #include <map>
 #include <optional>
+#include <ranges>
 #include <string>
 #include <vector>
 
@@ -76,11 +77,21 @@ struct cfg_builder_t final {
     }
 
     void set_assertions(const label_t& label, const std::vector<Assertion>& assertions) {
-        if (!prog.m_cfg.contains(label)) {
+        if (!prog.m_instructions.contains(label)) {
             CRAB_ERROR("Label ", to_string(label), " not found in the CFG: ");
         }
         prog.m_assertions.insert_or_assign(label, assertions);
     }
+
+    /// Add the labels of a subprogram built on its own, keeping its control-flow graph apart.
+    void add_subprogram(const label_t& target, Program&& subprogram) {
+        for (auto& [label, ins] : subprogram.m_instructions) {
+            if (label != label_t::entry && label != label_t::exit) {
+                prog.m_instructions.emplace(label, std::move(ins));
+            }
+        }
+        prog.m_subprograms.emplace(target, std::move(subprogram.m_cfg));
+    }
 };
 
 using crab::basic_block_t;
@@ -217,8 +228,120 @@ static void add_cfg_nodes(cfg_builder_t& builder, const label_t& caller_label, c
     }
 }
 
+/// Build the control-flow graph of a subprogram on its own, out of the code reachable from its first instruction,
+/// with labels in a stack frame named after that instruction.
+static cfg_builder_t subprogram_to_cfg(const cfg_builder_t& builder, const label_t& entry_label) {
+    const crab::cfg_t& cfg = builder.prog.cfg();
+    const std::string stack_frame_prefix = to_string(entry_label);
+    const auto in_frame = [&](const label_t& label) { return label_t{label.from, label.to, stack_frame_prefix}; };
+
+    cfg_builder_t res;
+    std::set seen_labels{entry_label};
+    vector macro_labels{entry_label};
+    while (!macro_labels.empty()) {
+        const label_t macro_label = macro_labels.back();
+        macro_labels.pop_back();
+
+        auto inst = builder.prog.instruction_at(macro_label);
+        if (const auto pexit = std::get_if<Exit>(&inst)) {
+            pexit->stack_frame_prefix = stack_frame_prefix;
+        } else if (const auto pcall = std::get_if<Call>(&inst)) {
+            pcall->stack_frame_prefix = stack_frame_prefix;
+        } else if (const auto pcall_local = std::get_if<CallLocal>(&inst)) {
+            pcall_local->stack_frame_prefix = to_string(pcall_local->target);
+        }
+        res.insert(in_frame(macro_label), inst);
+
+        for (const label_t& next_macro_label : cfg.children_of(macro_label)) {
+            if (next_macro_label != cfg.exit_label() && seen_labels.insert(next_macro_label).second) {
+                macro_labels.push_back(next_macro_label);
+            }
+        }
+    }
+
+    res.add_child(res.prog.cfg().entry_label(), in_frame(entry_label));
+    for (const label_t& macro_label : seen_labels) {
+        for (const label_t& next_macro_label : cfg.children_of(macro_label)) {
+            // An exit instruction returns from the subprogram.
+            res.add_child(in_frame(macro_label), next_macro_label == cfg.exit_label() ? res.prog.cfg().exit_label()
+                                                                                       : in_frame(next_macro_label));
+        }
+    }
+    return res;
+}
+
+/// The targets of the local calls of a control-flow graph.
+static set<label_t> local_call_targets(const cfg_builder_t& builder) {
+    set<label_t> res;
+    for (const label_t& label : builder.prog.labels()) {
+        if (const auto pins = std::get_if<CallLocal>(&builder.prog.instruction_at(label))) {
+            res.insert(pins->target);
+        }
+    }
+    return res;
+}
+
+/// Number of stack frames needed to call a subprogram, counting those of the calls it makes in turn.
+static int call_stack_height(const label_t& target, const std::map<label_t, set<label_t>>& callees,
+                             std::map<label_t, int>& heights, set<label_t>& active) {
+    if (const auto it = heights.find(target); it != heights.end()) {
+        return it->second;
+    }
+    if (!active.insert(target).second) {
+        throw InvalidControlFlow{to_string(target) + ": illegal recursion"};
+    }
+    int height = 1;
+    for (const label_t& callee : callees.at(target)) {
+        height = std::max(height, 1 + call_stack_height(callee, callees, heights, active));
+    }
+    active.erase(target);
+    heights.emplace(target, height);
+    return height;
+}
+
+/// Build the control-flow graph of each subprogram called, directly or not, by a program whose local calls are not
+/// inlined, by the target of the calls to it.
+static std::map<label_t, cfg_builder_t> collect_subprograms(cfg_builder_t& builder) {
+    const set<label_t> targets = local_call_targets(builder);
+    for (const label_t& label : builder.prog.labels()) {
+        if (const auto pcall = std::get_if<CallLocal>(&builder.prog.instruction_at(label))) {
+            pcall->stack_frame_prefix = to_string(pcall->target);
+        }
+    }
+
+    std::map<label_t, cfg_builder_t> res;
+    std::map<label_t, set<label_t>> callees;
+    vector worklist(targets.begin(), targets.end());
+    while (!worklist.empty()) {
+        const label_t target = worklist.back();
+        worklist.pop_back();
+        if (res.contains(target)) {
+            continue;
+        }
+        if (!builder.prog.cfg().contains(target)) {
+            throw InvalidControlFlow{"call to undefined label " + to_string(target)};
+        }
+        const auto& [it, _] = res.emplace(target, subprogram_to_cfg(builder, target));
+        callees.emplace(target, local_call_targets(it->second));
+        for (const label_t& callee : callees.at(target)) {
+            worklist.push_back(callee);
+        }
+    }
+
+    // Reject what inlining the calls would reject.
+    std::map<label_t, int> heights;
+    set<label_t> active;
+    for (const label_t& target : targets) {
+        if (1 + call_stack_height(target, callees, heights, active) > MAX_CALL_STACK_FRAMES) {
+            throw InvalidControlFlow{"too many call stack frames"};
+        }
+    }
+    return res;
+}
+
 /// Convert an instruction sequence to a control-flow graph (CFG).
-static cfg_builder_t instruction_seq_to_cfg(const InstructionSeq& insts, const bool must_have_exit) {
+static cfg_builder_t instruction_seq_to_cfg(const InstructionSeq& insts, const bool must_have_exit,
+                                            const bool summarize_local_calls) {
     cfg_builder_t builder;
 
     // First add all instructions to the CFG without connecting
@@ -277,6 +400,11 @@ static cfg_builder_t instruction_seq_to_cfg(const InstructionSeq& insts, const b
         }
     }
 
+    if (summarize_local_calls) {
+        // Calls keep their edge to the next instruction, and their effect is computed from the subprogram.
+        return builder;
+    }
+
     // Now replace macros. We have to do this as a second pass so that
     // we only add new nodes that are actually reachable, based on the
     // results of the first pass.
@@ -295,21 +423,41 @@ Program Program::from_sequence(const InstructionSeq& inst_seq, const program_inf
     thread_local_options = options;
 
     // Convert the instruction sequence to a deterministic control-flow graph.
-    cfg_builder_t builder = instruction_seq_to_cfg(inst_seq, options.cfg_opts.must_have_exit);
+    cfg_builder_t builder = instruction_seq_to_cfg(inst_seq, options.cfg_opts.must_have_exit,
+                                                   options.cfg_opts.summarize_local_calls);
+    std::map<label_t, cfg_builder_t> subprograms;
+    if (options.cfg_opts.summarize_local_calls) {
+        subprograms = collect_subprograms(builder);
+    }
 
     // Detect loops using Weak Topological Ordering (WTO) and insert counters at loop entry points. WTO provides a
     // hierarchical decomposition of the CFG that identifies all strongly connected components (cycles) and their entry
     // points. These entry points serve as natural locations for loop counters that help verify program termination.
     if (options.cfg_opts.check_for_termination) {
-        const crab::wto_t wto{builder.prog.cfg()};
-        wto.for_each_loop_head([&](const label_t& label) -> void {
-            builder.insert_after(label, label_t::make_increment_counter(label), IncrementLoopCounter{label});
-        });
+        const auto insert_loop_counters = [](cfg_builder_t& cfg_builder) {
+            const crab::wto_t wto{cfg_builder.prog.cfg()};
+            wto.for_each_loop_head([&](const label_t& label) -> void {
+                cfg_builder.insert_after(label, label_t::make_increment_counter(label), IncrementLoopCounter{label});
+            });
+        };
+        insert_loop_counters(builder);
+        for (cfg_builder_t& subprogram : std::views::values(subprograms)) {
+            insert_loop_counters(subprogram);
+        }
+    }
+    for (auto& [target, subprogram] : subprograms) {
+        builder.add_subprogram(target, std::move(subprogram.prog));
     }
 
     // Annotate the CFG by explicitly adding in assertions before every memory instruction.
-    for (const auto& label : builder.prog.labels()) {
-        builder.set_assertions(label, get_assertions(builder.prog.instruction_at(label), info, label));
+    const auto annotate = [&](const crab::cfg_t& cfg) {
+        for (const auto& label : cfg.labels()) {
+            builder.set_assertions(label, get_assertions(builder.prog.instruction_at(label), info, label));
+        }
+    };
+    annotate(builder.prog.cfg());
+    for (const crab::cfg_t& cfg : std::views::values(builder.prog.subprograms())) {
+        annotate(cfg);
     }
     return builder.prog;
 }
@@ -366,6 +514,37 @@ std::set<basic_block_t> basic_block_t::collect_basic_blocks(const cfg_t& cfg, co
     return res;
 }
 
+std::map<label_t, basic_block_t> basic_block_t::collect_chains(const cfg_t& cfg, const std::set<label_t>& chain_ends) {
+    std::map<label_t, basic_block_t> res;
+    std::set<label_t> seen;
+    const auto add_chain = [&](const label_t& first) {
+        basic_block_t bb{first};
+        seen.insert(first);
+        while (cfg.out_degree(bb.last_label()) == 1 && !chain_ends.contains(bb.last_label())) {
+            const label_t& next_label = cfg.get_child(bb.last_label());
+            if (next_label == cfg.exit_label() || cfg.in_degree(next_label) != 1 || seen.contains(next_label)) {
+                break;
+            }
+            bb.m_ts.push_back(next_label);
+            seen.insert(next_label);
+        }
+        res.emplace(first, std::move(bb));
+    };
+    for (const label_t& label : cfg.labels()) {
+        if (label == cfg.exit_label() || cfg.in_degree(label) != 1 || cfg.num_siblings(label) != 1 ||
+            chain_ends.contains(*cfg.parents_of(label).begin())) {
+            add_chain(label);
+        }
+    }
+    // What remains are cycles of single-parent labels that cannot be reached from any of the chains above.
+    for (const label_t& label : cfg.labels()) {
+        if (!seen.contains(label)) {
+            add_chain(label);
+        }
+    }
+    return res;
+}
+
 /// Get the type of given Instruction.
 /// Most of these type names are also statistics header labels.
 static std::string instype(Instruction ins) {
@@ -464,3 +643,26 @@ crab::cfg_t crab::cfg_from_adjacency_list(const std::map<label_t, std::vector<la
     }
     return builder.prog.cfg();
 }
+
+crab::frozen_cfg_t::frozen_cfg_t(const cfg_t& cfg) {
+    // Labels are visited in order, so node ids follow label order, and so do parents and children.
+    for (const label_t& label : cfg.labels()) {
+        _labels.push_back(label);
+    }
+    _entry = node(cfg.entry_label());
+    _exit = node(cfg.exit_label());
+    _parent_offsets.reserve(_labels.size() + 1);
+    _child_offsets.reserve(_labels.size() + 1);
+    for (const label_t& label : _labels) {
+        _parent_offsets.push_back(gsl::narrow<uint32_t>(_parents.size()));
+        for (const label_t& prev : cfg.parents_of(label)) {
+            _parents.push_back(node(prev));
+        }
+        _child_offsets.push_back(gsl::narrow<uint32_t>(_children.size()));
+        for (const label_t& next : cfg.children_of(label)) {
+            _children.push_back(node(next));
+        }
+    }
+    _parent_offsets.push_back(gsl::narrow<uint32_t>(_parents.size()));
+    _child_offsets.push_back(gsl::narrow<uint32_t>(_children.size()));
+}
@@ -1,11 +1,24 @@
 // Copyright (c) Prevail Verifier contributors.
 // SPDX-License-Identifier: MIT
+#include <array>
+#include <cstring>
 #include <iostream>
 #include <map>
 #include <set>
+#include <span>
+#include <streambuf>
 #include <string>
 #include <sys/stat.h>
 #include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#undef max
+#undef min
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 #include "elfio/elfio.hpp"
 #include "libbtf/btf_json.h"
@@ -22,15 +35,112 @@ static std::vector<T> vector_of(const char* data, const ELFIO::Elf_Xword size) {
     if (size % sizeof(T) != 0 || size > std::numeric_limits<uint32_t>::max() || !data) {
         throw UnmarshalError("Invalid argument to vector_of");
     }
-    return {reinterpret_cast<const T*>(data), reinterpret_cast<const T*>(data + size)};
+    // The data may be a view of a mapped file, where it need not be aligned for T.
+    std::vector<T> result(size / sizeof(T));
+    std::memcpy(result.data(), data, size);
+    return result;
 }
 
 template <typename T>
     requires std::is_trivially_copyable_v<T>
-static std::vector<T> vector_of(const ELFIO::section& sec) {
-    return vector_of<T>(sec.get_data(), sec.get_size());
+static std::vector<T> vector_of(const std::span<const char> bytes) {
+    return vector_of<T>(bytes.data(), bytes.size());
 }
 
+// A read-only mapping of a whole file. It is empty when the file cannot be mapped, e.g., when it is not a regular
+// file, in which case the caller reads the file as a stream.
+class mapped_file_t final {
+    const char* _data{};
+    size_t _size{};
+
+  public:
+    explicit mapped_file_t(const std::string& path) {
+#ifdef _WIN32
+        const HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                        FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return;
+        }
+        LARGE_INTEGER size;
+        if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+            if (const HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr)) {
+                // The view keeps the mapping alive.
+                if (const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) {
+                    _data = static_cast<const char*>(view);
+                    _size = gsl::narrow<size_t>(size.QuadPart);
+                }
+                CloseHandle(mapping);
+            }
+        }
+        CloseHandle(file);
+#else
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat st;
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            // The mapping stays valid once the file is closed.
+            const void* view = mmap(nullptr, gsl::narrow<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (view != MAP_FAILED) {
+                _data = static_cast<const char*>(view);
+                _size = gsl::narrow<size_t>(st.st_size);
+            }
+        }
+        close(fd);
+#endif
+    }
+
+    ~mapped_file_t() {
+        if (_data) {
+#ifdef _WIN32
+            UnmapViewOfFile(_data);
+#else
+            munmap(const_cast<char*>(_data), _size);
+#endif
+        }
+    }
+
+    mapped_file_t(const mapped_file_t&) = delete;
+    mapped_file_t& operator=(const mapped_file_t&) = delete;
+
+    [[nodiscard]]
+    std::span<const char> bytes() const {
+        return {_data, _size};
+    }
+};
+
+// Reads bytes in memory as a stream, without copying them.
+class span_streambuf_t final : public std::streambuf {
+  public:
+    explicit span_streambuf_t(const std::span<const char> bytes) {
+        // The get area is never written to.
+        char* begin = const_cast<char*>(bytes.data());
+        setg(begin, begin, begin + bytes.size());
+    }
+
+  protected:
+    pos_type seekoff(const off_type off, const std::ios_base::seekdir dir,
+                     const std::ios_base::openmode which) override {
+        if (!(which & std::ios_base::in)) {
+            return pos_type(off_type(-1));
+        }
+        const off_type base = dir == std::ios_base::beg   ? 0
+                              : dir == std::ios_base::cur ? gptr() - eback()
+                                                          : egptr() - eback();
+        const off_type pos = base + off;
+        if (pos < 0 || pos > egptr() - eback()) {
+            return pos_type(off_type(-1));
+        }
+        setg(eback(), eback() + pos, egptr());
+        return pos_type(pos);
+    }
+
+    pos_type seekpos(const pos_type pos, const std::ios_base::openmode which) override {
+        return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+};
+
 int create_map_crab(const EbpfMapType& map_type, const uint32_t key_size, const uint32_t value_size,
                     const uint32_t max_entries, ebpf_verifier_options_t) {
     const EquivalenceKey equiv{map_type.value_type, key_size, value_size, map_type.is_array ? max_entries : 0};
@@ -79,10 +189,34 @@ struct parse_params_t {
     const ebpf_verifier_options_t& options;
     const ebpf_platform_t* platform;
     const std::string desired_section;
+    // The whole file when it is mapped, or empty when it is only read as a stream.
+    std::span<const char> image;
 };
 
+// The bytes of a section. They are a view of the mapped file when there is one, so that ELFIO does not load them.
+static std::span<const char> section_bytes(const parse_params_t& parse_params, const ELFIO::section& sec) {
+    const std::span<const char> image = parse_params.image;
+    if (!image.empty() && sec.get_type() != ELFIO::SHT_NOBITS && sec.get_offset() <= image.size() &&
+        sec.get_size() <= image.size() - sec.get_offset()) {
+        return image.subspan(sec.get_offset(), sec.get_size());
+    }
+    const char* data = sec.get_data();
+    return {data, data ? sec.get_size() : 0};
+}
+
+static std::vector<raw_program> read_elf(std::istream& input_stream, const parse_params_t& parse_params);
+
 std::vector<raw_program> read_elf(const std::string& path, const std::string& desired_section,
                                   const ebpf_verifier_options_t& options, const ebpf_platform_t* platform) {
+    if (const mapped_file_t mapping{path}; !mapping.bytes().empty()) {
+        span_streambuf_t buffer{mapping.bytes()};
+        std::istream stream{&buffer};
+        return read_elf(stream, parse_params_t{.path = path,
+                                               .options = options,
+                                               .platform = platform,
+                                               .desired_section = desired_section,
+                                               .image = mapping.bytes()});
+    }
     if (std::ifstream stream{path, std::ios::in | std::ios::binary}) {
         return read_elf(stream, path, desired_section, options, platform);
     }
@@ -183,7 +317,9 @@ static ELFIO::const_symbol_section_accessor read_and_validate_symbol_section(con
 
 static ELFIO::elfio load_elf(std::istream& input_stream, const std::string& path) {
     ELFIO::elfio reader;
-    if (!reader.load(input_stream)) {
+    // Only read the headers now. The data of a section is read from the stream when it is first used, so that the
+    // sections that the verifier ignores, such as debug information, are never loaded.
+    if (!reader.load(input_stream, true)) {
         throw UnmarshalError("Can't process ELF file " + path);
     }
     return reader;
@@ -198,8 +334,8 @@ static void dump_btf_types(const libbtf::btf_type_data& btf_data, const std::str
     std::cout << std::endl;
 }
 
-static void update_line_info(std::vector<raw_program>& raw_programs, const ELFIO::section* btf_section,
-                             const ELFIO::section* btf_ext) {
+static void update_line_info(std::vector<raw_program>& raw_programs, const std::span<const char> btf_section,
+                             const std::span<const char> btf_ext) {
     auto visitor = [&raw_programs](const std::string& section, const uint32_t instruction_offset,
                                    const std::string& file_name, const std::string& source, const uint32_t line_number,
                                    const uint32_t column_number) {
@@ -216,7 +352,7 @@ static void update_line_info(std::vector<raw_program>& raw_programs, const ELFIO
         }
     };
 
-    libbtf::btf_parse_line_information(vector_of<std::byte>(*btf_section), vector_of<std::byte>(*btf_ext), visitor);
+    libbtf::btf_parse_line_information(vector_of<std::byte>(btf_section), vector_of<std::byte>(btf_ext), visitor);
 
     // BTF doesn't include line info for every instruction, only on the first instruction per source line.
     for (auto& program : raw_programs) {
@@ -234,7 +370,15 @@ static elf_global_data parse_btf_section(const parse_params_t& parse_params, con
     if (!btf_section) {
         return {};
     }
-    const libbtf::btf_type_data btf_data = vector_of<std::byte>(*btf_section);
+    // The types only describe the maps and the global variables, so they are not decoded for a file that has neither.
+    const bool has_variables = std::ranges::any_of(std::array{".rodata", ".data", ".bss"}, [&](const char* name) {
+        const auto section = reader.sections[name];
+        return section && section->get_size() != 0;
+    });
+    if (!reader.sections[".maps"] && !has_variables && !parse_params.options.verbosity_opts.dump_btf_types_json) {
+        return {};
+    }
+    const libbtf::btf_type_data btf_data = vector_of<std::byte>(section_bytes(parse_params, *btf_section));
     if (parse_params.options.verbosity_opts.dump_btf_types_json) {
         dump_btf_types(btf_data, parse_params.path);
     }
@@ -307,13 +451,14 @@ static elf_global_data parse_map_sections(const parse_params_t& parse_params, co
 
         if (map_count > 0) {
             map_record_size = s->get_size() / map_count;
-            if (s->get_data() == nullptr || map_record_size == 0) {
+            const std::span<const char> data = section_bytes(parse_params, *s);
+            if (data.data() == nullptr || map_record_size == 0) {
                 throw UnmarshalError("bad maps section");
             }
             if (s->get_size() % map_record_size != 0) {
                 throw UnmarshalError("bad maps section size");
             }
-            parse_params.platform->parse_maps_section(global.map_descriptors, s->get_data(), map_record_size, map_count,
+            parse_params.platform->parse_maps_section(global.map_descriptors, data.data(), map_record_size, map_count,
                                                       parse_params.platform, parse_params.options);
         }
         global.map_section_indices.insert(s->get_index());
@@ -552,7 +697,7 @@ class program_reader_t {
             if (section_size == 0) {
                 continue;
             }
-            const auto section_data = section->get_data();
+            const auto section_data = section_bytes(parse_params, *section).data();
             if (section_data == nullptr) {
                 continue;
             }
@@ -595,9 +740,12 @@ class program_reader_t {
                                  "\nMake sure to inline all function calls.");
         }
 
-        if (const auto btf_section = reader.sections[".BTF"]) {
+        // Source lines are only printed, so they are not decoded unless the options ask for them.
+        if (const auto btf_section = reader.sections[".BTF"];
+            btf_section && parse_params.options.verbosity_opts.print_line_info) {
             if (const auto btf_ext = reader.sections[".BTF.ext"]) {
-                update_line_info(raw_programs, btf_section, btf_ext);
+                update_line_info(raw_programs, section_bytes(parse_params, *btf_section),
+                                 section_bytes(parse_params, *btf_ext));
             }
         }
 
@@ -634,15 +782,21 @@ class program_reader_t {
     }
 };
 
-std::vector<raw_program> read_elf(std::istream& input_stream, const std::string& path,
-                                  const std::string& desired_section, const ebpf_verifier_options_t& options,
-                                  const ebpf_platform_t* platform) {
-    const parse_params_t parse_params{
-        .path = path, .options = options, .platform = platform, .desired_section = desired_section};
-    const ELFIO::elfio reader = load_elf(input_stream, path);
-    const ELFIO::const_symbol_section_accessor symbols = read_and_validate_symbol_section(reader, path);
+static std::vector<raw_program> read_elf(std::istream& input_stream, const parse_params_t& parse_params) {
+    const ELFIO::elfio reader = load_elf(input_stream, parse_params.path);
+    const ELFIO::const_symbol_section_accessor symbols = read_and_validate_symbol_section(reader, parse_params.path);
     const elf_global_data global = extract_global_data(parse_params, reader, symbols);
     program_reader_t program_reader{parse_params, reader, symbols, global};
     program_reader.read_programs();
     return std::move(program_reader.raw_programs);
 }
+
+std::vector<raw_program> read_elf(std::istream& input_stream, const std::string& path,
+                                  const std::string& desired_section, const ebpf_verifier_options_t& options,
+                                  const ebpf_platform_t* platform) {
+    return read_elf(input_stream, parse_params_t{.path = path,
+                                                 .options = options,
+                                                 .platform = platform,
+                                                 .desired_section = desired_section,
+                                                 .image = {}});
+}
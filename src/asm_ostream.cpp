@@ -33,9 +33,14 @@ std::ostream& operator<<(std::ostream& o, const interval_t& interval) {
     }
     return o;
 }
-std::ostream& operator<<(std::ostream& o, const number_t& z) { return o << z._n.str(); }
+std::ostream& operator<<(std::ostream& o, const number_t& z) { return o << z.to_string(); }
 
-std::string number_t::to_string() const { return _n.str(); }
+std::string number_t::to_string() const {
+    if (const int64_t* n = small()) {
+        return std::to_string(*n);
+    }
+    return std::get<cpp_int>(_n).str();
+}
 
 std::string interval_t::to_string() const {
     std::ostringstream s;
@@ -108,19 +113,26 @@ void print_jump(std::ostream& o, const std::string& direction, const std::set<la
 void print_program(const Program& prog, std::ostream& os, const bool simplify, const printfunc& prefunc,
                    const printfunc& postfunc) {
     LineInfoPrinter printer{os};
-    for (const crab::basic_block_t& bb : crab::basic_block_t::collect_basic_blocks(prog.cfg(), simplify)) {
-        prefunc(os, bb.first_label());
-        print_jump(os, "from", prog.cfg().parents_of(bb.first_label()));
-        os << bb.first_label() << ":\n";
-        for (const label_t& label : bb) {
-            printer.print_line_info(label);
-            for (const auto& pre : prog.assertions_at(label)) {
-                os << "  " << "assert " << pre << ";\n";
+    const auto print_cfg = [&](const crab::cfg_t& cfg) {
+        for (const crab::basic_block_t& bb : crab::basic_block_t::collect_basic_blocks(cfg, simplify)) {
+            prefunc(os, bb.first_label());
+            print_jump(os, "from", cfg.parents_of(bb.first_label()));
+            os << bb.first_label() << ":\n";
+            for (const label_t& label : bb) {
+                printer.print_line_info(label);
+                for (const auto& pre : prog.assertions_at(label)) {
+                    os << "  " << "assert " << pre << ";\n";
+                }
+                os << "  " << prog.instruction_at(label) << ";\n";
             }
-            os << "  " << prog.instruction_at(label) << ";\n";
+            print_jump(os, "goto", cfg.children_of(bb.last_label()));
+            postfunc(os, bb.last_label());
         }
-        print_jump(os, "goto", prog.cfg().children_of(bb.last_label()));
-        postfunc(os, bb.last_label());
+    };
+    print_cfg(prog.cfg());
+    for (const auto& [target, cfg] : prog.subprograms()) {
+        os << "\nsubprogram " << target << ":\n";
+        print_cfg(cfg);
     }
     os << "\n";
 }
@@ -188,10 +200,10 @@ void print_invariants(std::ostream& os, const Program& prog, const bool simplify
     print_program(
         prog, os, simplify,
         [&](std::ostream& os, const label_t& label) -> void {
-            os << "\nPre-invariant : " << invariants.invariants.at(label).pre << "\n";
+            os << "\nPre-invariant : " << invariants.at(label).pre << "\n";
         },
         [&](std::ostream& os, const label_t& label) -> void {
-            os << "\nPost-invariant : " << invariants.invariants.at(label).post << "\n";
+            os << "\nPost-invariant : " << invariants.at(label).post << "\n";
         });
 }
 
@@ -2,11 +2,18 @@
 // SPDX-License-Identifier: MIT
 #pragma once
 
+#include <chrono>
+#include <cstddef>
+#include <optional>
+
 struct prepare_cfg_options {
     /// When true, verifies that the program terminates.
     bool check_for_termination = false;
     /// When true, ensures the program has a valid exit block.
     bool must_have_exit = true;
+    /// When true, builds each subprogram once instead of inlining it at every call site, and analyzes it once per
+    /// distinct calling context, reusing the result at every call site with that context.
+    bool summarize_local_calls = false;
 };
 
 struct verbosity_options_t {
@@ -26,6 +33,17 @@ struct verbosity_options_t {
     bool dump_btf_types_json = false;
 };
 
+/// The numerical domains the analysis can run with. They share the same transformers and checks, and only differ in
+/// the relations between variables that are kept after each instruction.
+enum class numeric_domain_t {
+    /// The bounds of each variable.
+    interval,
+    /// The bounds of each variable, and the differences between variables that fit in a budget.
+    bounded_zone,
+    /// The bounds of and all the differences between variables.
+    zone,
+};
+
 struct ebpf_verifier_options_t {
     // Options that control how the control flow graph is built.
     prepare_cfg_options cfg_opts;
@@ -48,6 +66,36 @@ struct ebpf_verifier_options_t {
     // True if the ELF file is built on a big endian system.
     bool big_endian = false;
 
+    // Number of threads used to analyze independent WTO components concurrently; 0 or 1 to analyze sequentially.
+    // The resulting invariants are the same either way.
+    int analysis_threads = 0;
+
+    // True to keep invariants only at the boundaries of chains of instructions, and recompute the invariants inside
+    // a chain when they are needed. This takes less memory, at the cost of some time when the invariants are read.
+    bool compact_invariants = false;
+
+    // True to forget the registers and bytes of the stack that are not live where control flow merges, before the
+    // join. This keeps the numerical domain small, but the invariants there no longer describe what is dead.
+    bool prune_dead_variables = false;
+
+    // How much the numerical domain knows of the relations between variables. Less is cheaper, but proves fewer
+    // programs safe.
+    numeric_domain_t numeric_domain = numeric_domain_t::zone;
+
+    // The budget of numeric_domain_t::bounded_zone: the most relations with other variables it keeps for each
+    // variable, and in all, after each instruction; no value for no limit. Over budget, the relations that improve the
+    // least on the bounds of their variables are forgotten first. The bounds themselves are always kept.
+    std::optional<std::size_t> max_relations_per_variable = 4;
+    std::optional<std::size_t> max_relations;
+
+    // True to decide the verdict with intervals first, and only run the analysis with numeric_domain when intervals
+    // do not prove the program safe.
+    bool tiered_verification = false;
+
+    // When set, the analysis throws crab::AnalysisTimeout once it is still running at this time. It does not change the
+    // result of an analysis that ends in time.
+    std::optional<std::chrono::steady_clock::time_point> deadline;
+
     verbosity_options_t verbosity_opts;
 };
 
@@ -190,6 +190,22 @@ class AddBottom final {
         }
     }
 
+    bool limit_relations(const std::optional<std::size_t> max_per_variable,
+                         const std::optional<std::size_t> max_total) {
+        if (dom) {
+            return dom->limit_relations(max_per_variable, max_total);
+        }
+        return false;
+    }
+
+    [[nodiscard]]
+    std::pair<std::size_t, std::size_t> size() const {
+        if (dom) {
+            return dom->size();
+        }
+        return {0, 0};
+    }
+
     // Return true if inv intersects with cst.
     [[nodiscard]]
     bool intersect(const linear_constraint_t& cst) const {
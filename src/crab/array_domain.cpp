@@ -2,6 +2,8 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include <algorithm>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <set>
 #include <unordered_map>
@@ -9,7 +11,6 @@
 #include <vector>
 
 #include "boost/endian/conversion.hpp"
-#include "radix_tree/radix_tree.hpp"
 #include <gsl/narrow>
 
 #include "config.hpp"
@@ -22,71 +23,16 @@ namespace crab::domains {
 
 using index_t = uint64_t;
 
-static bool maybe_between(const NumAbsDomain& dom, const extended_number& x, const linear_expression_t& symb_lb,
-                          const linear_expression_t& symb_ub) {
-    using namespace dsl_syntax;
-    assert(x.is_finite());
-    const linear_expression_t num(*x.number());
-    NumAbsDomain tmp(dom);
-    tmp.add_constraint(num >= symb_lb);
-    tmp.add_constraint(num <= symb_ub);
-    return !tmp.is_bottom();
-}
-
 class offset_t final {
     index_t _index{};
-    int _prefix_length;
 
   public:
-    static constexpr int bitsize = 8 * sizeof(index_t);
-    offset_t() : _prefix_length(bitsize) {}
-    explicit offset_t(const index_t index) : _index(index), _prefix_length(bitsize) {}
-    offset_t(const index_t index, const int prefix_length) : _index(index), _prefix_length(prefix_length) {}
+    offset_t() = default;
+    explicit offset_t(const index_t index) : _index(index) {}
     explicit operator int() const { return gsl::narrow<int>(_index); }
     operator index_t() const { return _index; }
-    [[nodiscard]]
-    int prefix_length() const {
-        return _prefix_length;
-    }
-
-    index_t operator[](const int n) const { return (_index >> (bitsize - 1 - n)) & 1; }
 };
 
-// NOTE: required by radix_tree
-// Get the length of a key, which is the size usable with the [] operator.
-[[maybe_unused]]
-int radix_length(const offset_t& offset) {
-    return offset.prefix_length();
-}
-
-// NOTE: required by radix_tree
-// Get a range of bits out of the middle of a key, starting at [begin] for a given length.
-[[maybe_unused]]
-offset_t radix_substr(const offset_t& key, const int begin, const int length) {
-    index_t mask;
-
-    if (length == offset_t::bitsize) {
-        mask = 0;
-    } else {
-        mask = index_t{1} << length;
-    }
-
-    mask -= 1;
-    mask <<= offset_t::bitsize - length - begin;
-
-    const index_t value = (gsl::narrow_cast<index_t>(key) & mask) << begin;
-    return offset_t{value, length};
-}
-
-// NOTE: required by radix_tree
-// Concatenate two bit patterns.
-[[maybe_unused]]
-offset_t radix_join(const offset_t& entry1, const offset_t& entry2) {
-    const index_t value = entry1 | (entry2 >> entry1.prefix_length());
-    const int prefix_length = entry1.prefix_length() + entry2.prefix_length();
-    return offset_t{value, prefix_length};
-}
-
 /***
    Conceptually, a cell is tuple of an array, offset, size, and
    scalar variable such that:
@@ -136,7 +82,7 @@ class cell_t final {
     }
 
     // ignore the scalar variable
-    bool operator==(const cell_t& o) const { return to_interval() == o.to_interval(); }
+    bool operator==(const cell_t& o) const { return _offset == o._offset && _size == o._size; }
 
     // ignore the scalar variable
     bool operator<(const cell_t& o) const {
@@ -158,55 +104,31 @@ class cell_t final {
         return res;
     }
 
-    // Return true if [symb_lb, symb_ub] may overlap with the cell,
-    // where symb_lb and symb_ub are not constant expressions.
-    [[nodiscard]]
-    bool symbolic_overlap(const linear_expression_t& symb_lb, const linear_expression_t& symb_ub,
-                          const NumAbsDomain& dom) const;
-
     friend std::ostream& operator<<(std::ostream& o, const cell_t& c) { return o << "cell(" << c.to_interval() << ")"; }
 };
 
-// Return true if [symb_lb, symb_ub] may overlap with the cell,
-// where symb_lb and symb_ub are not constant expressions.
-bool cell_t::symbolic_overlap(const linear_expression_t& symb_lb, const linear_expression_t& symb_ub,
-                              const NumAbsDomain& dom) const {
-    const interval_t x = to_interval();
-    return maybe_between(dom, x.lb(), symb_lb, symb_ub) || maybe_between(dom, x.ub(), symb_lb, symb_ub);
-}
-
 // Map offsets to cells
 class offset_map_t final {
   private:
     friend class array_domain_t;
 
-    using cell_set_t = std::set<cell_t>;
-
     /*
-      The keys in the patricia tree are processing in big-endian order. This means that the keys are sorted.
-      Sortedness is very important to efficiently perform operations such as checking for overlap cells.
-      Since keys are treated as bit patterns, negative offsets can be used, but they are treated as large unsigned
-      numbers.
+      The cells are kept in a contiguous vector, sorted by offset and then by size. Offsets are bounded by the size of
+      the stack, so there are few cells, and moving some of them on insertion costs less than allocating tree nodes.
+      Since every cell is at most _max_size bytes long, the cells overlapping a range all start in a window just
+      before it, which is found by binary search and scanned in order.
     */
-    using patricia_tree_t = radix_tree<offset_t, cell_set_t>;
-
-    patricia_tree_t _map;
+    std::vector<cell_t> _cells;
 
-    // for algorithm::lower_bound and algorithm::upper_bound
-    struct compare_binding_t {
-        bool operator()(const patricia_tree_t::value_type& kv, const offset_t& o) const { return kv.first < o; }
-        bool operator()(const offset_t& o, const patricia_tree_t::value_type& kv) const { return o < kv.first; }
-        bool operator()(const patricia_tree_t::value_type& kv1, const patricia_tree_t::value_type& kv2) const {
-            return kv1.first < kv2.first;
-        }
-    };
+    /// Upper bound on the size of the cells, which is the largest size of a cell ever inserted.
+    unsigned _max_size{};
 
     void remove_cell(const cell_t& c);
 
     void insert_cell(const cell_t& c);
 
     [[nodiscard]]
-    std::optional<cell_t> get_cell(offset_t o, unsigned size);
+    std::optional<cell_t> get_cell(offset_t o, unsigned size) const;
 
     cell_t mk_cell(offset_t o, unsigned size);
 
@@ -215,12 +137,12 @@ class offset_map_t final {
 
     [[nodiscard]]
     bool empty() const {
-        return _map.empty();
+        return _cells.empty();
     }
 
     [[nodiscard]]
     std::size_t size() const {
-        return _map.size();
+        return _cells.size();
     }
 
     void operator-=(const cell_t& c) { remove_cell(c); }
@@ -232,13 +154,14 @@ class offset_map_t final {
     }
 
     // Return in out all cells that might overlap with (o, size).
-    std::vector<cell_t> get_overlap_cells(offset_t o, unsigned size);
+    [[nodiscard]]
+    std::vector<cell_t> get_overlap_cells(offset_t o, unsigned size) const;
 
     [[nodiscard]]
     std::vector<cell_t> get_overlap_cells_symbolic_offset(const NumAbsDomain& dom, const linear_expression_t& symb_lb,
-                                                          const linear_expression_t& symb_ub);
+                                                          const linear_expression_t& symb_ub) const;
 
-    friend std::ostream& operator<<(std::ostream& o, offset_map_t& m);
+    friend std::ostream& operator<<(std::ostream& o, const offset_map_t& m);
 
     /* Operations needed if used as value in a separate_domain */
     [[nodiscard]]
@@ -261,50 +184,84 @@ class offset_map_t final {
 };
 
 void offset_map_t::remove_cell(const cell_t& c) {
-    const offset_t key = c.get_offset();
-    _map[key].erase(c);
+    if (const auto it = std::lower_bound(_cells.begin(), _cells.end(), c); it != _cells.end() && *it == c) {
+        _cells.erase(it);
+    }
 }
 
+// Return all cells that might overlap with [symb_lb, symb_ub],
+// where symb_lb and symb_ub are not constant expressions.
 [[nodiscard]]
 std::vector<cell_t> offset_map_t::get_overlap_cells_symbolic_offset(const NumAbsDomain& dom,
                                                                     const linear_expression_t& symb_lb,
-                                                                    const linear_expression_t& symb_ub) {
+                                                                    const linear_expression_t& symb_ub) const {
+    using namespace dsl_syntax;
     std::vector<cell_t> out;
-    for (const auto& [_offset, o_cells] : _map) {
-        // All cells in o_cells have the same offset. They only differ in the size.
-        // If the largest cell overlaps with [offset, offset + size)
-        // then the rest of cells are considered to overlap.
-        // This is an over-approximation because [offset, offset+size) can overlap
-        // with the largest cell, but it doesn't necessarily overlap with smaller cells.
-        // For efficiency, we assume it overlaps with all.
-        cell_t largest_cell;
-        for (const cell_t& c : o_cells) {
-            if (largest_cell.is_null()) {
-                largest_cell = c;
-            } else {
-                assert(c.get_offset() == largest_cell.get_offset());
-                if (largest_cell < c) {
-                    largest_cell = c;
-                }
-            }
+    if (_cells.empty() || dom.is_bottom()) {
+        return out;
+    }
+    // The bounds are evaluated once for all the cells. A cell outside [min(symb_lb), max(symb_ub)] cannot overlap.
+    const interval_t lb = dom.eval_interval(symb_lb);
+    const interval_t ub = dom.eval_interval(symb_ub);
+    const interval_t range{lb.lb(), ub.ub()};
+    if (range.is_bottom()) {
+        return out;
+    }
+    // Usually symb_ub is symb_lb plus a constant size. Then [symb_lb, symb_ub] overlaps the cell iff symb_lb is in
+    // [cell.lb - size, cell.ub], and the interval of symb_lb decides it without looking at the other variables.
+    const linear_expression_t width = symb_ub.subtract(symb_lb);
+    const std::optional<interval_t> widen_by =
+        width.is_constant() ? std::optional{interval_t{number_t{0}, width.constant_term()}} : std::nullopt;
+
+    // Cells starting after max(symb_ub) cannot overlap, and neither can the cells ending before min(symb_lb), which
+    // all start before min(symb_lb) - (_max_size - 1).
+    auto first = _cells.begin();
+    if (const auto min_lb = range.lb().number()) {
+        first = std::lower_bound(_cells.begin(), _cells.end(), *min_lb - (_max_size - 1),
+                                 [](const cell_t& c, const number_t& n) {
+                                     return number_t{static_cast<index_t>(c.get_offset())} < n;
+                                 });
+    }
+    const std::optional<number_t> max_ub = range.ub().number();
+    for (auto it = first; it != _cells.end(); ++it) {
+        const interval_t x = it->to_interval();
+        if (max_ub && x.lb() > *max_ub) {
+            break;
         }
-        if (!largest_cell.is_null()) {
-            if (largest_cell.symbolic_overlap(symb_lb, symb_ub, dom)) {
-                for (const auto& c : o_cells) {
-                    out.push_back(c);
-                }
+        if ((x & range).is_bottom()) {
+            continue;
+        }
+        if (widen_by) {
+            if (!(lb & (x - *widen_by)).is_bottom()) {
+                out.push_back(*it);
             }
+            continue;
+        }
+        // In every state, symb_lb <= cell.ub and symb_ub >= cell.lb.
+        if (lb.ub() <= x.ub() && ub.lb() >= x.lb()) {
+            out.push_back(*it);
+            continue;
+        }
+        // The intervals are ambiguous: ask the relational domain whether the range is known to miss the cell.
+        const number_t cell_lb = *x.lb().number();
+        const number_t cell_ub = *x.ub().number();
+        if (!dom.entail(symb_ub < cell_lb) && !dom.entail(symb_lb > cell_ub)) {
+            out.push_back(*it);
         }
     }
     return out;
 }
 
-void offset_map_t::insert_cell(const cell_t& c) { _map[c.get_offset()].insert(c); }
+void offset_map_t::insert_cell(const cell_t& c) {
+    if (const auto it = std::lower_bound(_cells.begin(), _cells.end(), c); it == _cells.end() || !(*it == c)) {
+        _cells.insert(it, c);
+        _max_size = std::max(_max_size, c._size);
+    }
+}
 
-std::optional<cell_t> offset_map_t::get_cell(const offset_t o, const unsigned size) {
-    cell_set_t& cells = _map[o];
-    const auto it = cells.find(cell_t(o, size));
-    if (it != cells.end()) {
+std::optional<cell_t> offset_map_t::get_cell(const offset_t o, const unsigned size) const {
+    const cell_t c(o, size);
+    if (const auto it = std::lower_bound(_cells.begin(), _cells.end(), c); it != _cells.end() && *it == c) {
         return *it;
     }
     return {};
@@ -323,98 +280,21 @@ cell_t offset_map_t::mk_cell(const offset_t o, const unsigned size) {
     return c;
 }
 
-// Return all cells that might overlap with (o, size).
-std::vector<cell_t> offset_map_t::get_overlap_cells(const offset_t o, const unsigned size) {
+// Return all cells that might overlap with (o, size), except the cell (o, size) itself.
+std::vector<cell_t> offset_map_t::get_overlap_cells(const offset_t o, const unsigned size) const {
     std::vector<cell_t> out;
-    constexpr compare_binding_t comp;
-
-    bool added = false;
-    auto maybe_c = get_cell(o, size);
-    if (!maybe_c) {
-        maybe_c = cell_t(o, size);
-        insert_cell(*maybe_c);
-        added = true;
-    }
-
-    auto lb_it = std::lower_bound(_map.begin(), _map.end(), o, comp);
-    if (lb_it != _map.end()) {
-        // Store _map[begin,...,lb_it] into a vector so that we can
-        // go backwards from lb_it.
-        //
-        // TODO: give support for reverse iterator in patricia_tree.
-        std::vector<cell_set_t> upto_lb;
-        upto_lb.reserve(std::distance(_map.begin(), lb_it));
-        for (auto it = _map.begin(), et = lb_it; it != et; ++it) {
-            upto_lb.push_back(it->second);
-        }
-        upto_lb.push_back(lb_it->second);
-
-        for (int i = gsl::narrow<int>(upto_lb.size() - 1); i >= 0; --i) {
-            ///////
-            // All the cells in upto_lb[i] have the same offset. They
-            // just differ in the size.
-            //
-            // If none of the cells in upto_lb[i] overlap with (o, size)
-            // we can stop.
-            ////////
-            bool continue_outer_loop = false;
-            for (const cell_t& x : upto_lb[i]) {
-                if (x.overlap(o, size)) {
-                    if (x != *maybe_c) {
-                        // FIXME: we might have some duplicates. this is a very drastic solution.
-                        if (std::ranges::find(out, x) == out.end()) {
-                            out.push_back(x);
-                        }
-                    }
-                    continue_outer_loop = true;
-                }
-            }
-            if (!continue_outer_loop) {
-                break;
-            }
-        }
-    }
-
-    // search for overlapping cells > o
-    auto ub_it = std::upper_bound(_map.begin(), _map.end(), o, comp);
-    for (; ub_it != _map.end(); ++ub_it) {
-        bool continue_outer_loop = false;
-        for (const cell_t& x : ub_it->second) {
-            if (x.overlap(o, size)) {
-                // FIXME: we might have some duplicates. this is a very drastic solution.
-                if (std::ranges::find(out, x) == out.end()) {
-                    out.push_back(x);
-                }
-                continue_outer_loop = true;
-            }
-        }
-        if (!continue_outer_loop) {
-            break;
+    if (_cells.empty()) {
+        return out;
+    }
+    // A cell overlapping [o, o + size) starts at most _max_size - 1 bytes before o, and before o + size.
+    const index_t window_start = o < _max_size ? 0 : o - (_max_size - 1);
+    const cell_t self(o, size);
+    for (auto it = std::ranges::lower_bound(_cells, offset_t{window_start}, std::less{}, &cell_t::get_offset);
+         it != _cells.end() && it->get_offset() < o + size; ++it) {
+        if (!(*it == self) && it->overlap(o, size)) {
+            out.push_back(*it);
         }
     }
-
-    // do not forget the rest of overlapping cells == o
-    for (auto it = ++lb_it, et = ub_it; it != et; ++it) {
-        bool continue_outer_loop = false;
-        for (const cell_t& x : it->second) {
-            if (x == *maybe_c) { // we don't put it in out
-                continue;
-            }
-            if (x.overlap(o, size)) {
-                if (std::ranges::find(out, x) == out.end()) {
-                    out.push_back(x);
-                }
-                continue_outer_loop = true;
-            }
-        }
-        if (!continue_outer_loop) {
-            break;
-        }
-    }
-
-    if (added) {
-        remove_cell(*maybe_c);
-    }
     return out;
 }
 
@@ -425,23 +305,71 @@ static thread_local lazy_allocator<array_map_t> thread_local_array_map;
 
 void clear_thread_local_state() { thread_local_array_map.clear(); }
 
-static offset_map_t& lookup_array_map(const data_kind_t kind) { return (*thread_local_array_map)[kind]; }
+struct array_map_state_t {
+    lazy_allocator<array_map_t> map;
+};
+
+std::shared_ptr<array_map_state_t> make_array_map_state() { return std::make_shared<array_map_state_t>(); }
+
+void swap_thread_local_state(array_map_state_t& state) { thread_local_array_map.swap(state.map); }
+
+struct shared_array_map_t {
+    array_map_t* map;
+    // Recursive since array operations call each other.
+    std::recursive_mutex mutex;
+};
+
+static thread_local std::shared_ptr<shared_array_map_t> thread_local_shared_array_map;
+
+std::shared_ptr<shared_array_map_t> share_array_map() {
+    if (!thread_local_shared_array_map) {
+        thread_local_shared_array_map = std::make_shared<shared_array_map_t>(&thread_local_array_map.get());
+    }
+    return thread_local_shared_array_map;
+}
+
+void use_shared_array_map(std::shared_ptr<shared_array_map_t> shared) {
+    thread_local_shared_array_map = std::move(shared);
+}
+
+// Holds the lock on the array map for the duration of an array operation, if the map is shared.
+class array_map_guard_t final {
+    std::unique_lock<std::recursive_mutex> lock;
+
+  public:
+    array_map_guard_t() {
+        if (thread_local_shared_array_map) {
+            lock = std::unique_lock(thread_local_shared_array_map->mutex);
+        }
+    }
+};
+
+// Callers must hold an array_map_guard_t for as long as they use the result.
+static offset_map_t& lookup_array_map(const data_kind_t kind) {
+    if (thread_local_shared_array_map) {
+        return (*thread_local_shared_array_map->map)[kind];
+    }
+    return (*thread_local_array_map)[kind];
+}
 
 void array_domain_t::initialize_numbers(const int lb, const int width) {
+    const array_map_guard_t guard;
     num_bytes.reset(lb, width);
     lookup_array_map(data_kind_t::svalues).mk_cell(offset_t{gsl::narrow_cast<index_t>(lb)}, width);
 }
 
-std::ostream& operator<<(std::ostream& o, offset_map_t& m) {
-    if (m._map.empty()) {
+std::ostream& operator<<(std::ostream& o, const offset_map_t& m) {
+    if (m._cells.empty()) {
         o << "empty";
     } else {
-        for (const auto& [_offset, cells] : m._map) {
+        for (auto cit = m._cells.begin(); cit != m._cells.end();) {
+            // Cells of the same offset are printed together.
+            const offset_t offset = cit->get_offset();
             o << "{";
-            for (auto cit = cells.begin(), cet = cells.end(); cit != cet;) {
+            for (; cit != m._cells.end() && cit->get_offset() == offset;) {
                 o << *cit;
                 ++cit;
-                if (cit != cet) {
+                if (cit != m._cells.end() && cit->get_offset() == offset) {
                     o << ",";
                 }
             }
@@ -455,6 +383,7 @@ std::ostream& operator<<(std::ostream& o, offset_map_t& m) {
 void array_domain_t::split_cell(NumAbsDomain& inv, const data_kind_t kind, const int cell_start_index,
                                 const unsigned int len) const {
     assert(kind == data_kind_t::svalues || kind == data_kind_t::uvalues);
+    const array_map_guard_t guard;
 
     // Get the values from the indicated stack range.
     const std::optional<linear_expression_t> svalue = load(inv, data_kind_t::svalues, number_t(cell_start_index), len);
@@ -472,6 +401,7 @@ void array_domain_t::split_cell(NumAbsDomain& inv, const data_kind_t kind, const
 void array_domain_t::split_number_var(NumAbsDomain& inv, data_kind_t kind, const linear_expression_t& i,
                                       const linear_expression_t& elem_size) const {
     assert(kind == data_kind_t::svalues || kind == data_kind_t::uvalues);
+    const array_map_guard_t guard;
     offset_map_t& offset_map = lookup_array_map(kind);
     interval_t ii = inv.eval_interval(i);
     std::optional<number_t> n = ii.singleton();
@@ -521,6 +451,7 @@ static std::optional<std::pair<offset_t, unsigned>> kill_and_find_var(NumAbsDoma
                                                                       const linear_expression_t& i,
                                                                       const linear_expression_t& elem_size) {
     std::optional<std::pair<offset_t, unsigned>> res;
+    const array_map_guard_t guard;
 
     offset_map_t& offset_map = lookup_array_map(kind);
     interval_t ii = inv.eval_interval(i);
@@ -628,6 +559,7 @@ std::optional<uint8_t> get_value_byte(const NumAbsDomain& inv, const offset_t o,
 
 std::optional<linear_expression_t> array_domain_t::load(const NumAbsDomain& inv, data_kind_t kind,
                                                         const linear_expression_t& i, int width) const {
+    const array_map_guard_t guard;
     interval_t ii = inv.eval_interval(i);
     if (std::optional<number_t> n = ii.singleton()) {
         offset_map_t& offset_map = lookup_array_map(kind);
@@ -757,6 +689,7 @@ static std::optional<std::pair<offset_t, unsigned>> split_and_find_var(const arr
 std::optional<variable_t> array_domain_t::store(NumAbsDomain& inv, const data_kind_t kind,
                                                 const linear_expression_t& idx, const linear_expression_t& elem_size,
                                                 const linear_expression_t& val) {
+    const array_map_guard_t guard;
     if (auto maybe_cell = split_and_find_var(*this, inv, kind, idx, elem_size)) {
         // perform strong update
         auto [offset, size] = *maybe_cell;
@@ -778,6 +711,7 @@ std::optional<variable_t> array_domain_t::store_type(NumAbsDomain& inv, const li
                                                      const linear_expression_t& elem_size,
                                                      const linear_expression_t& val) {
     constexpr auto kind = data_kind_t::types;
+    const array_map_guard_t guard;
     if (auto maybe_cell = split_and_find_var(*this, inv, kind, idx, elem_size)) {
         // perform strong update
         auto [offset, size] = *maybe_cell;
@@ -23,6 +23,7 @@
 
 #pragma once
 
+#include <memory>
 #include <optional>
 
 #include "crab/add_bottom.hpp"
@@ -36,6 +37,32 @@ using NumAbsDomain = AddBottom;
 
 void clear_thread_local_state();
 
+/// Array cells of a verifier context while another one is bound to the thread.
+struct array_map_state_t;
+
+std::shared_ptr<array_map_state_t> make_array_map_state();
+
+/// Exchange the array cells of the calling thread with those of a verifier context.
+void swap_thread_local_state(array_map_state_t& state);
+
+/// Array cells of one thread, made accessible to other threads.
+struct shared_array_map_t;
+
+/**
+ * @brief Share the calling thread's array cells with other threads.
+ * Until sharing stops, every array operation of the calling thread takes a lock.
+ *
+ * @return A handle to pass to use_shared_array_map() on the other threads.
+ */
+std::shared_ptr<shared_array_map_t> share_array_map();
+
+/**
+ * @brief Make the calling thread use shared array cells, or its own cells again if shared is null.
+ *
+ * @param[in] shared A handle obtained from share_array_map(), or nullptr.
+ */
+void use_shared_array_map(std::shared_ptr<shared_array_map_t> shared);
+
 class array_domain_t final {
     bitset_domain_t num_bytes;
 
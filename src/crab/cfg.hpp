@@ -6,13 +6,17 @@
  * a CFG to interface with the fixpoint iterators.
  */
 #include <cassert>
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <ranges>
 #include <set>
+#include <span>
 #include <variant>
 #include <vector>
 
+#include <gsl/narrow>
+
 #include "config.hpp"
 #include "crab/label.hpp"
 #include "crab_utils/debug.hpp"
@@ -141,6 +145,70 @@ class cfg_t final {
     }
 };
 
+/// Dense id of a label in a frozen_cfg_t.
+using node_id_t = uint32_t;
+
+/// Immutable copy of a cfg_t for the analysis. Labels are numbered densely, in label order, and the edges are stored
+/// in compressed sparse row arrays, so that walking the graph by node id neither compares labels nor looks them up.
+/// The labels themselves are kept in a side table, only needed to go back from a node to its label.
+class frozen_cfg_t final {
+    /// Label of each node.
+    std::vector<label_t> _labels;
+    node_id_t _entry{};
+    node_id_t _exit{};
+
+    /// The parents of node i are _parents[_parent_offsets[i]] to _parents[_parent_offsets[i + 1] - 1], in label
+    /// order, and likewise for the children.
+    std::vector<uint32_t> _parent_offsets;
+    std::vector<node_id_t> _parents;
+    std::vector<uint32_t> _child_offsets;
+    std::vector<node_id_t> _children;
+
+  public:
+    frozen_cfg_t() = default;
+    explicit frozen_cfg_t(const cfg_t& cfg);
+
+    [[nodiscard]]
+    size_t size() const {
+        return _labels.size();
+    }
+
+    [[nodiscard]]
+    node_id_t entry() const {
+        return _entry;
+    }
+
+    [[nodiscard]]
+    node_id_t exit() const {
+        return _exit;
+    }
+
+    [[nodiscard]]
+    const label_t& label(const node_id_t node) const {
+        return _labels.at(node);
+    }
+
+    /// The node of a label, found by binary search.
+    [[nodiscard]]
+    node_id_t node(const label_t& label) const {
+        const auto it = std::ranges::lower_bound(_labels, label);
+        if (it == _labels.end() || *it != label) {
+            CRAB_ERROR("Label ", to_string(label), " not found in the CFG: ");
+        }
+        return gsl::narrow<node_id_t>(it - _labels.begin());
+    }
+
+    [[nodiscard]]
+    std::span<const node_id_t> parents_of(const node_id_t node) const {
+        return {_parents.data() + _parent_offsets[node], _parents.data() + _parent_offsets[node + 1]};
+    }
+
+    [[nodiscard]]
+    std::span<const node_id_t> children_of(const node_id_t node) const {
+        return {_children.data() + _child_offsets[node], _children.data() + _child_offsets[node + 1]};
+    }
+};
+
 class basic_block_t final {
     using stmt_list_t = std::vector<label_t>;
     using const_iterator = stmt_list_t::const_iterator;
@@ -152,6 +220,11 @@ class basic_block_t final {
 
     static std::set<basic_block_t> collect_basic_blocks(const cfg_t& cfg, bool simplify);
 
+    /// Partition all the labels of the cfg into maximal chains, by first label. Every label of a chain except the
+    /// first is the only child of the previous one, which is its only parent. The exit label always starts a chain,
+    /// and the labels in chain_ends always end one.
+    static std::map<label_t, basic_block_t> collect_chains(const cfg_t& cfg, const std::set<label_t>& chain_ends = {});
+
     explicit basic_block_t(const label_t& first_label) : m_ts{first_label} {}
     basic_block_t(basic_block_t&&) noexcept = default;
     basic_block_t(const basic_block_t&) = default;
@@ -6,6 +6,7 @@
 #include <optional>
 
 #include "crab/array_domain.hpp"
+#include "crab/liveness.hpp"
 #include "crab/split_dbm.hpp"
 #include "crab/type_domain.hpp"
 #include "crab/variable.hpp"
@@ -31,6 +32,17 @@ std::vector<std::string> ebpf_domain_check(const ebpf_domain_t& dom, const Asser
 // TODO: make this an explicit instruction
 void ebpf_domain_initialize_loop_counter(ebpf_domain_t& dom, const label_t& label);
 
+/// Forget the parts of the state at the entry of a subprogram that it must not read: r6-r9, the registers of the
+/// callers saved in their stack frames, and the counters of the loops other than the given loops of the subprogram.
+void ebpf_domain_project_call_entry(ebpf_domain_t& dom, const std::vector<label_t>& loop_heads);
+
+/// Forget the parts of the state of a caller that a local call may change: r0-r5, the stack, and the counters of the
+/// given loops of the subprogram.
+void ebpf_domain_forget_call_effects(ebpf_domain_t& dom, const std::vector<label_t>& loop_heads);
+
+/// Forget the registers r0-r9 and the bytes of the stack that are not live.
+void ebpf_domain_forget_dead(ebpf_domain_t& dom, const live_variables_t& live);
+
 class ebpf_domain_t final {
     friend class ebpf_checker;
     friend class ebpf_transformer;
@@ -65,6 +77,15 @@ class ebpf_domain_t final {
     static ebpf_domain_t calculate_constant_limits();
     extended_number get_loop_count_upper_bound() const;
     interval_t get_r0() const;
+    /// Number of vertices and of edges of the graph of the numerical domain.
+    std::pair<std::size_t, std::size_t> numeric_size() const { return m_inv.size(); }
+    /// Keep the bounds of each numerical variable, and at most max_per_variable of its relations with other variables
+    /// and max_total relations in all, where a limit without a value is no limit. Return whether any relation was
+    /// forgotten.
+    bool limit_relations(const std::optional<std::size_t> max_per_variable,
+                         const std::optional<std::size_t> max_total) {
+        return m_inv.limit_relations(max_per_variable, max_total);
+    }
 
     static ebpf_domain_t setup_entry(bool init_r1);
     static ebpf_domain_t from_constraints(const std::set<std::string>& constraints, bool setup_constraints);
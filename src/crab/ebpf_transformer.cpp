@@ -3,6 +3,7 @@
 
 // This file is eBPF-specific, not derived from CRAB.
 
+#include <algorithm>
 #include <bitset>
 #include <optional>
 #include <utility>
@@ -51,6 +52,9 @@ class ebpf_transformer final {
     void operator()(const Undefined&);
 
     void initialize_loop_counter(const label_t& label);
+    void project_call_entry(const std::vector<label_t>& loop_heads);
+    void forget_call_effects(const std::vector<label_t>& loop_heads);
+    void forget_dead(const live_variables_t& live);
 
   private:
     /// Forget everything about all offset variables for a given register.
@@ -1453,8 +1457,96 @@ void ebpf_transformer::operator()(const IncrementLoopCounter& ins) {
     m_inv->add(counter, 1);
 }
 
+void ebpf_transformer::project_call_entry(const std::vector<label_t>& loop_heads) {
+    for (int i = R6; i <= R9; i++) {
+        const Reg reg{gsl::narrow<uint8_t>(i)};
+        havoc_register(m_inv, reg);
+        type_inv.havoc_type(m_inv, reg);
+    }
+    for (const variable_t type_variable : variable_t::get_type_variables()) {
+        if (type_variable.is_stack_frame_var()) {
+            for (const data_kind_t kind : iterate_kinds()) {
+                m_inv.havoc(variable_t::kind_var(kind, type_variable));
+            }
+        }
+    }
+    std::vector<variable_t> kept_counters;
+    for (const label_t& label : loop_heads) {
+        kept_counters.push_back(variable_t::loop_counter(to_string(label)));
+    }
+    for (const variable_t counter : variable_t::get_loop_counters()) {
+        if (std::ranges::find(kept_counters, counter) == kept_counters.end()) {
+            m_inv.havoc(counter);
+        }
+    }
+}
+
+void ebpf_transformer::forget_call_effects(const std::vector<label_t>& loop_heads) {
+    for (int i = R0_RETURN_VALUE; i <= R5_ARG; i++) {
+        const Reg reg{gsl::narrow<uint8_t>(i)};
+        havoc_register(m_inv, reg);
+        type_inv.havoc_type(m_inv, reg);
+    }
+    for (const data_kind_t kind : iterate_kinds()) {
+        stack.havoc(m_inv, kind, 0, EBPF_TOTAL_STACK_SIZE);
+    }
+    // The number of numeric bytes a stack pointer points to depends on the stack.
+    for (const variable_t type_variable : variable_t::get_type_variables()) {
+        m_inv.havoc(variable_t::kind_var(data_kind_t::stack_numeric_sizes, type_variable));
+    }
+    for (const label_t& label : loop_heads) {
+        m_inv.havoc(variable_t::loop_counter(to_string(label)));
+    }
+}
+
+void ebpf_transformer::forget_dead(const live_variables_t& live) {
+    for (int i = R0_RETURN_VALUE; i <= R9; i++) {
+        if (!live.registers[i]) {
+            const Reg reg{gsl::narrow<uint8_t>(i)};
+            havoc_register(m_inv, reg);
+            type_inv.havoc_type(m_inv, reg);
+        }
+    }
+    // Forget each run of dead bytes at once.
+    for (int start = 0; start < EBPF_TOTAL_STACK_SIZE;) {
+        if (live.stack[start]) {
+            start++;
+            continue;
+        }
+        int end = start + 1;
+        while (end < EBPF_TOTAL_STACK_SIZE && !live.stack[end]) {
+            end++;
+        }
+        for (const data_kind_t kind : iterate_kinds()) {
+            stack.havoc(m_inv, kind, start, end - start);
+        }
+        start = end;
+    }
+}
+
 void ebpf_domain_initialize_loop_counter(ebpf_domain_t& dom, const label_t& label) {
     ebpf_transformer{dom}.initialize_loop_counter(label);
 }
 
+void ebpf_domain_project_call_entry(ebpf_domain_t& dom, const std::vector<label_t>& loop_heads) {
+    if (dom.is_bottom()) {
+        return;
+    }
+    ebpf_transformer{dom}.project_call_entry(loop_heads);
+}
+
+void ebpf_domain_forget_call_effects(ebpf_domain_t& dom, const std::vector<label_t>& loop_heads) {
+    if (dom.is_bottom()) {
+        return;
+    }
+    ebpf_transformer{dom}.forget_call_effects(loop_heads);
+}
+
+void ebpf_domain_forget_dead(ebpf_domain_t& dom, const live_variables_t& live) {
+    if (dom.is_bottom()) {
+        return;
+    }
+    ebpf_transformer{dom}.forget_dead(live);
+}
+
 } // namespace crab
@@ -4,6 +4,7 @@
 #include <utility>
 
 #include "asm_syntax.hpp" // for Condition::Op
+#include "config.hpp"
 #include "crab/dsl_syntax.hpp"
 #include "crab/finite_domain.hpp"
 #include "crab/interval.hpp"
@@ -14,7 +15,21 @@
 
 namespace crab::domains {
 
-using NumAbsDomain = SplitDBM;
+static std::variant<SplitDBM, IntervalDomain> top_of_numeric_domain() {
+    if (thread_local_options.numeric_domain == numeric_domain_t::interval) {
+        return IntervalDomain::top();
+    }
+    return SplitDBM::top();
+}
+
+FiniteDomain::FiniteDomain() : dom{top_of_numeric_domain()} {}
+
+IntervalDomain FiniteDomain::intervals() const {
+    if (const auto bounds = std::get_if<IntervalDomain>(&dom)) {
+        return *bounds;
+    }
+    return IntervalDomain{std::get<SplitDBM>(dom)};
+}
 
 std::vector<linear_constraint_t> FiniteDomain::assume_bit_cst_interval(Condition::Op op, bool is64,
                                                                        interval_t dst_interval,
@@ -675,29 +690,35 @@ std::vector<linear_constraint_t> FiniteDomain::assume_cst_reg(const Condition::O
     throw std::exception();
 }
 
-void FiniteDomain::assign(variable_t x, const std::optional<linear_expression_t>& e) { dom.assign(x, e); }
-void FiniteDomain::assign(const variable_t x, const variable_t e) { dom.assign(x, e); }
-void FiniteDomain::assign(const variable_t x, const linear_expression_t& e) { dom.assign(x, e); }
-void FiniteDomain::assign(const variable_t x, const int64_t e) { dom.set(x, interval_t(e)); }
+void FiniteDomain::assign(variable_t x, const std::optional<linear_expression_t>& e) {
+    visit([&](auto& d) { d.assign(x, e); });
+}
+void FiniteDomain::assign(const variable_t x, const variable_t e) {
+    visit([&](auto& d) { d.assign(x, e); });
+}
+void FiniteDomain::assign(const variable_t x, const linear_expression_t& e) {
+    visit([&](auto& d) { d.assign(x, e); });
+}
+void FiniteDomain::assign(const variable_t x, const int64_t e) { set(x, interval_t(e)); }
 
 void FiniteDomain::apply(const arith_binop_t op, const variable_t x, const variable_t y, const number_t& z,
                          const int finite_width) {
-    dom.apply(op, x, y, z, finite_width);
+    visit([&](auto& d) { d.apply(op, x, y, z, finite_width); });
 }
 
 void FiniteDomain::apply(const arith_binop_t op, const variable_t x, const variable_t y, const variable_t z,
                          const int finite_width) {
-    dom.apply(op, x, y, z, finite_width);
+    visit([&](auto& d) { d.apply(op, x, y, z, finite_width); });
 }
 
 void FiniteDomain::apply(const bitwise_binop_t op, const variable_t x, const variable_t y, const variable_t z,
                          const int finite_width) {
-    dom.apply(op, x, y, z, finite_width);
+    visit([&](auto& d) { d.apply(op, x, y, z, finite_width); });
 }
 
 void FiniteDomain::apply(const bitwise_binop_t op, const variable_t x, const variable_t y, const number_t& k,
                          const int finite_width) {
-    dom.apply(op, x, y, k, finite_width);
+    visit([&](auto& d) { d.apply(op, x, y, k, finite_width); });
 }
 
 void FiniteDomain::apply(binop_t op, variable_t x, variable_t y, const number_t& z, int finite_width) {
@@ -741,7 +762,7 @@ void FiniteDomain::overflow_bounds(variable_t lhs, int finite_width, bool issign
     auto new_interval = interval_t{lb, ub};
     if (new_interval != interval) {
         // Update the variable, which will lose any relationships to other variables.
-        dom.set(lhs, new_interval);
+        set(lhs, new_interval);
     }
 }
 
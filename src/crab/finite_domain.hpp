@@ -8,6 +8,7 @@
 
 #include "asm_syntax.hpp" // for Condition::Op
 #include "crab/interval.hpp"
+#include "crab/interval_domain.hpp"
 #include "crab/linear_constraint.hpp"
 #include "crab/split_dbm.hpp"
 #include "crab/thresholds.hpp"
@@ -16,12 +17,40 @@
 
 namespace crab::domains {
 class FiniteDomain {
-    SplitDBM dom;
+    // The relational domain, or the bounds alone when the numeric domain is interval.
+    std::variant<SplitDBM, IntervalDomain> dom;
 
-    explicit FiniteDomain(const SplitDBM& dom) : dom{dom} {}
+    explicit FiniteDomain(SplitDBM&& dom) : dom{std::move(dom)} {}
+    explicit FiniteDomain(IntervalDomain&& dom) : dom{std::move(dom)} {}
+
+    // The bounds of this domain, without its relations.
+    [[nodiscard]]
+    IntervalDomain intervals() const;
+
+    // Apply f to the domains of this and o, or to their bounds when only one of them keeps relations. That happens when
+    // an invariant of the interval tier meets one of a relational analysis.
+    template <typename F>
+    auto binary(const FiniteDomain& o, F&& f) const {
+        if (dom.index() != o.dom.index()) {
+            return f(intervals(), o.intervals());
+        }
+        return std::visit([&](const auto& left) { return f(left, std::get<std::decay_t<decltype(left)>>(o.dom)); },
+                          dom);
+    }
+
+    template <typename F>
+    decltype(auto) visit(F&& f) const {
+        return std::visit(std::forward<F>(f), dom);
+    }
+
+    template <typename F>
+    decltype(auto) visit(F&& f) {
+        return std::visit(std::forward<F>(f), dom);
+    }
 
   public:
-    explicit FiniteDomain() = default;
+    /// Top, in the numeric domain that thread_local_options chooses.
+    explicit FiniteDomain();
 
     FiniteDomain(const FiniteDomain& o) = default;
     FiniteDomain(FiniteDomain&& o) = default;
@@ -29,32 +58,59 @@ class FiniteDomain {
     FiniteDomain& operator=(const FiniteDomain& o) = default;
     FiniteDomain& operator=(FiniteDomain&& o) = default;
 
-    void set_to_top() { dom.set_to_top(); }
+    void set_to_top() {
+        visit([](auto& d) { d.set_to_top(); });
+    }
 
     static FiniteDomain top() { return FiniteDomain(); }
 
     [[nodiscard]]
     bool is_top() const {
-        return dom.is_top();
+        return visit([](const auto& d) { return d.is_top(); });
     }
 
-    bool operator<=(const FiniteDomain& o) const { return dom <= o.dom; }
+    bool operator<=(const FiniteDomain& o) const {
+        return binary(o, [](const auto& left, const auto& right) { return left <= right; });
+    }
 
     // FIXME: can be done more efficient
     void operator|=(const FiniteDomain& o) { *this = *this | o; }
     void operator|=(FiniteDomain&& o) { *this = *this | std::move(o); }
 
-    FiniteDomain operator|(const FiniteDomain& o) const& { return FiniteDomain{dom | o.dom}; }
+    FiniteDomain operator|(const FiniteDomain& o) const& {
+        return binary(o, [](const auto& left, const auto& right) { return FiniteDomain{left | right}; });
+    }
 
-    FiniteDomain operator|(FiniteDomain&& o) && { return FiniteDomain{std::move(dom) | std::move(o.dom)}; }
+    FiniteDomain operator|(FiniteDomain&& o) && {
+        if (const auto left = std::get_if<SplitDBM>(&dom)) {
+            if (const auto right = std::get_if<SplitDBM>(&o.dom)) {
+                return FiniteDomain{std::move(*left) | std::move(*right)};
+            }
+        }
+        return *this | o;
+    }
 
-    FiniteDomain operator|(const FiniteDomain& o) && { return FiniteDomain{std::move(dom) | o.dom}; }
+    FiniteDomain operator|(const FiniteDomain& o) && {
+        if (const auto left = std::get_if<SplitDBM>(&dom)) {
+            if (const auto right = std::get_if<SplitDBM>(&o.dom)) {
+                return FiniteDomain{std::move(*left) | *right};
+            }
+        }
+        return *this | o;
+    }
 
-    FiniteDomain operator|(FiniteDomain&& o) const& { return FiniteDomain{dom | std::move(o.dom)}; }
+    FiniteDomain operator|(FiniteDomain&& o) const& {
+        if (const auto left = std::get_if<SplitDBM>(&dom)) {
+            if (const auto right = std::get_if<SplitDBM>(&o.dom)) {
+                return FiniteDomain{*left | std::move(*right)};
+            }
+        }
+        return *this | o;
+    }
 
     [[nodiscard]]
     FiniteDomain widen(const FiniteDomain& o) const {
-        return FiniteDomain{dom.widen(o.dom)};
+        return binary(o, [](const auto& left, const auto& right) { return FiniteDomain{left.widen(right)}; });
     }
 
     [[nodiscard]]
@@ -64,20 +120,26 @@ class FiniteDomain {
     }
 
     std::optional<FiniteDomain> meet(const FiniteDomain& o) const {
-        const auto res = dom.meet(o.dom);
-        if (!res) {
-            return {};
-        }
-        return FiniteDomain{*res};
+        return binary(o, [](const auto& left, const auto& right) -> std::optional<FiniteDomain> {
+            auto res = left.meet(right);
+            if (!res) {
+                return {};
+            }
+            return FiniteDomain{std::move(*res)};
+        });
     }
 
     [[nodiscard]]
     FiniteDomain narrow(const FiniteDomain& o) const {
-        return FiniteDomain{dom.narrow(o.dom)};
+        return binary(o, [](const auto& left, const auto& right) { return FiniteDomain{left.narrow(right)}; });
     }
 
-    interval_t eval_interval(const variable_t& v) const { return dom.eval_interval(v); }
-    interval_t eval_interval(const linear_expression_t& exp) const { return dom.eval_interval(exp); }
+    interval_t eval_interval(const variable_t& v) const {
+        return visit([&](const auto& d) { return d.eval_interval(v); });
+    }
+    interval_t eval_interval(const linear_expression_t& exp) const {
+        return visit([&](const auto& d) { return d.eval_interval(exp); });
+    }
 
     void assign(variable_t x, const std::optional<linear_expression_t>& e);
     void assign(variable_t x, variable_t e);
@@ -136,35 +198,50 @@ class FiniteDomain {
     void sign_extend(variable_t svalue, variable_t uvalue, const linear_expression_t& right_svalue, int target_width,
                      int source_width);
 
-    bool add_constraint(const linear_constraint_t& cst) { return dom.add_constraint(cst); }
+    bool add_constraint(const linear_constraint_t& cst) {
+        return visit([&](auto& d) { return d.add_constraint(cst); });
+    }
 
-    void set(const variable_t x, const interval_t& intv) { dom.set(x, intv); }
+    void set(const variable_t x, const interval_t& intv) {
+        visit([&](auto& d) { d.set(x, intv); });
+    }
 
     /// Forget everything we know about the value of a variable.
-    void havoc(variable_t v) { dom.havoc(v); }
+    void havoc(variable_t v) {
+        visit([&](auto& d) { d.havoc(v); });
+    }
+
+    /// Keep the bounds of each variable, and at most max_per_variable of its differences with other variables and
+    /// max_total differences in all. A limit without a value is no limit.
+    bool limit_relations(const std::optional<std::size_t> max_per_variable,
+                         const std::optional<std::size_t> max_total) {
+        return visit([&](auto& d) { return d.limit_relations(max_per_variable, max_total); });
+    }
 
     [[nodiscard]]
     std::pair<std::size_t, std::size_t> size() const {
-        return dom.size();
+        return visit([](const auto& d) { return d.size(); });
     }
 
     // Return true if inv intersects with cst.
     [[nodiscard]]
     bool intersect(const linear_constraint_t& cst) const {
-        return dom.intersect(cst);
+        return visit([&](const auto& d) { return d.intersect(cst); });
     }
 
     // Return true if entails rhs.
     [[nodiscard]]
     bool entail(const linear_constraint_t& rhs) const {
-        return dom.entail(rhs);
+        return visit([&](const auto& d) { return d.entail(rhs); });
     }
 
-    friend std::ostream& operator<<(std::ostream& o, const FiniteDomain& dom) { return o << dom.dom; }
+    friend std::ostream& operator<<(std::ostream& o, const FiniteDomain& dom) {
+        return dom.visit([&](const auto& d) -> std::ostream& { return o << d; });
+    }
 
     [[nodiscard]]
     string_invariant to_set() const {
-        return dom.to_set();
+        return visit([](const auto& d) { return d.to_set(); });
     }
 
     static void clear_thread_local_state() { SplitDBM::clear_thread_local_state(); }
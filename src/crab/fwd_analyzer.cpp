@@ -1,22 +1,251 @@
 // Copyright (c) Prevail Verifier contributors.
 // SPDX-License-Identifier: Apache-2.0
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <set>
+#include <span>
 #include <utility>
 #include <variant>
+#include <vector>
+
+#include <gsl/narrow>
 
 #include "config.hpp"
+#include "crab/array_domain.hpp"
 #include "crab/cfg.hpp"
 #include "crab/ebpf_domain.hpp"
 #include "crab/fwd_analyzer.hpp"
+#include "crab/liveness.hpp"
 #include "crab/wto.hpp"
+#include "crab_utils/work_stealing_pool.hpp"
 #include "program.hpp"
+#include "spec_type_descriptors.hpp"
 
 namespace crab {
 
+// A sequence of WTO components (the top level, or the body of a cycle) together with the
+// dependencies between them: component j precedes component i if some node of j is a parent of some node of i.
+// Components that do not depend on each other, such as the two arms of a diamond, may be analyzed concurrently.
+struct component_dag_t {
+    std::vector<const cycle_or_label*> components;
+    std::vector<std::vector<size_t>> successors;
+};
+
+/// Marks a node that is not in any of the components looked at.
+constexpr size_t NOT_A_MEMBER = std::numeric_limits<size_t>::max();
+
+/// Call f with each node of a component, in weak topological order.
+static void for_each_component_node(const cycle_or_label& component, const auto& f) {
+    if (const auto pnode = std::get_if<node_id_t>(&component)) {
+        f(*pnode);
+    } else {
+        for (const auto& sub_component : *std::get<std::shared_ptr<wto_cycle_t>>(component)) {
+            for_each_component_node(sub_component, f);
+        }
+    }
+}
+
+/// Set the component index of each node of a component, in a table by node id.
+static void collect_component_nodes(const cycle_or_label& component, const size_t index,
+                                    std::vector<size_t>& component_of) {
+    for_each_component_node(component, [&](const node_id_t node) { component_of[node] = index; });
+}
+
+static component_dag_t make_component_dag(const frozen_cfg_t& cfg, std::vector<const cycle_or_label*> components) {
+    std::vector<size_t> component_of(cfg.size(), NOT_A_MEMBER);
+    for (size_t i = 0; i < components.size(); i++) {
+        collect_component_nodes(*components[i], i, component_of);
+    }
+    std::vector<std::set<size_t>> successors(components.size());
+    for (node_id_t node = 0; node < cfg.size(); node++) {
+        const size_t i = component_of[node];
+        if (i == NOT_A_MEMBER) {
+            continue;
+        }
+        for (const node_id_t prev : cfg.parents_of(node)) {
+            // Parents outside of this sequence (e.g., the head of the cycle) are computed before the sequence starts.
+            // Edges from a later component to an earlier one can only target the head of an enclosing cycle.
+            if (const size_t j = component_of[prev]; j != NOT_A_MEMBER && j < i) {
+                successors[j].insert(i);
+            }
+        }
+    }
+    component_dag_t res{.components = std::move(components)};
+    for (const auto& succs : successors) {
+        res.successors.emplace_back(succs.begin(), succs.end());
+    }
+    return res;
+}
+
+// The graph of the chains of a cfg, in which each chain stands for its first label.
+static cfg_t make_chain_cfg(const cfg_t& cfg, const std::map<label_t, basic_block_t>& chains) {
+    std::map<label_t, std::vector<label_t>> adj_list;
+    for (const auto& [first, bb] : chains) {
+        const auto& children = cfg.children_of(bb.last_label());
+        adj_list.emplace(first, std::vector<label_t>(children.begin(), children.end()));
+    }
+    return cfg_from_adjacency_list(adj_list);
+}
+
+/// The labels of a cfg that call a subprogram.
+static std::set<label_t> local_calls(const Program& prog, const cfg_t& cfg) {
+    std::set<label_t> res;
+    for (const label_t& label : cfg.labels()) {
+        if (std::holds_alternative<CallLocal>(prog.instruction_at(label))) {
+            res.insert(label);
+        }
+    }
+    return res;
+}
+
+/// A label, with its instruction and the assertions before it, looked up in the program once for all transfers over it.
+struct transfer_t {
+    const label_t& label;
+    const Instruction& instruction;
+    const std::vector<Assertion>& assertions;
+
+    transfer_t(const Program& prog, const label_t& label)
+        : label(label), instruction(prog.instruction_at(label)), assertions(prog.assertions_at(label)) {}
+};
+
+/// Throw the first assertion_failure_t found in a sequence of transfers, given the invariant before the first one.
+static void check_assertions(const std::span<const transfer_t> transfers, ebpf_domain_t pre) {
+    for (const transfer_t& transfer : transfers) {
+        if (pre.is_bottom()) {
+            break;
+        }
+        for (const Assertion& assertion : transfer.assertions) {
+            const auto warnings = ebpf_domain_check(pre, assertion);
+            if (!warnings.empty()) {
+                throw assertion_failure_t{.label = transfer.label, .message = warnings.front()};
+            }
+        }
+        if (&transfer != &transfers.back()) {
+            apply_transformer(transfer.instruction, transfer.assertions, pre);
+        }
+    }
+}
+
+/// Throw the first assertion_failure_t found in the result of an analysis.
+static void check_assertions(const Program& prog, const analysis_result_t& result) {
+    for (const auto& [node, inv] : result.invariants) {
+        std::vector<transfer_t> transfers;
+        if (const auto it = result.chains.find(node); it != result.chains.end()) {
+            for (const label_t& label : it->second) {
+                transfers.emplace_back(prog, label);
+            }
+        } else {
+            transfers.emplace_back(prog, node);
+        }
+        check_assertions(transfers, inv.pre);
+    }
+}
+
+class call_summaries_t;
+
+/// A subprogram analyzed from a given state at its entry.
+struct call_context_t {
+    /// The state at the entry of the subprogram.
+    ebpf_domain_t entry;
+    /// The state on returning from the subprogram.
+    ebpf_domain_t exit;
+    analysis_result_t result;
+    /// The context each local call of the subprogram was last analyzed in, by label of the call.
+    std::map<label_t, const call_context_t*> calls;
+};
+
+/// The contexts that some calls were analyzed in, followed by those that the calls of these were analyzed in, etc.
+static std::vector<const call_context_t*> reachable_contexts(const std::map<label_t, const call_context_t*>& calls) {
+    std::vector<const call_context_t*> res;
+    std::set<const call_context_t*> seen;
+    const auto add_contexts = [&](const std::map<label_t, const call_context_t*>& more_calls) {
+        for (const call_context_t* context : std::views::values(more_calls)) {
+            if (context && seen.insert(context).second) {
+                res.push_back(context);
+            }
+        }
+    };
+    add_contexts(calls);
+    for (size_t i = 0; i < res.size(); i++) {
+        add_contexts(res[i]->calls);
+    }
+    return res;
+}
+
 class interleaved_fwd_fixpoint_iterator_t final {
+    friend class call_summaries_t;
+
     const Program& _prog;
-    const cfg_t& _cfg;
+
+    /// When invariants are compact, the chain of labels of each node of the graph below, by first label.
+    /// The analysis then goes over the chains rather than over single labels: the pre of a node is the pre of
+    /// the first label of its chain, and its post is the post of the last label.
+    std::map<label_t, basic_block_t> _chains;
+    const std::optional<cfg_t> _chain_cfg;
+
     const wto_t _wto;
-    invariant_table_t _inv;
+    /// The graph analyzed, frozen by the WTO. Everything below is indexed by its node ids.
+    const frozen_cfg_t& _cfg;
+
+    /// Invariants of each node.
+    std::vector<invariant_map_pair> _inv;
+
+    /// The transfers of all the nodes, those of each node in a row. Their labels are in _chains or _cfg.
+    std::vector<transfer_t> _transfers;
+
+    /// The transfers that take the pre of each node to its post, in _transfers.
+    std::vector<std::span<const transfer_t>> _transfers_of;
+
+    /// When dead variables are pruned, what is live after each node whose post flows into a join. Empty otherwise.
+    std::vector<std::optional<live_variables_t>> _live_after;
+
+    /// Pool used to analyze independent components concurrently, or null to analyze them in WTO order.
+    work_stealing_pool_t* _pool{};
+
+    /// Dependency DAG of the body of each cycle, excluding its head. Only used with a pool.
+    std::map<const wto_cycle_t*, component_dag_t> _cycle_dags;
+
+    // Change tracking. Every time the post of a node actually changes, it is stamped with a new value of _clock.
+    // A node (or a whole cycle) is also stamped when it is computed, so that it can be skipped when it is
+    // visited again and none of the posts it reads changed since: its transformer would produce the same post again.
+    // This only holds if transformers are functions of their pre, so they must not read global state that can
+    // change between iterations, such as the names that the variable factory hands out; debug builds check it.
+    // A stamp of 0 means never.
+    std::atomic<uint64_t> _clock{0};
+
+    struct label_stamps_t {
+        uint64_t changed{};
+        uint64_t computed{};
+    };
+    std::vector<label_stamps_t> _stamps;
+
+    struct cycle_info_t {
+        /// Parents of nodes of the cycle that are outside of the cycle, i.e., the inputs of the cycle.
+        std::vector<node_id_t> external_parents;
+        /// Number of labels in the cycle, including nested cycles.
+        unsigned size{};
+        uint64_t computed{};
+    };
+    std::map<const wto_cycle_t*, cycle_info_t> _cycles;
+
+    struct loop_counters_t {
+        std::atomic<unsigned> transfers{};
+        std::atomic<unsigned> skipped_transfers{};
+    };
+    /// Counters of each loop, by head.
+    std::map<node_id_t, loop_counters_t> _loop_counters;
+    /// Counters of the innermost loop containing each node, or null if the node is not in a loop.
+    std::vector<loop_counters_t*> _innermost_loop;
+    /// Number of transformers after which the numerical domain was over its budget.
+    std::atomic<unsigned> _over_budget{};
 
     /// number of narrowing iterations. If the narrowing operator is
     /// indeed a narrowing operator this parameter is not
@@ -28,53 +257,386 @@ class interleaved_fwd_fixpoint_iterator_t final {
     /// Used to skip the analysis until _entry is found
     bool _skip{true};
 
-    void set_pre(const label_t& label, const ebpf_domain_t& v) { _inv.at(label).pre = v; }
+    /// Whether to check the assertions of each label once its invariants are final, and stop at the first failure.
+    const bool _check_assertions;
+
+    /// Summaries of the subprograms when local calls are not inlined, null otherwise.
+    call_summaries_t* const _summaries;
+
+    /// The context each local call was last analyzed in, by label of the call. Once the analysis is over,
+    /// these are the contexts of the final invariants.
+    std::map<label_t, const call_context_t*> _calls;
+
+    /// Number of threads to analyze with.
+    const int _threads;
+
+    void set_pre(const node_id_t node, const ebpf_domain_t& v) { _inv[node].pre = v; }
 
-    ebpf_domain_t get_pre(const label_t& node) const { return _inv.at(node).pre; }
+    ebpf_domain_t get_pre(const node_id_t node) const { return _inv[node].pre; }
 
-    ebpf_domain_t get_post(const label_t& node) const { return _inv.at(node).post; }
+    ebpf_domain_t get_post(const node_id_t node) const { return _inv[node].post; }
 
-    void transform_to_post(const label_t& label, ebpf_domain_t pre) {
-        if (thread_local_options.assume_assertions) {
-            for (const auto& assertion : _prog.assertions_at(label)) {
-                // avoid redundant errors
-                ebpf_domain_assume(pre, assertion);
+    /// Apply the transformer of a label, or the summary of the subprogram it calls.
+    /// @return Whether the numerical domain went over its budget.
+    bool transform(const transfer_t& transfer, ebpf_domain_t& inv);
+
+    /// Apply the transformers of the labels of a node to inv, and forget what is dead after them.
+    void transform_node(const node_id_t node, ebpf_domain_t& inv) {
+        for (const transfer_t& transfer : _transfers_of[node]) {
+            if (transform(transfer, inv)) {
+                ++_over_budget;
             }
         }
-        ebpf_domain_transform(pre, _prog.instruction_at(label));
+        if (!_live_after.empty() && _live_after[node]) {
+            ebpf_domain_forget_dead(inv, *_live_after[node]);
+        }
+    }
 
-        _inv.at(label).post = std::move(pre);
+    /// Compute the post of a node, and stamp it if it changed.
+    void transform_to_post(const node_id_t node, ebpf_domain_t pre) {
+        if (thread_local_options.deadline && std::chrono::steady_clock::now() >= *thread_local_options.deadline) {
+            throw AnalysisTimeout("the analysis did not end before its deadline");
+        }
+        transform_node(node, pre);
+        if (loop_counters_t* counters = _innermost_loop[node]) {
+            counters->transfers += gsl::narrow<unsigned>(_transfers_of[node].size());
+        }
+        ebpf_domain_t& post = _inv[node].post;
+        // Numerical domains of different sizes are taken to differ without comparing them. That may stamp a post
+        // that did not change, which only costs a transfer that could have been skipped.
+        if (pre.numeric_size() != post.numeric_size() || !(pre == post)) {
+            _stamps[node].changed = ++_clock;
+        }
+        post = std::move(pre);
     }
 
-    ebpf_domain_t join_all_prevs(const label_t& node) const {
-        if (node == _cfg.entry_label()) {
+    /// Whether the node was computed before and none of its parents' posts changed since.
+    bool inputs_unchanged(const node_id_t node) const {
+        const uint64_t computed = _stamps[node].computed;
+        if (computed == 0) {
+            return false;
+        }
+        return std::ranges::all_of(_cfg.parents_of(node),
+                                   [&](const node_id_t prev) { return _stamps[prev].changed <= computed; });
+    }
+
+    ebpf_domain_t join_all_prevs(const node_id_t node) const {
+        if (node == _cfg.entry()) {
             return get_pre(node);
         }
         ebpf_domain_t res = ebpf_domain_t::bottom();
-        for (const label_t& prev : _cfg.parents_of(node)) {
+        for (const node_id_t prev : _cfg.parents_of(node)) {
             res |= get_post(prev);
         }
         return res;
     }
 
-    explicit interleaved_fwd_fixpoint_iterator_t(const Program& prog)
-        : _prog(prog), _cfg(prog.cfg()), _wto(prog.cfg()) {
-        for (const auto& label : _cfg.labels()) {
-            _inv.emplace(label, invariant_map_pair{ebpf_domain_t::bottom(), ebpf_domain_t::bottom()});
+    /// Analyze a cfg of the program, either the cfg of the program itself or that of a subprogram.
+    interleaved_fwd_fixpoint_iterator_t(const Program& prog, const cfg_t& cfg, const bool check_assertions,
+                                        call_summaries_t* summaries, const int threads)
+        : _prog(prog),
+          // The summary of a call is not replayed along with the rest of a chain, so calls end chains.
+          _chains(thread_local_options.compact_invariants
+                      ? basic_block_t::collect_chains(cfg, summaries ? local_calls(prog, cfg) : std::set<label_t>{})
+                      : std::map<label_t, basic_block_t>{}),
+          _chain_cfg(thread_local_options.compact_invariants ? std::optional{make_chain_cfg(cfg, _chains)}
+                                                             : std::nullopt),
+          _wto(_chain_cfg ? *_chain_cfg : cfg), _cfg(_wto.cfg()),
+          _inv(_cfg.size(), invariant_map_pair{ebpf_domain_t::bottom(), ebpf_domain_t::bottom()}),
+          _stamps(_cfg.size()), _innermost_loop(_cfg.size()), _check_assertions(check_assertions),
+          _summaries(summaries), _threads(threads) {
+        std::vector<size_t> first_transfer_of;
+        for (node_id_t node = 0; node < _cfg.size(); node++) {
+            const label_t& label = _cfg.label(node);
+            first_transfer_of.push_back(_transfers.size());
+            if (const auto it = _chains.find(label); it != _chains.end()) {
+                for (const label_t& chain_label : it->second) {
+                    _transfers.emplace_back(prog, chain_label);
+                }
+            } else {
+                _transfers.emplace_back(prog, label);
+            }
+        }
+        first_transfer_of.push_back(_transfers.size());
+        for (node_id_t node = 0; node < _cfg.size(); node++) {
+            _transfers_of.emplace_back(_transfers.begin() + first_transfer_of[node],
+                                       _transfers.begin() + first_transfer_of[node + 1]);
+        }
+        if (thread_local_options.prune_dead_variables) {
+            const liveness_t liveness(prog, cfg);
+            _live_after.resize(_cfg.size());
+            for (node_id_t node = 0; node < _cfg.size(); node++) {
+                const auto children = _cfg.children_of(node);
+                const auto is_join = [&](const node_id_t child) { return _cfg.parents_of(child).size() > 1; };
+                if (std::ranges::any_of(children, is_join)) {
+                    live_variables_t& live = _live_after[node].emplace();
+                    for (const node_id_t child : children) {
+                        live |= liveness.live_in(_cfg.label(child));
+                    }
+                }
+            }
+        }
+        if (_summaries) {
+            // Filled in beforehand, since the calls of independent components may be analyzed concurrently.
+            for (const label_t& label : local_calls(prog, cfg)) {
+                _calls.emplace(label, nullptr);
+            }
+        }
+        for (const auto& component : _wto) {
+            if (const auto pcycle = std::get_if<std::shared_ptr<wto_cycle_t>>(&component)) {
+                collect_cycle_info(**pcycle);
+            }
         }
     }
 
+    void collect_cycle_info(const wto_cycle_t& cycle);
+
+    loop_statistics_table_t loop_statistics() const;
+
+    analysis_result_t result();
+
+    void prepare_parallel_analysis();
+
+    void run_component_dag(const component_dag_t& dag, bool top_level);
+
+    /// Analyze the whole program.
+    void run();
+
+    void visit_top_level(const cycle_or_label& component);
+
+    /// Throw the first assertion_failure_t found in the component.
+    void check_assertions(const cycle_or_label& component) const;
+
+    void visit_cycle_body(const std::shared_ptr<wto_cycle_t>& cycle);
+
   public:
-    void operator()(const label_t& node);
+    void operator()(node_id_t node);
 
     void operator()(const std::shared_ptr<wto_cycle_t>& cycle);
 
-    friend invariant_table_t run_forward_analyzer(const Program& prog, ebpf_domain_t entry_inv);
+    friend analysis_result_t run_forward_analyzer(const Program& prog, ebpf_domain_t entry_inv,
+                                                  bool check_assertions);
 };
 
-invariant_table_t run_forward_analyzer(const Program& prog, ebpf_domain_t entry_inv) {
+void interleaved_fwd_fixpoint_iterator_t::collect_cycle_info(const wto_cycle_t& cycle) {
+    loop_counters_t& counters = _loop_counters[cycle.head()];
+    for (const auto& component : cycle) {
+        if (const auto pnode = std::get_if<node_id_t>(&component)) {
+            _innermost_loop[*pnode] = &counters;
+        } else {
+            collect_cycle_info(*std::get<std::shared_ptr<wto_cycle_t>>(component));
+        }
+    }
+
+    std::vector<node_id_t> members;
+    for (const auto& component : cycle) {
+        for_each_component_node(component, [&](const node_id_t node) { members.push_back(node); });
+    }
+    std::ranges::sort(members);
+    cycle_info_t& info = _cycles[&cycle];
+    std::set<node_id_t> external_parents;
+    for (const node_id_t node : members) {
+        info.size += gsl::narrow<unsigned>(_transfers_of[node].size());
+        for (const node_id_t prev : _cfg.parents_of(node)) {
+            if (!std::ranges::binary_search(members, prev)) {
+                external_parents.insert(prev);
+            }
+        }
+    }
+    info.external_parents.assign(external_parents.begin(), external_parents.end());
+}
+
+loop_statistics_table_t interleaved_fwd_fixpoint_iterator_t::loop_statistics() const {
+    loop_statistics_table_t res;
+    for (const auto& [head, counters] : _loop_counters) {
+        res.emplace(_cfg.label(head), loop_statistics_t{.transfers = counters.transfers,
+                                                        .skipped_transfers = counters.skipped_transfers});
+    }
+    return res;
+}
+
+analysis_result_t interleaved_fwd_fixpoint_iterator_t::result() {
+    invariant_table_t invariants;
+    for (node_id_t node = 0; node < _cfg.size(); node++) {
+        // Nodes are in label order, so each one goes at the end of the table.
+        invariants.emplace_hint(invariants.end(), _cfg.label(node), std::move(_inv[node]));
+    }
+    return {.invariants = std::move(invariants),
+            .loop_statistics = loop_statistics(),
+            .chains = std::move(_chains),
+            .over_budget_transfers = _over_budget};
+}
+
+/// The results of analyzing the subprograms of a program, by calling context, shared by all their call sites.
+///
+/// A subprogram does not read r6-r9 before writing them, so it is analyzed from the state at its entry without them.
+/// This state only depends on r0-r5, r10 and the stack, so calls with the same arguments share it even when the
+/// callers differ otherwise. The subprogram only changes r0-r5, the stack, and the counters of its loops, so the
+/// state after a call is the state on returning from the subprogram, met with what the caller knows about the rest.
+/// A subprogram that may reallocate the packet also invalidates the packet pointers of the caller, wherever they
+/// are, so such a subprogram is analyzed from the exact state at its entry, and its exit state is used as is.
+class call_summaries_t final {
+    const Program& _prog;
+
+    struct subprogram_t {
+        /// Heads of the loops of the subprogram, and of those of the subprograms it calls.
+        std::vector<label_t> loop_heads;
+        /// Whether the subprogram, or one it calls, may reallocate the packet.
+        bool may_reallocate_packet{};
+        std::vector<std::unique_ptr<const call_context_t>> contexts;
+    };
+    std::map<label_t, subprogram_t> _subprograms;
+
+    /// Protects the contexts of the subprograms, which may be added to by concurrent analyses.
+    std::mutex _mutex;
+
+    void collect_subprogram(const label_t& target);
+
+    call_context_t analyze(const label_t& target, const ebpf_domain_t& entry);
+
+  public:
+    explicit call_summaries_t(const Program& prog) : _prog(prog) {
+        for (const label_t& target : std::views::keys(prog.subprograms())) {
+            collect_subprogram(target);
+        }
+    }
+
+    /// Heads of the loops of all the subprograms.
+    std::vector<label_t> loop_heads() const;
+
+    /// Apply a local call to the state before it. The subprogram is analyzed unless it was already analyzed in the
+    /// same context.
+    /// @return The context the subprogram was analyzed in, or null if the state before the call is bottom.
+    const call_context_t* apply(const CallLocal& call, ebpf_domain_t& inv);
+};
+
+void call_summaries_t::collect_subprogram(const label_t& target) {
+    if (_subprograms.contains(target)) {
+        return;
+    }
+    subprogram_t subprogram;
+    std::set<label_t> loop_heads;
+    for (const label_t& label : _prog.subprograms().at(target).labels()) {
+        const Instruction& ins = _prog.instruction_at(label);
+        if (const auto pcounter = std::get_if<IncrementLoopCounter>(&ins)) {
+            loop_heads.insert(pcounter->name);
+        } else if (const auto pcall = std::get_if<Call>(&ins)) {
+            subprogram.may_reallocate_packet |= pcall->reallocate_packet;
+        } else if (const auto pcall_local = std::get_if<CallLocal>(&ins)) {
+            collect_subprogram(pcall_local->target);
+            const subprogram_t& callee = _subprograms.at(pcall_local->target);
+            loop_heads.insert(callee.loop_heads.begin(), callee.loop_heads.end());
+            subprogram.may_reallocate_packet |= callee.may_reallocate_packet;
+        }
+    }
+    subprogram.loop_heads.assign(loop_heads.begin(), loop_heads.end());
+    _subprograms.emplace(target, std::move(subprogram));
+}
+
+std::vector<label_t> call_summaries_t::loop_heads() const {
+    std::set<label_t> res;
+    for (const subprogram_t& subprogram : std::views::values(_subprograms)) {
+        res.insert(subprogram.loop_heads.begin(), subprogram.loop_heads.end());
+    }
+    return {res.begin(), res.end()};
+}
+
+call_context_t call_summaries_t::analyze(const label_t& target, const ebpf_domain_t& entry) {
+    // The calls of independent components are already analyzed concurrently, so a subprogram is analyzed sequentially.
+    interleaved_fwd_fixpoint_iterator_t analyzer(_prog, _prog.subprograms().at(target), false, this, 1);
+    analyzer.set_pre(analyzer._cfg.entry(), entry);
+    analyzer.run();
+    return {.entry = entry,
+            .exit = analyzer.get_post(analyzer._cfg.exit()),
+            .result = analyzer.result(),
+            .calls = std::move(analyzer._calls)};
+}
+
+const call_context_t* call_summaries_t::apply(const CallLocal& call, ebpf_domain_t& inv) {
+    if (inv.is_bottom()) {
+        return nullptr;
+    }
+    subprogram_t& subprogram = _subprograms.at(call.target);
+    ebpf_domain_t entry = inv;
+    ebpf_domain_transform(entry, call);
+    if (!subprogram.may_reallocate_packet) {
+        ebpf_domain_project_call_entry(entry, subprogram.loop_heads);
+    }
+
+    const auto find_context = [&]() -> const call_context_t* {
+        for (const auto& context : subprogram.contexts) {
+            if (context->entry == entry) {
+                return context.get();
+            }
+        }
+        return nullptr;
+    };
+    const call_context_t* context;
+    {
+        std::lock_guard lock(_mutex);
+        context = find_context();
+    }
+    if (!context) {
+        // Analyze without holding the lock, since the subprogram may call others. If the same context is analyzed
+        // concurrently, the results are the same and the first one is kept.
+        auto analyzed = std::make_unique<const call_context_t>(analyze(call.target, entry));
+        std::lock_guard lock(_mutex);
+        context = find_context();
+        if (!context) {
+            context = analyzed.get();
+            subprogram.contexts.push_back(std::move(analyzed));
+        }
+    }
+
+    if (subprogram.may_reallocate_packet) {
+        inv = context->exit;
+    } else {
+        ebpf_domain_forget_call_effects(inv, subprogram.loop_heads);
+        inv = context->exit & inv;
+    }
+    return context;
+}
+
+bool interleaved_fwd_fixpoint_iterator_t::transform(const transfer_t& transfer, ebpf_domain_t& inv) {
+    if (_summaries) {
+        if (const auto pcall = std::get_if<CallLocal>(&transfer.instruction)) {
+            _calls.at(transfer.label) = _summaries->apply(*pcall, inv);
+            return false;
+        }
+    }
+    return apply_transformer(transfer.instruction, transfer.assertions, inv);
+}
+
+bool apply_transformer(const Program& prog, const label_t& label, ebpf_domain_t& inv) {
+    return apply_transformer(prog.instruction_at(label), prog.assertions_at(label), inv);
+}
+
+bool apply_transformer(const Instruction& ins, const std::vector<Assertion>& assertions, ebpf_domain_t& inv) {
+    if (thread_local_options.assume_assertions) {
+        for (const auto& assertion : assertions) {
+            // avoid redundant errors
+            ebpf_domain_assume(inv, assertion);
+        }
+    }
+    ebpf_domain_transform(inv, ins);
+    if (thread_local_options.numeric_domain == numeric_domain_t::bounded_zone) {
+        // The interval domain keeps no relations, and the zone domain keeps them all.
+        return inv.limit_relations(thread_local_options.max_relations_per_variable,
+                                   thread_local_options.max_relations);
+    }
+    return false;
+}
+
+analysis_result_t run_forward_analyzer(const Program& prog, ebpf_domain_t entry_inv, const bool check_assertions) {
+    std::optional<call_summaries_t> summaries;
+    if (thread_local_options.cfg_opts.summarize_local_calls) {
+        summaries.emplace(prog);
+    }
+
     // Go over the CFG in weak topological order (accounting for loops).
-    interleaved_fwd_fixpoint_iterator_t analyzer(prog);
+    interleaved_fwd_fixpoint_iterator_t analyzer(prog, prog.cfg(), check_assertions,
+                                                 summaries ? &*summaries : nullptr,
+                                                 thread_local_options.analysis_threads);
     if (thread_local_options.cfg_opts.check_for_termination) {
         // Initialize loop counters for potential loop headers.
         // This enables enforcement of upper bounds on loop iterations
@@ -82,12 +644,140 @@ invariant_table_t run_forward_analyzer(const Program& prog, ebpf_domain_t entry_
         // TODO: Consider making this an instruction instead of an explicit call.
         analyzer._wto.for_each_loop_head(
             [&](const label_t& label) { ebpf_domain_initialize_loop_counter(entry_inv, label); });
+        if (summaries) {
+            // Like those of inlined subprograms, the counters of a subprogram add up over all its calls.
+            for (const label_t& label : summaries->loop_heads()) {
+                ebpf_domain_initialize_loop_counter(entry_inv, label);
+            }
+        }
     }
-    analyzer.set_pre(prog.cfg().entry_label(), entry_inv);
-    for (const auto& component : analyzer._wto) {
-        std::visit(analyzer, component);
+    analyzer.set_pre(analyzer._cfg.entry(), entry_inv);
+
+    std::optional<assertion_failure_t> failure;
+    try {
+        analyzer.run();
+        if (check_assertions) {
+            // A subprogram may be analyzed in contexts that are not final yet, so it is only checked once the
+            // contexts are known.
+            for (const call_context_t* context : reachable_contexts(analyzer._calls)) {
+                crab::check_assertions(prog, context->result);
+            }
+        }
+    } catch (const assertion_failure_t& e) {
+        failure = e;
+    }
+    analysis_result_t res = analyzer.result();
+    res.failure = std::move(failure);
+    for (const call_context_t* context : reachable_contexts(analyzer._calls)) {
+        res.call_contexts.push_back(context->result);
+    }
+    return res;
+}
+
+void interleaved_fwd_fixpoint_iterator_t::run() {
+    const int threads = _threads;
+    if (threads <= 1 || _wto.begin() == _wto.end()) {
+        for (const auto& component : _wto) {
+            visit_top_level(component);
+        }
+        return;
+    }
+
+    // Worker threads run transformers that use thread-local state, so they get copies of the options and
+    // program info, and share the variable names and array cells of this thread.
+    struct stop_sharing_t {
+        ~stop_sharing_t() {
+            variable_t::use_shared_names(nullptr);
+            domains::use_shared_array_map(nullptr);
+        }
+    } stop_sharing;
+    const auto shared_names = variable_t::share_names();
+    const auto shared_array_map = domains::share_array_map();
+    work_stealing_pool_t pool(threads - 1, [shared_names, shared_array_map, options = thread_local_options,
+                                           info = thread_local_program_info.get()] {
+        thread_local_options = options;
+        thread_local_program_info.set(info);
+        variable_t::use_shared_names(shared_names);
+        domains::use_shared_array_map(shared_array_map);
+    });
+    _pool = &pool;
+    prepare_parallel_analysis();
+
+    // The first component always holds the entry label, which has no parent, so it is analyzed before anything else.
+    visit_top_level(*_wto.begin());
+    std::vector<const cycle_or_label*> rest;
+    for (auto it = std::next(_wto.begin()); it != _wto.end(); ++it) {
+        rest.push_back(&*it);
+    }
+    run_component_dag(make_component_dag(_cfg, std::move(rest)), true);
+}
+
+void interleaved_fwd_fixpoint_iterator_t::visit_top_level(const cycle_or_label& component) {
+    std::visit(*this, component);
+    if (_check_assertions) {
+        // The invariants of a top-level component do not change anymore once it has been analyzed.
+        check_assertions(component);
+    }
+}
+
+void interleaved_fwd_fixpoint_iterator_t::check_assertions(const cycle_or_label& component) const {
+    for_each_component_node(component, [&](const node_id_t node) {
+        crab::check_assertions(_transfers_of[node], _inv[node].pre);
+    });
+}
+
+void interleaved_fwd_fixpoint_iterator_t::prepare_parallel_analysis() {
+    // Fill the on-demand nesting cache of the WTO now, since it must not be modified concurrently.
+    for (node_id_t node = 0; node < _cfg.size(); node++) {
+        (void)_wto.nesting(node);
+    }
+
+    std::vector<std::shared_ptr<wto_cycle_t>> worklist;
+    for (const auto& component : _wto) {
+        if (const auto pcycle = std::get_if<std::shared_ptr<wto_cycle_t>>(&component)) {
+            worklist.push_back(*pcycle);
+        }
+    }
+    while (!worklist.empty()) {
+        const std::shared_ptr<wto_cycle_t> cycle = worklist.back();
+        worklist.pop_back();
+        std::vector<const cycle_or_label*> body;
+        for (const auto& component : *cycle) {
+            if (const auto pcycle = std::get_if<std::shared_ptr<wto_cycle_t>>(&component)) {
+                worklist.push_back(*pcycle);
+                body.push_back(&component);
+            } else if (std::get<node_id_t>(component) != cycle->head()) {
+                body.push_back(&component);
+            }
+        }
+        _cycle_dags.emplace(cycle.get(), make_component_dag(_cfg, std::move(body)));
+    }
+}
+
+void interleaved_fwd_fixpoint_iterator_t::run_component_dag(const component_dag_t& dag, const bool top_level) {
+    // Each label's pre and post are written only by the task analyzing its component, and read only by the tasks
+    // of the components that depend on it, so the invariant table needs no further synchronization.
+    _pool->run_dag(dag.successors, [&](const size_t i) {
+        if (top_level) {
+            visit_top_level(*dag.components[i]);
+        } else {
+            std::visit(*this, *dag.components[i]);
+        }
+    });
+}
+
+void interleaved_fwd_fixpoint_iterator_t::visit_cycle_body(const std::shared_ptr<wto_cycle_t>& cycle) {
+    if (_pool) {
+        run_component_dag(_cycle_dags.at(cycle.get()), false);
+        return;
+    }
+    const node_id_t head = cycle->head();
+    for (const auto& component : *cycle) {
+        const auto pnode = std::get_if<node_id_t>(&component);
+        if (!pnode || *pnode != head) {
+            std::visit(*this, component);
+        }
     }
-    return std::move(analyzer._inv);
 }
 
 static ebpf_domain_t extrapolate(const ebpf_domain_t& before, const ebpf_domain_t& after,
@@ -109,42 +799,67 @@ static ebpf_domain_t refine(const ebpf_domain_t& before, const ebpf_domain_t& af
     }
 }
 
-void interleaved_fwd_fixpoint_iterator_t::operator()(const label_t& node) {
+void interleaved_fwd_fixpoint_iterator_t::operator()(const node_id_t node) {
     /** decide whether skip vertex or not **/
-    if (_skip && node == _cfg.entry_label()) {
+    if (_skip && node == _cfg.entry()) {
         _skip = false;
     }
     if (_skip) {
         return;
     }
 
+    if (inputs_unchanged(node)) {
+#ifndef NDEBUG
+        // The transformers must give the same post again, or skipping them is unsound.
+        if (!_summaries) {
+            ebpf_domain_t post = join_all_prevs(node);
+            transform_node(node, post);
+            assert(post == get_post(node));
+        }
+#endif
+        _innermost_loop[node]->skipped_transfers += gsl::narrow<unsigned>(_transfers_of[node].size());
+        return;
+    }
+    const uint64_t now = _clock;
+
     ebpf_domain_t pre = join_all_prevs(node);
 
     set_pre(node, pre);
     transform_to_post(node, std::move(pre));
+    _stamps[node].computed = now;
 }
 
 void interleaved_fwd_fixpoint_iterator_t::operator()(const std::shared_ptr<wto_cycle_t>& cycle) {
-    const label_t head = cycle->head();
+    const node_id_t head = cycle->head();
 
     /** decide whether to skip cycle or not **/
     bool entry_in_this_cycle = false;
     if (_skip) {
         // We only skip the analysis of cycle if entry_label is not a
         // component of it, included nested components.
-        entry_in_this_cycle = is_component_member(_cfg.entry_label(), cycle);
+        entry_in_this_cycle = is_component_member(_cfg.entry(), cycle);
         _skip = !entry_in_this_cycle;
         if (_skip) {
             return;
         }
     }
 
+    // A cycle is a function of its inputs, so there is no need to run it again if none of them changed.
+    cycle_info_t& info = _cycles.at(cycle.get());
+    if (info.computed != 0 && !entry_in_this_cycle &&
+        std::ranges::all_of(info.external_parents,
+                            [&](const node_id_t prev) { return _stamps[prev].changed <= info.computed; })) {
+        _loop_counters.at(head).skipped_transfers += info.size;
+        return;
+    }
+    const uint64_t now = _clock;
+
     ebpf_domain_t invariant = ebpf_domain_t::bottom();
     if (entry_in_this_cycle) {
-        invariant = get_pre(_cfg.entry_label());
+        invariant = get_pre(_cfg.entry());
     } else {
         const wto_nesting_t cycle_nesting = _wto.nesting(head);
-        for (const label_t& prev : _cfg.parents_of(head)) {
+        for (const node_id_t prev : _cfg.parents_of(head)) {
             if (!(_wto.nesting(prev) > cycle_nesting)) {
                 invariant |= get_post(prev);
             }
@@ -155,16 +870,17 @@ void interleaved_fwd_fixpoint_iterator_t::operator()(const std::shared_ptr<wto_c
         // Increasing iteration sequence with widening
         set_pre(head, invariant);
         transform_to_post(head, invariant);
-        for (const auto& component : *cycle) {
-            const auto plabel = std::get_if<label_t>(&component);
-            if (!plabel || *plabel != head) {
-                std::visit(*this, component);
-            }
-        }
+        visit_cycle_body(cycle);
         ebpf_domain_t new_pre = join_all_prevs(head);
         if (new_pre <= invariant) {
             // Post-fixpoint reached
             set_pre(head, new_pre);
+            if (invariant <= new_pre) {
+                // The cycle was last computed from this very pre, so its posts are final.
+                _loop_counters.at(head).skipped_transfers += info.size;
+                info.computed = now;
+                return;
+            }
             invariant = std::move(new_pre);
             break;
         } else {
@@ -175,13 +891,7 @@ void interleaved_fwd_fixpoint_iterator_t::operator()(const std::shared_ptr<wto_c
     for (unsigned int iteration = 1;; ++iteration) {
         // Decreasing iteration sequence with narrowing
         transform_to_post(head, invariant);
-
-        for (const auto& component : *cycle) {
-            const auto plabel = std::get_if<label_t>(&component);
-            if (!plabel || *plabel != head) {
-                std::visit(*this, component);
-            }
-        }
+        visit_cycle_body(cycle);
         ebpf_domain_t new_pre = join_all_prevs(head);
         if (invariant <= new_pre) {
             // No more refinement possible(pre == new_pre)
@@ -194,6 +904,7 @@ void interleaved_fwd_fixpoint_iterator_t::operator()(const std::shared_ptr<wto_c
             set_pre(head, invariant);
         }
     }
+    info.computed = now;
 }
 
 } // namespace crab
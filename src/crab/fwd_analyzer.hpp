@@ -3,7 +3,12 @@
 #pragma once
 
 #include <map>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
+#include "crab/cfg.hpp"
 #include "crab/ebpf_domain.hpp"
 #include "program.hpp"
 
@@ -15,6 +20,59 @@ struct invariant_map_pair {
 };
 using invariant_table_t = std::map<label_t, invariant_map_pair>;
 
-invariant_table_t run_forward_analyzer(const Program& prog, ebpf_domain_t entry_inv);
+/// Work done on the labels of a loop, not counting the loops nested in it.
+struct loop_statistics_t {
+    /// Number of transformers applied.
+    unsigned transfers{};
+    /// Number of transformers not applied again because none of the inputs of the label changed since it was last
+    /// computed. When the loop as a whole is skipped, all its labels count here, including those of nested loops.
+    unsigned skipped_transfers{};
+};
+/// Statistics of each loop, by loop head.
+using loop_statistics_table_t = std::map<label_t, loop_statistics_t>;
+
+/// Thrown when the analysis is still running at the deadline of its options.
+class AnalysisTimeout final : public std::runtime_error {
+  public:
+    explicit AnalysisTimeout(const std::string& what) : std::runtime_error(what) {}
+};
+
+/// An assertion that does not hold.
+struct assertion_failure_t {
+    label_t label;
+    std::string message;
+};
+
+struct analysis_result_t {
+    /// Invariants of each label, or of each chain when the invariants are compact.
+    invariant_table_t invariants;
+    loop_statistics_table_t loop_statistics;
+    /// When the invariants are compact, the chain of labels of each entry of the invariant table, by first label.
+    /// The pre of an entry is then the pre of the first label of the chain, and its post is the post of the last label.
+    /// Empty otherwise.
+    std::map<label_t, basic_block_t> chains;
+    /// When checking assertions during the analysis, the first failed assertion found, if any.
+    /// The analysis stops there, so the invariants are then incomplete.
+    std::optional<assertion_failure_t> failure;
+    /// When local calls are summarized, the results of the subprograms in each calling context that the final
+    /// invariants lead to, directly or through other subprograms. Each is over the
+    /// control-flow graph of its subprogram.
+    std::vector<analysis_result_t> call_contexts;
+    /// Number of transformers after which the numerical domain was over its budget and forgot relations.
+    unsigned over_budget_transfers{};
+};
+
+/// When check_assertions is set, the assertions of each label are checked as soon as its invariants are final,
+/// i.e., once the outermost loop it is in (if any) is stable. Those of subprograms whose calls are summarized are
+/// checked once the whole program has been analyzed.
+analysis_result_t run_forward_analyzer(const Program& prog, ebpf_domain_t entry_inv, bool check_assertions = false);
+
+/// Apply the transformer of a label to the invariant before it, as the analysis does.
+/// @return Whether the numerical domain went over its budget, and forgot relations to get back within it.
+bool apply_transformer(const Program& prog, const label_t& label, ebpf_domain_t& inv);
+
+/// Apply the transformer of an instruction, given the assertions before it, as the analysis does.
+/// @return Whether the numerical domain went over its budget, and forgot relations to get back within it.
+bool apply_transformer(const Instruction& ins, const std::vector<Assertion>& assertions, ebpf_domain_t& inv);
 
 } // namespace crab
@@ -406,4 +406,17 @@ interval_t interval_t::zero_extend(const int width) const {
     // [0b1111..., 0b0000...] is in the original range, so the result is [0b0000..., 0b1111...] which is the full
     return full_range;
 }
+
+interval_t trim_interval(const interval_t& i, const number_t& n) {
+    if (i.lb() == n) {
+        return interval_t{n + 1, i.ub()};
+    }
+    if (i.ub() == n) {
+        return interval_t{i.lb(), n - 1};
+    }
+    if (i.is_top() && n == 0) {
+        return interval_t{1, std::numeric_limits<uint64_t>::max()};
+    }
+    return i;
+}
 } // namespace crab
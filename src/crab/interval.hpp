@@ -350,6 +350,9 @@ class interval_t final {
     std::string to_string() const;
 }; //  class interval
 
+/// The interval without n, when n is one of its bounds; i itself otherwise, as it cannot represent the hole.
+interval_t trim_interval(const interval_t& i, const number_t& n);
+
 namespace interval_operators {
 
 inline interval_t operator+(const number_t& c, const interval_t& x) { return interval_t{c} + x; }
@@ -0,0 +1,340 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#include <set>
+#include <sstream>
+
+#include "crab/interval_domain.hpp"
+#include "crab_utils/stats.hpp"
+#include "type_encoding.hpp"
+
+namespace crab {
+
+std::optional<std::string> bounds_to_string(const variable_t v, const interval_t& bounds) {
+    std::stringstream elem;
+    elem << v;
+    if (v.is_type()) {
+        auto [lb, ub] = bounds.bound(T_UNINIT, T_MAX);
+        if (lb == ub) {
+            if (v.is_in_stack() && lb == T_NUM) {
+                // no need to show this
+                return {};
+            }
+            elem << "=" << lb;
+        } else {
+            elem << " in " << typeset_to_string(iterate_types(lb, ub));
+        }
+    } else {
+        elem << "=";
+        if (bounds.is_singleton()) {
+            elem << bounds.lb();
+        } else {
+            elem << bounds;
+        }
+    }
+    return elem.str();
+}
+
+namespace domains {
+
+// The largest integer at most a / b, and the smallest at least a / b. Division of number_t rounds toward zero.
+static number_t floor_div(const number_t& a, const number_t& b) {
+    const number_t q = a / b;
+    return a % b != 0 && (a < 0) != (b < 0) ? q - 1 : q;
+}
+
+static number_t ceil_div(const number_t& a, const number_t& b) {
+    const number_t q = a / b;
+    return a % b != 0 && (a < 0) == (b < 0) ? q + 1 : q;
+}
+
+IntervalDomain::IntervalDomain(const SplitDBM& dbm) {
+    for (const auto& [v, intv] : dbm.intervals()) {
+        bounds.emplace(v, intv);
+    }
+}
+
+void IntervalDomain::set_bounds(const variable_t x, const interval_t& intv) {
+    if (intv.is_top()) {
+        bounds.erase(x);
+    } else {
+        bounds.insert_or_assign(x, intv);
+    }
+}
+
+interval_t IntervalDomain::operator[](const variable_t x) const {
+    const auto it = bounds.find(x);
+    return it == bounds.end() ? interval_t::top() : it->second;
+}
+
+interval_t IntervalDomain::get_interval(const variable_t x, const int finite_width) const {
+    const interval_t intv = operator[](x);
+    bound_t lb = intv.lb();
+    bound_t ub = intv.ub();
+    if (const auto n = lb.number()) {
+        lb = x.is_unsigned() ? n->zero_extend(finite_width) : n->sign_extend(finite_width);
+    }
+    if (const auto n = ub.number()) {
+        ub = x.is_unsigned() ? n->zero_extend(finite_width) : n->sign_extend(finite_width);
+    }
+    return {lb, ub};
+}
+
+bool IntervalDomain::operator<=(const IntervalDomain& o) const {
+    CrabStats::count("IntervalDomain.count.leq");
+    ScopedCrabStats __st__("IntervalDomain.leq");
+
+    // A variable that o does not bound is unbounded there.
+    for (const auto& [v, intv] : o.bounds) {
+        if (!(operator[](v) <= intv)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+IntervalDomain IntervalDomain::operator|(const IntervalDomain& o) const {
+    CrabStats::count("IntervalDomain.count.join");
+    ScopedCrabStats __st__("IntervalDomain.join");
+
+    IntervalDomain res;
+    for (const auto& [v, intv] : bounds) {
+        if (const auto it = o.bounds.find(v); it != o.bounds.end()) {
+            res.set_bounds(v, intv | it->second);
+        }
+    }
+    return res;
+}
+
+IntervalDomain IntervalDomain::widen(const IntervalDomain& o) const {
+    CrabStats::count("IntervalDomain.count.widening");
+    ScopedCrabStats __st__("IntervalDomain.widening");
+
+    IntervalDomain res;
+    for (const auto& [v, intv] : bounds) {
+        if (const auto it = o.bounds.find(v); it != o.bounds.end()) {
+            res.set_bounds(v, intv.widen(it->second));
+        }
+    }
+    return res;
+}
+
+std::optional<IntervalDomain> IntervalDomain::meet(const IntervalDomain& o) const {
+    CrabStats::count("IntervalDomain.count.meet");
+    ScopedCrabStats __st__("IntervalDomain.meet");
+
+    IntervalDomain res{*this};
+    for (const auto& [v, intv] : o.bounds) {
+        const interval_t met = res[v] & intv;
+        if (met.is_bottom()) {
+            return {};
+        }
+        res.set_bounds(v, met);
+    }
+    return res;
+}
+
+IntervalDomain IntervalDomain::narrow(const IntervalDomain& o) const {
+    CrabStats::count("IntervalDomain.count.narrowing");
+    ScopedCrabStats __st__("IntervalDomain.narrowing");
+
+    // Only infinite bounds are narrowed, so the result does not depend on which variables each side bounds.
+    IntervalDomain res{*this};
+    for (const auto& [v, intv] : o.bounds) {
+        res.set_bounds(v, res[v].narrow(intv));
+    }
+    return res;
+}
+
+interval_t IntervalDomain::eval_interval(const linear_expression_t& e) const {
+    using namespace crab::interval_operators;
+    interval_t r{e.constant_term()};
+    for (const auto& [variable, coefficient] : e.variable_terms()) {
+        r += coefficient * operator[](variable);
+    }
+    return r;
+}
+
+bool IntervalDomain::add_linear_leq(const linear_expression_t& exp) {
+    // For each term c*x of exp, c*x <= -(exp - c*x), whose upper bound gives a bound of x. The bounds narrowed for one
+    // term are used for the next ones.
+    for (const auto& [x, c] : exp.variable_terms()) {
+        interval_t rest{exp.constant_term()};
+        for (const auto& [y, d] : exp.variable_terms()) {
+            if (y != x) {
+                rest += interval_t{d} * operator[](y);
+            }
+        }
+        const auto limit = (-rest).ub().number();
+        if (!limit) {
+            continue;
+        }
+        const interval_t x_bounds = c > 0 ? interval_t{bound_t::minus_infinity(), bound_t{floor_div(*limit, c)}}
+                                          : interval_t{bound_t{ceil_div(*limit, c)}, bound_t::plus_infinity()};
+        const interval_t met = operator[](x) & x_bounds;
+        if (met.is_bottom()) {
+            return false;
+        }
+        set_bounds(x, met);
+    }
+    return true;
+}
+
+bool IntervalDomain::add_constraint(const linear_constraint_t& cst) {
+    CrabStats::count("IntervalDomain.count.add_constraints");
+    ScopedCrabStats __st__("IntervalDomain.add_constraints");
+
+    if (cst.is_tautology()) {
+        return true;
+    }
+    if (cst.is_contradiction()) {
+        return false;
+    }
+    const linear_expression_t& exp = cst.expression();
+    switch (cst.kind()) {
+    case constraint_kind_t::LESS_THAN_OR_EQUALS_ZERO: return add_linear_leq(exp);
+    // e < 0 --> e <= -1
+    case constraint_kind_t::LESS_THAN_ZERO: return add_linear_leq(exp.plus(1));
+    case constraint_kind_t::EQUALS_ZERO: return add_linear_leq(exp) && add_linear_leq(exp.negate());
+    case constraint_kind_t::NOT_ZERO:
+        for (const auto& [x, c] : exp.variable_terms()) {
+            interval_t residual{-exp.constant_term()};
+            for (const auto& [y, d] : exp.variable_terms()) {
+                if (y != x) {
+                    residual -= interval_t{d} * operator[](y);
+                }
+            }
+            if (const auto k = (residual / interval_t{c}).singleton()) {
+                const interval_t trimmed = trim_interval(operator[](x), *k);
+                if (trimmed.is_bottom()) {
+                    return false;
+                }
+                set_bounds(x, trimmed);
+            }
+        }
+        return true;
+    }
+    return true;
+}
+
+void IntervalDomain::apply(const arith_binop_t op, const variable_t x, const variable_t y, const variable_t z,
+                           const int finite_width) {
+    CrabStats::count("IntervalDomain.count.apply");
+    ScopedCrabStats __st__("IntervalDomain.apply");
+
+    switch (op) {
+    case arith_binop_t::ADD: set(x, operator[](y) + operator[](z)); break;
+    // As for the bitwise operations, the bounds cannot show that y - y is 0.
+    case arith_binop_t::SUB: set(x, y == z ? interval_t{0} : operator[](y) - operator[](z)); break;
+    case arith_binop_t::MUL: set(x, get_interval(y, finite_width) * get_interval(z, finite_width)); break;
+    case arith_binop_t::SDIV: set(x, get_interval(y, finite_width).sdiv(get_interval(z, finite_width))); break;
+    case arith_binop_t::UDIV: set(x, get_interval(y, finite_width).udiv(get_interval(z, finite_width))); break;
+    case arith_binop_t::SREM: set(x, get_interval(y, finite_width).srem(get_interval(z, finite_width))); break;
+    case arith_binop_t::UREM: set(x, get_interval(y, finite_width).urem(get_interval(z, finite_width))); break;
+    default: CRAB_ERROR("IntervalDomain: unreachable");
+    }
+}
+
+void IntervalDomain::apply(const arith_binop_t op, const variable_t x, const variable_t y, const number_t& k,
+                           const int finite_width) {
+    CrabStats::count("IntervalDomain.count.apply");
+    ScopedCrabStats __st__("IntervalDomain.apply");
+
+    switch (op) {
+    case arith_binop_t::ADD: set(x, operator[](y) + interval_t{k}); break;
+    case arith_binop_t::SUB: set(x, operator[](y) - interval_t{k}); break;
+    case arith_binop_t::MUL: set(x, operator[](y) * interval_t{k}); break;
+    case arith_binop_t::SDIV:
+        set(x, get_interval(y, finite_width).sdiv(interval_t{read_imm_for_sdiv_or_smod(k, finite_width)}));
+        break;
+    case arith_binop_t::UDIV:
+        set(x, get_interval(y, finite_width).udiv(interval_t{read_imm_for_udiv_or_umod(k, finite_width)}));
+        break;
+    case arith_binop_t::SREM:
+        set(x, get_interval(y, finite_width).srem(interval_t{read_imm_for_sdiv_or_smod(k, finite_width)}));
+        break;
+    case arith_binop_t::UREM:
+        set(x, get_interval(y, finite_width).urem(interval_t{read_imm_for_udiv_or_umod(k, finite_width)}));
+        break;
+    default: CRAB_ERROR("IntervalDomain: unreachable");
+    }
+}
+
+static interval_t apply_bitwise(const bitwise_binop_t op, const interval_t& yi, const interval_t& zi) {
+    switch (op) {
+    case bitwise_binop_t::AND: return yi.bitwise_and(zi);
+    case bitwise_binop_t::OR: return yi.bitwise_or(zi);
+    case bitwise_binop_t::XOR: return yi.bitwise_xor(zi);
+    case bitwise_binop_t::SHL: return yi.shl(zi);
+    case bitwise_binop_t::LSHR: return yi.lshr(zi);
+    case bitwise_binop_t::ASHR: return yi.ashr(zi);
+    default: CRAB_ERROR("IntervalDomain: unreachable");
+    }
+}
+
+void IntervalDomain::apply(const bitwise_binop_t op, const variable_t x, const variable_t y, const variable_t z,
+                           int) {
+    CrabStats::count("IntervalDomain.count.apply");
+    ScopedCrabStats __st__("IntervalDomain.apply");
+
+    // The bounds cannot show that an operand equals itself, so the identities of y op y are applied here.
+    if (y == z) {
+        switch (op) {
+        case bitwise_binop_t::XOR: set(x, interval_t{0}); return;
+        case bitwise_binop_t::AND:
+        case bitwise_binop_t::OR: set(x, operator[](y)); return;
+        default: break;
+        }
+    }
+    set(x, apply_bitwise(op, operator[](y), operator[](z)));
+}
+
+void IntervalDomain::apply(const bitwise_binop_t op, const variable_t x, const variable_t y, const number_t& k,
+                           int) {
+    CrabStats::count("IntervalDomain.count.apply");
+    ScopedCrabStats __st__("IntervalDomain.apply");
+
+    set(x, apply_bitwise(op, operator[](y), interval_t{number_t{k.cast_to<uint64_t>()}}));
+}
+
+bool IntervalDomain::intersect(const linear_constraint_t& cst) const {
+    if (cst.is_contradiction()) {
+        return false;
+    }
+    if (is_top() || cst.is_tautology()) {
+        return true;
+    }
+    return IntervalDomain{*this}.add_constraint(cst);
+}
+
+bool IntervalDomain::entail(const linear_constraint_t& rhs) const {
+    if (rhs.is_tautology()) {
+        return true;
+    }
+    if (rhs.is_contradiction()) {
+        return false;
+    }
+    // Without relations, the range of the expression is all the domain knows of it.
+    const interval_t range = eval_interval(rhs.expression());
+    switch (rhs.kind()) {
+    case constraint_kind_t::EQUALS_ZERO: return range.singleton() == std::optional(number_t(0));
+    case constraint_kind_t::LESS_THAN_OR_EQUALS_ZERO: return range.ub() <= number_t(0);
+    case constraint_kind_t::LESS_THAN_ZERO: return range.ub() < number_t(0);
+    case constraint_kind_t::NOT_ZERO: return !range.contains(0);
+    }
+    return false;
+}
+
+string_invariant IntervalDomain::to_set() const {
+    std::set<std::string> result;
+    for (const auto& [v, intv] : bounds) {
+        if (auto elem = bounds_to_string(v, intv)) {
+            result.insert(std::move(*elem));
+        }
+    }
+    return string_invariant{result};
+}
+
+std::ostream& operator<<(std::ostream& o, const IntervalDomain& dom) { return o << dom.to_set(); }
+
+} // namespace domains
+} // namespace crab
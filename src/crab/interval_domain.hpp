@@ -0,0 +1,147 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <optional>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/container/flat_map.hpp>
+
+#include "crab/interval.hpp"
+#include "crab/linear_constraint.hpp"
+#include "crab/split_dbm.hpp"
+#include "crab/thresholds.hpp"
+#include "crab/variable.hpp"
+
+#include "string_constraints.hpp"
+
+namespace crab {
+
+/// How a variable and its bounds are printed in an invariant, or nothing if they go without saying.
+std::optional<std::string> bounds_to_string(variable_t v, const interval_t& bounds);
+
+namespace domains {
+
+/**
+ * The bounds of each variable, and no relation between variables.
+ *
+ * It has the interface of SplitDBM, so that FiniteDomain can run the same transformers over either, but each operation
+ * only costs a walk over the bounds of the variables it touches, or of all the variables for join, widening and
+ * inclusion.
+ */
+class IntervalDomain final {
+    // The bounds of the variables that have some; a variable that is missing is unbounded.
+    boost::container::flat_map<variable_t, interval_t> bounds;
+
+    // Set the bounds of x, or forget x if it has none.
+    void set_bounds(variable_t x, const interval_t& intv);
+
+    // The bounds of x, sign-extended or zero-extended from finite_width bits as the signedness of x says.
+    [[nodiscard]]
+    interval_t get_interval(variable_t x, int finite_width) const;
+
+    // Narrow the bounds of the variables of exp so that exp <= 0 may hold. Return false if it cannot.
+    bool add_linear_leq(const linear_expression_t& exp);
+
+  public:
+    IntervalDomain() = default;
+
+    /// The bounds that dbm implies, without its relations.
+    explicit IntervalDomain(const SplitDBM& dbm);
+
+    void set_to_top() { bounds.clear(); }
+
+    static IntervalDomain top() { return IntervalDomain(); }
+
+    [[nodiscard]]
+    bool is_top() const {
+        return bounds.empty();
+    }
+
+    bool operator<=(const IntervalDomain& o) const;
+
+    IntervalDomain operator|(const IntervalDomain& o) const;
+
+    [[nodiscard]]
+    IntervalDomain widen(const IntervalDomain& o) const;
+
+    [[nodiscard]]
+    IntervalDomain widening_thresholds(const IntervalDomain& o, const iterators::thresholds_t&) const {
+        return widen(o);
+    }
+
+    std::optional<IntervalDomain> meet(const IntervalDomain& o) const;
+
+    [[nodiscard]]
+    IntervalDomain narrow(const IntervalDomain& o) const;
+
+    void assign(variable_t lhs, const linear_expression_t& e) { set(lhs, eval_interval(e)); }
+
+    void assign(variable_t x, variable_t v) { set(x, operator[](v)); }
+
+    void assign(variable_t x, const std::optional<linear_expression_t>& e) {
+        if (e) {
+            assign(x, *e);
+        } else {
+            havoc(x);
+        }
+    }
+
+    void havoc(const variable_t v) { bounds.erase(v); }
+
+    void apply(arith_binop_t op, variable_t x, variable_t y, variable_t z, int finite_width);
+
+    void apply(arith_binop_t op, variable_t x, variable_t y, const number_t& k, int finite_width);
+
+    void apply(bitwise_binop_t op, variable_t x, variable_t y, variable_t z, int finite_width);
+
+    void apply(bitwise_binop_t op, variable_t x, variable_t y, const number_t& k, int finite_width);
+
+    void apply(binop_t op, variable_t x, variable_t y, const number_t& z, int finite_width) {
+        std::visit([&](auto top) { apply(top, x, y, z, finite_width); }, op);
+    }
+
+    void apply(binop_t op, variable_t x, variable_t y, variable_t z, int finite_width) {
+        std::visit([&](auto top) { apply(top, x, y, z, finite_width); }, op);
+    }
+
+    bool add_constraint(const linear_constraint_t& cst);
+
+    [[nodiscard]]
+    interval_t eval_interval(const linear_expression_t& e) const;
+
+    interval_t operator[](variable_t x) const;
+
+    void set(variable_t x, const interval_t& intv) {
+        assert(!intv.is_bottom());
+        set_bounds(x, intv);
+    }
+
+    /// There are no relations to forget.
+    bool limit_relations(std::optional<std::size_t>, std::optional<std::size_t>) { return false; }
+
+    /// Return the number of variables with bounds, and no edges.
+    [[nodiscard]]
+    std::pair<std::size_t, std::size_t> size() const {
+        return {bounds.size(), 0};
+    }
+
+    /// Return true if inv intersects with cst.
+    [[nodiscard]]
+    bool intersect(const linear_constraint_t& cst) const;
+
+    /// Return true if entails rhs.
+    [[nodiscard]]
+    bool entail(const linear_constraint_t& rhs) const;
+
+    friend std::ostream& operator<<(std::ostream& o, const IntervalDomain& dom);
+
+    [[nodiscard]]
+    string_invariant to_set() const;
+};
+
+} // namespace domains
+} // namespace crab
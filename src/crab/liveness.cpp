@@ -0,0 +1,230 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+
+// This file is eBPF-specific, not derived from CRAB.
+#include <iterator>
+#include <optional>
+#include <set>
+#include <variant>
+
+#include "crab/liveness.hpp"
+#include "program.hpp"
+
+namespace crab {
+
+/// The bytes of the stack from offset to offset + width relative to base, if base is the stack pointer of the frame
+/// of the program and they are all in it.
+static std::optional<std::pair<int, int>> stack_range(const label_t& label, const Reg& base, const int32_t offset,
+                                                      const int width) {
+    if (base.v != R10_STACK_POINTER || label.call_stack_depth() != 1 || width <= 0) {
+        return {};
+    }
+    const int64_t start = int64_t{EBPF_TOTAL_STACK_SIZE} + offset;
+    if (start < 0 || start + width > EBPF_TOTAL_STACK_SIZE) {
+        return {};
+    }
+    return std::pair{gsl::narrow<int>(start), width};
+}
+
+/// Turns the variables live after a label into those live before it.
+class liveness_transfer_t final {
+    const label_t& _label;
+    live_variables_t& _live;
+
+    void use(const Reg& reg) const { _live.registers.set(reg.v); }
+
+    void use(const Value& value) const {
+        if (const auto preg = std::get_if<Reg>(&value)) {
+            use(*preg);
+        }
+    }
+
+    void def(const Reg& reg) const { _live.registers.reset(reg.v); }
+
+    void use_all() const {
+        _live.registers.set();
+        _live.stack.set();
+    }
+
+    /// A call to a helper reads its arguments and any memory they point to, and clobbers the caller-saved registers.
+    void call_helper() const {
+        for (uint8_t i = R0_RETURN_VALUE; i <= R5_ARG; i++) {
+            def(Reg{i});
+        }
+        for (uint8_t i = R1_ARG; i <= R5_ARG; i++) {
+            use(Reg{i});
+        }
+        _live.stack.set();
+    }
+
+    void use_stack(const Reg& base, const int32_t offset, const int width) const {
+        if (const auto range = stack_range(_label, base, offset, width)) {
+            for (int i = range->first; i < range->first + range->second; i++) {
+                _live.stack.set(i);
+            }
+        } else {
+            _live.stack.set();
+        }
+    }
+
+    void def_stack(const Reg& base, const int32_t offset, const int width) const {
+        if (const auto range = stack_range(_label, base, offset, width)) {
+            for (int i = range->first; i < range->first + range->second; i++) {
+                _live.stack.reset(i);
+            }
+        }
+    }
+
+  public:
+    liveness_transfer_t(const label_t& label, live_variables_t& live) : _label(label), _live(live) {}
+
+    void operator()(const Undefined&) const {}
+
+    void operator()(const Bin& bin) const {
+        def(bin.dst);
+        switch (bin.op) {
+        case Bin::Op::MOV:
+        case Bin::Op::MOVSX8:
+        case Bin::Op::MOVSX16:
+        case Bin::Op::MOVSX32: break;
+        default: use(bin.dst);
+        }
+        use(bin.v);
+    }
+
+    void operator()(const Un& un) const { use(un.dst); }
+
+    void operator()(const LoadMapFd& ins) const { def(ins.dst); }
+
+    void operator()(const LoadMapAddress& ins) const { def(ins.dst); }
+
+    void operator()(const Call&) const { call_helper(); }
+
+    void operator()(const Callx& callx) const {
+        call_helper();
+        use(callx.func);
+    }
+
+    // A subprogram may read anything of its caller, and the caller anything of its callee.
+    void operator()(const CallLocal&) const { use_all(); }
+
+    void operator()(const Exit&) const { use_all(); }
+
+    void operator()(const Jmp& jmp) const {
+        if (jmp.cond) {
+            use(jmp.cond->left);
+            use(jmp.cond->right);
+        }
+    }
+
+    void operator()(const Mem& mem) const {
+        if (mem.is_load) {
+            def(std::get<Reg>(mem.value));
+            use_stack(mem.access.basereg, mem.access.offset, mem.access.width);
+        } else {
+            def_stack(mem.access.basereg, mem.access.offset, mem.access.width);
+            use(mem.value);
+        }
+        use(mem.access.basereg);
+    }
+
+    // Legacy packet accesses read the context through r6 and call into the kernel.
+    void operator()(const Packet&) const { use_all(); }
+
+    void operator()(const Atomic& atomic) const {
+        use_stack(atomic.access.basereg, atomic.access.offset, atomic.access.width);
+        use(atomic.access.basereg);
+        use(atomic.valreg);
+        use(Reg{R0_RETURN_VALUE});
+    }
+
+    void operator()(const Assume& assume) const {
+        use(assume.cond.left);
+        use(assume.cond.right);
+    }
+
+    void operator()(const IncrementLoopCounter&) const {}
+
+    void operator()(const Comparable& s) const {
+        use(s.r1);
+        use(s.r2);
+    }
+
+    void operator()(const Addable& s) const {
+        use(s.ptr);
+        use(s.num);
+    }
+
+    void operator()(const ValidDivisor& s) const { use(s.reg); }
+
+    void operator()(const ValidAccess& s) const {
+        use(s.reg);
+        use(s.width);
+        // Only reads check what the stack holds.
+        if (s.access_type != AccessType::read) {
+            return;
+        }
+        if (const auto pimm = std::get_if<Imm>(&s.width)) {
+            use_stack(s.reg, s.offset, gsl::narrow<int>(pimm->v));
+        } else {
+            _live.stack.set();
+        }
+    }
+
+    void operator()(const ValidStore& s) const {
+        use(s.mem);
+        use(s.val);
+    }
+
+    void operator()(const ValidSize& s) const { use(s.reg); }
+
+    void operator()(const ValidMapKeyValue& s) const {
+        use(s.access_reg);
+        use(s.map_fd_reg);
+        _live.stack.set();
+    }
+
+    void operator()(const ValidCall&) const {}
+
+    void operator()(const TypeConstraint& s) const { use(s.reg); }
+
+    void operator()(const FuncConstraint& s) const { use(s.reg); }
+
+    void operator()(const ZeroCtxOffset& s) const { use(s.reg); }
+
+    void operator()(const BoundedLoopCount&) const {}
+};
+
+liveness_t::liveness_t(const Program& prog, const cfg_t& cfg) {
+    for (const label_t& label : cfg.labels()) {
+        _live_in.emplace(label, live_variables_t{});
+    }
+    _live_in.at(label_t::exit).registers.set();
+    _live_in.at(label_t::exit).stack.set();
+
+    // Labels are mostly ordered like the program, so going from the last one reaches a fixpoint in few passes.
+    std::set<label_t> pending{cfg.labels().begin(), cfg.labels().end()};
+    pending.erase(label_t::exit);
+    while (!pending.empty()) {
+        const label_t label = *std::prev(pending.end());
+        pending.erase(std::prev(pending.end()));
+
+        live_variables_t live;
+        for (const label_t& child : cfg.children_of(label)) {
+            live |= _live_in.at(child);
+        }
+        const liveness_transfer_t transfer{label, live};
+        std::visit(transfer, prog.instruction_at(label));
+        for (const Assertion& assertion : prog.assertions_at(label)) {
+            std::visit(transfer, assertion);
+        }
+        if (live_variables_t& live_in = _live_in.at(label); !(live == live_in)) {
+            live_in = live;
+            for (const label_t& parent : cfg.parents_of(label)) {
+                pending.insert(parent);
+            }
+        }
+    }
+}
+
+} // namespace crab
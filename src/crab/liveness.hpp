@@ -0,0 +1,52 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+// This file is eBPF-specific, not derived from CRAB.
+
+#include <bitset>
+#include <map>
+
+#include "crab/cfg.hpp"
+#include "crab/label.hpp"
+#include "ebpf_base.h" // for EBPF_TOTAL_STACK_SIZE constant
+#include "ebpf_vm_isa.hpp"
+
+class Program;
+
+namespace crab {
+
+/// A set of registers and of bytes of the stack.
+struct live_variables_t {
+    std::bitset<R11_ATOMIC_SCRATCH + 1> registers;
+    std::bitset<EBPF_TOTAL_STACK_SIZE> stack;
+
+    live_variables_t& operator|=(const live_variables_t& other) {
+        registers |= other.registers;
+        stack |= other.stack;
+        return *this;
+    }
+
+    bool operator==(const live_variables_t&) const = default;
+};
+
+/// Registers and bytes of the stack that may be read before they are written, from the start of each label of a cfg.
+///
+/// Only the bytes of the stack that the program accesses through r10 in its own frame are tracked one by one.
+/// Any other access that may read the stack, through a pointer or by a helper, reads all of it, and any other write
+/// to the stack writes none of it. Assertions count as reads, and so does everything at the exit label, whose
+/// invariant is the result of the analysis. Forgetting what is not live is therefore never seen by a later check.
+class liveness_t final {
+    std::map<label_t, live_variables_t> _live_in;
+
+  public:
+    liveness_t(const Program& prog, const cfg_t& cfg);
+
+    /// The registers and bytes of the stack that may be read at or after a label.
+    [[nodiscard]]
+    const live_variables_t& live_in(const label_t& label) const {
+        return _live_in.at(label);
+    }
+};
+
+} // namespace crab
@@ -1,15 +1,16 @@
 // Copyright (c) Prevail Verifier contributors.
 // SPDX-License-Identifier: Apache-2.0
+#include <algorithm>
 #include <utility>
 
 #include <gsl/narrow>
 
+#include "crab/interval_domain.hpp"
 #include "crab/split_dbm.hpp"
 #include "crab_utils/debug.hpp"
 #include "crab_utils/graph_ops.hpp"
 #include "crab_utils/stats.hpp"
 #include "string_constraints.hpp"
-#include "type_encoding.hpp"
 
 namespace crab::domains {
 
@@ -241,6 +242,24 @@ static GraphOps::PotentialFunction index_to_call(const GraphOps::WeightVector& p
     return [&p](GraphOps::vert_id v) -> GraphOps::Weight { return p[v]; };
 }
 
+// The edges that close the relations of g: on a dense matrix when g is small enough, and otherwise by
+// close_sparse, which only follows what changed since g was last closed.
+template <class F>
+static GraphOps::edge_vector close_relations(SplitDBM::graph_t& g, F&& close_sparse) {
+    if (auto delta = GraphOps::close_dense(SubGraph(g, 0))) {
+        // The dense closure finds every path, also those that only give relations that the bounds already imply, which
+        // the split normal form leaves out.
+        std::erase_if(*delta, [&g](const auto& e) {
+            const auto& [s, d, w] = e;
+            const auto lb = g.lookup(s, 0);
+            const auto ub = g.lookup(0, d);
+            return lb && ub && *lb + *ub <= w;
+        });
+        return std::move(*delta);
+    }
+    return close_sparse(SubGraph(g, 0));
+}
+
 bool SplitDBM::add_linear_leq(const linear_expression_t& exp) {
     std::vector<std::pair<variable_t, Weight>> lbs, ubs;
     std::vector<diffcst_t> csts;
@@ -290,19 +309,6 @@ bool SplitDBM::add_linear_leq(const linear_expression_t& exp) {
     return true;
 }
 
-static interval_t trim_interval(const interval_t& i, const number_t& n) {
-    if (i.lb() == n) {
-        return interval_t{n + 1, i.ub()};
-    }
-    if (i.ub() == n) {
-        return interval_t{i.lb(), n - 1};
-    }
-    if (i.is_top() && n == 0) {
-        return interval_t{1, std::numeric_limits<uint64_t>::max()};
-    }
-    return i;
-}
-
 bool SplitDBM::add_univar_disequation(variable_t x, const number_t& n) {
     interval_t i = get_interval(x, 0);
     interval_t new_i = trim_interval(i, n);
@@ -370,6 +376,27 @@ bool SplitDBM::add_univar_disequation(variable_t x, const number_t& n) {
     return true;
 }
 
+std::vector<bool> SplitDBM::shared_packs(const SplitDBM& o) const {
+    const std::vector<vert_id>& pack = g.packs();
+
+    // A vertex whose rows are shared has the same relations in o, so its pack is the same there too.
+    std::vector<bool> differs(g.size(), false);
+    for (const vert_id v : g.verts()) {
+        if (v == 0 || !rev_map[v] || try_at(o.vert_map, *rev_map[v]) != v || !g.shares_edges_of(o.g, v)) {
+            differs[pack[v]] = true;
+        }
+    }
+    std::vector<bool> shared(g.size(), false);
+    for (const vert_id v : g.verts()) {
+        shared[v] = !differs[pack[v]];
+    }
+    return shared;
+}
+
+bool SplitDBM::shares_all_packs(const std::vector<bool>& shared) const {
+    return std::ranges::all_of(vert_map, [&shared](const auto& p) { return shared[p.second]; });
+}
+
 bool SplitDBM::operator<=(const SplitDBM& o) const {
     CrabStats::count("SplitDBM.count.leq");
     ScopedCrabStats __st__("SplitDBM.leq");
@@ -402,9 +429,11 @@ bool SplitDBM::operator<=(const SplitDBM& o) const {
         }
     }
 
+    // The packs that o shares with this have the same edges here.
+    const std::vector<bool> shared = shared_packs(o);
     assert(g.size() > 0);
     for (vert_id ox : o.g.verts()) {
-        if (o.g.succs(ox).size() == 0) {
+        if (o.g.succs(ox).size() == 0 || (ox < shared.size() && shared[ox])) {
             continue;
         }
 
@@ -445,6 +474,13 @@ SplitDBM SplitDBM::operator|(const SplitDBM& o) const& {
     if (is_top()) {
         return *this;
     }
+    const std::vector<bool> shared = shared_packs(o);
+    if (shares_all_packs(shared)) {
+        CrabStats::count("SplitDBM.count.join.shared");
+        SplitDBM res(*this);
+        res.normalize();
+        return res;
+    }
     CRAB_LOG("zones-split", std::cout << "Before join:\n"
                                       << "DBM 1\n"
                                       << *this << "\n"
@@ -494,8 +530,14 @@ SplitDBM SplitDBM::operator|(const SplitDBM& o) const& {
     // Compute the deferred relations
     graph_t g_ix_ry;
     g_ix_ry.growTo(sz);
+    // A pack that both share has the same relations and bounds on both sides, so it defers nothing to the other and
+    // its bounds move in no direction.
+    const auto in_shared_pack = [&](const vert_id s) { return shared[perm_x[s]]; };
     SubGraph gy_excl(gy, 0);
     for (vert_id s : gy_excl.verts()) {
+        if (in_shared_pack(s)) {
+            continue;
+        }
         for (vert_id d : gy_excl.succs(s)) {
             if (auto ws = gx.lookup(s, 0)) {
                 if (auto wd = gx.lookup(0, d)) {
@@ -508,7 +550,9 @@ SplitDBM SplitDBM::operator|(const SplitDBM& o) const& {
     bool is_closed;
     graph_t g_rx(GraphOps::meet(gx, g_ix_ry, is_closed));
     if (!is_closed) {
-        GraphOps::apply_delta(g_rx, GraphOps::close_after_meet(SubGraph(g_rx, 0), index_to_call(pot_rx), gx, g_ix_ry));
+        GraphOps::apply_delta(g_rx, close_relations(g_rx, [&](const auto& sub) {
+            return GraphOps::close_after_meet(sub, index_to_call(pot_rx), gx, g_ix_ry);
+        }));
     }
 
     graph_t g_rx_iy;
@@ -516,6 +560,9 @@ SplitDBM SplitDBM::operator|(const SplitDBM& o) const& {
 
     SubGraph gx_excl(gx, 0);
     for (vert_id s : gx_excl.verts()) {
+        if (in_shared_pack(s)) {
+            continue;
+        }
         for (vert_id d : gx_excl.succs(s)) {
             // Assumption: gx.mem(s, d) -> gx.edge_val(s, d) <= ranges[var(s)].ub() - ranges[var(d)].lb()
             // That is, if the relation exists, it's at least as strong as the bounds.
@@ -529,7 +576,9 @@ SplitDBM SplitDBM::operator|(const SplitDBM& o) const& {
     // Similarly, should use a SubGraph view.
     graph_t g_ry(GraphOps::meet(gy, g_rx_iy, is_closed));
     if (!is_closed) {
-        GraphOps::apply_delta(g_ry, GraphOps::close_after_meet(SubGraph(g_ry, 0), index_to_call(pot_ry), gy, g_rx_iy));
+        GraphOps::apply_delta(g_ry, close_relations(g_ry, [&](const auto& sub) {
+            return GraphOps::close_after_meet(sub, index_to_call(pot_ry), gy, g_rx_iy);
+        }));
     }
 
     // We now have the relevant set of relations. Because g_rx and g_ry are closed,
@@ -544,6 +593,9 @@ SplitDBM SplitDBM::operator|(const SplitDBM& o) const& {
     std::vector<vert_id> ub_down;
 
     for (vert_id v : gx_excl.verts()) {
+        if (in_shared_pack(v)) {
+            continue;
+        }
         if (auto wx = gx.lookup(0, v)) {
             if (auto wy = gy.lookup(0, v)) {
                 if (*wx < *wy) {
@@ -624,6 +676,13 @@ SplitDBM SplitDBM::widen(const SplitDBM& o) const {
                                       << "DBM 2\n"
                                       << o << "\n");
 
+    if (shares_all_packs(shared_packs(o))) {
+        CrabStats::count("SplitDBM.count.widening.shared");
+        SplitDBM res(*this);
+        res.normalize();
+        return res;
+    }
+
     // Figure out the common renaming
     assert(!potential.empty());
     std::vector<Weight> widen_pot = {0};
@@ -735,7 +794,9 @@ std::optional<SplitDBM> SplitDBM::meet(const SplitDBM& o) const {
 
     if (!is_closed) {
         const auto potential_func = index_to_call(meet_pi);
-        GraphOps::apply_delta(meet_g, GraphOps::close_after_meet(SubGraph(meet_g, 0), potential_func, gx, gy));
+        GraphOps::apply_delta(meet_g, close_relations(meet_g, [&](const auto& sub) {
+            return GraphOps::close_after_meet(sub, potential_func, gx, gy);
+        }));
 
         // Recover updated LBs and UBs.<
 
@@ -952,7 +1013,16 @@ void SplitDBM::normalize() {
     // GraphOps::close_after_widen(g, potential, vert_set_wrap_t(unstable), delta);
     // GKG: Check
     const auto p = index_to_call(potential);
-    GraphOps::apply_delta(g, GraphOps::close_after_widen(SubGraph(g, 0), p, vert_set_wrap_t(unstable)));
+    const auto close_unstable = [&](const auto& sub) {
+        return GraphOps::close_after_widen(sub, p, vert_set_wrap_t(unstable));
+    };
+    // Searching from the unstable vertices only is faster than the dense closure once they are fewer than a quarter
+    // of the vertices, except on the smallest graphs, which the dense closure always wins ("[graph-benchmark]").
+    if (g.size() <= 8 || 4 * unstable.size() >= g.size()) {
+        GraphOps::apply_delta(g, close_relations(g, close_unstable));
+    } else {
+        GraphOps::apply_delta(g, close_unstable(SubGraph(g, 0)));
+    }
     // Retrieve variable bounds
     GraphOps::apply_delta(g, GraphOps::close_after_assign(g, p, 0));
 
@@ -1011,30 +1081,6 @@ void SplitDBM::apply(const arith_binop_t op, const variable_t x, const variable_
     normalize();
 }
 
-// As defined in the BPF ISA specification, the immediate value of an unsigned modulo and division is treated
-// differently depending on the width:
-// * for 32 bit, as a 32-bit unsigned integer
-// * for 64 bit, as a 32-bit (not 64 bit) signed integer
-static number_t read_imm_for_udiv_or_umod(const number_t& imm, const int width) {
-    assert(width == 32 || width == 64);
-    if (width == 32) {
-        return number_t{imm.cast_to<uint32_t>()};
-    }
-    return number_t{imm.cast_to<int32_t>()};
-}
-
-// As defined in the BPF ISA specification, the immediate value of a signed modulo and division is treated
-// differently depending on the width:
-// * for 32 bit, as a 32-bit signed integer
-// * for 64 bit, as a 64-bit signed integer
-static number_t read_imm_for_sdiv_or_smod(const number_t& imm, const int width) {
-    assert(width == 32 || width == 64);
-    if (width == 32) {
-        return number_t{imm.cast_to<int32_t>()};
-    }
-    return number_t{imm.cast_to<int64_t>()};
-}
-
 void SplitDBM::apply(const arith_binop_t op, const variable_t x, const variable_t y, const number_t& k,
                      const int finite_width) {
     CrabStats::count("SplitDBM.count.apply");
@@ -1122,6 +1168,99 @@ void SplitDBM::forget(const variable_vector_t& variables) {
     normalize();
 }
 
+bool SplitDBM::limit_relations(const std::optional<std::size_t> per_variable_limit,
+                               const std::optional<std::size_t> total_limit) {
+    const std::size_t max_per_variable = per_variable_limit.value_or(SIZE_MAX);
+    const std::size_t max_total = total_limit.value_or(SIZE_MAX);
+    normalize();
+
+    std::vector<std::size_t> degree(g.size());
+    std::size_t total = 0;
+    bool too_many = false;
+    for (const vert_id v : g.verts()) {
+        if (v == 0) {
+            continue;
+        }
+        for (const vert_id d : g.succs(v)) {
+            if (d != 0) {
+                total++;
+                too_many |= ++degree[v] > max_per_variable;
+                too_many |= ++degree[d] > max_per_variable;
+            }
+        }
+    }
+    too_many |= total > max_total;
+    if (!too_many) {
+        return false;
+    }
+
+    // The graph is closed, so the edges to and from the zero vertex are the tightest bounds, and the potential remains
+    // a solution once some of the other edges are gone.
+    std::vector<std::pair<vert_id, Weight>> lbs;
+    std::vector<std::pair<vert_id, Weight>> ubs;
+    for (const auto [v, w] : g.e_preds(0)) {
+        lbs.emplace_back(v, w);
+    }
+    for (const auto [v, w] : g.e_succs(0)) {
+        ubs.emplace_back(v, w);
+    }
+
+    // An edge src -> dest with weight w says dest - src <= w, where the bounds only say dest - src <= ub(dest) -
+    // lb(src). The edges that improve the most on that are kept; those whose bounds are unknown improve the most.
+    struct relation_t {
+        vert_id src;
+        vert_id dest;
+        Weight w;
+        std::optional<Weight> gain;
+    };
+    std::vector<relation_t> relations;
+    if (max_per_variable > 0 && max_total > 0) {
+        for (const vert_id v : g.verts()) {
+            if (v == 0) {
+                continue;
+            }
+            for (const auto [d, w] : g.e_succs(v)) {
+                if (d == 0) {
+                    continue;
+                }
+                std::optional<Weight> gain;
+                if (g.elem(0, d) && g.elem(v, 0)) {
+                    gain = g.edge_val(0, d) + g.edge_val(v, 0) - w;
+                }
+                relations.push_back({v, d, w, gain});
+            }
+        }
+        std::ranges::stable_sort(relations, [](const relation_t& a, const relation_t& b) {
+            if (!a.gain || !b.gain) {
+                return !a.gain && b.gain;
+            }
+            return *a.gain > *b.gain;
+        });
+    }
+
+    g.clear_edges();
+    for (const auto& [v, w] : lbs) {
+        g.add_edge(v, w, 0);
+    }
+    for (const auto& [v, w] : ubs) {
+        g.add_edge(0, w, v);
+    }
+    std::ranges::fill(degree, 0);
+    std::size_t kept = 0;
+    for (const relation_t& r : relations) {
+        if (kept == max_total) {
+            break;
+        }
+        if (degree[r.src] < max_per_variable && degree[r.dest] < max_per_variable) {
+            g.add_edge(r.src, r.w, r.dest);
+            degree[r.src]++;
+            degree[r.dest]++;
+            kept++;
+        }
+    }
+    return true;
+}
+
 static std::string to_string(const variable_t vd, const variable_t vs, const SplitDBM::Weight& w, const bool eq) {
     std::stringstream elem;
     if (eq) {
@@ -1202,30 +1341,9 @@ string_invariant SplitDBM::to_set() const {
                          this->g.elem(0, v) ? number_t(this->g.edge_val(0, v)) : extended_number::plus_infinity()};
         assert(!v_out.is_bottom());
 
-        variable_t variable = *pvar;
-
-        std::stringstream elem;
-        elem << variable;
-        if (variable.is_type()) {
-            auto [lb, ub] = v_out.bound(T_UNINIT, T_MAX);
-            if (lb == ub) {
-                if (variable.is_in_stack() && lb == T_NUM) {
-                    // no need to show this
-                    continue;
-                }
-                elem << "=" << lb;
-            } else {
-                elem << " in " << typeset_to_string(iterate_types(lb, ub));
-            }
-        } else {
-            elem << "=";
-            if (v_out.is_singleton()) {
-                elem << v_out.lb();
-            } else {
-                elem << v_out;
-            }
+        if (auto elem = bounds_to_string(*pvar, v_out)) {
+            result.insert(std::move(*elem));
         }
-        result.insert(elem.str());
     }
 
     return string_invariant{result};
@@ -1274,6 +1392,37 @@ interval_t SplitDBM::eval_interval(const linear_expression_t& e) const {
     return r;
 }
 
+std::optional<interval_t> SplitDBM::eval_range(const linear_expression_t& e) const {
+    const auto& terms = e.variable_terms();
+    if (terms.size() <= 1) {
+        // The bounds of a single variable are edges to and from the zero vertex.
+        return eval_interval(e);
+    }
+    if (terms.size() != 2) {
+        return {};
+    }
+    const auto& [first, first_coefficient] = *terms.begin();
+    const auto& [second, second_coefficient] = *std::next(terms.begin());
+    if (first_coefficient + second_coefficient != 0 || (first_coefficient != 1 && second_coefficient != 1)) {
+        return {};
+    }
+    const variable_t x = first_coefficient == 1 ? first : second;
+    const variable_t y = first_coefficient == 1 ? second : first;
+    // x - y is bounded by the intervals of x and y, and by the edges between them if there are any.
+    interval_t range = operator[](x) - operator[](y);
+    const auto vx = try_at(vert_map, x);
+    const auto vy = try_at(vert_map, y);
+    if (vx && vy) {
+        if (const auto w = g.lookup(*vy, *vx)) {
+            range = range & interval_t{extended_number::minus_infinity(), extended_number{number_t{*w}}};
+        }
+        if (const auto w = g.lookup(*vx, *vy)) {
+            range = range & interval_t{extended_number{-number_t{*w}}, extended_number::plus_infinity()};
+        }
+    }
+    return range + interval_t{e.constant_term()};
+}
+
 bool SplitDBM::intersect(const linear_constraint_t& cst) const {
     if (cst.is_contradiction()) {
         return false;
@@ -1281,6 +1430,14 @@ bool SplitDBM::intersect(const linear_constraint_t& cst) const {
     if (is_top() || cst.is_tautology()) {
         return true;
     }
+    if (const auto range = eval_range(cst.expression())) {
+        switch (cst.kind()) {
+        case constraint_kind_t::EQUALS_ZERO: return range->contains(0);
+        case constraint_kind_t::LESS_THAN_OR_EQUALS_ZERO: return range->lb() <= number_t(0);
+        case constraint_kind_t::LESS_THAN_ZERO: return range->lb() < number_t(0);
+        case constraint_kind_t::NOT_ZERO: return range->singleton() != std::optional(number_t(0));
+        }
+    }
     return intersect_aux(cst);
 }
 
@@ -1291,6 +1448,14 @@ bool SplitDBM::entail(const linear_constraint_t& rhs) const {
     if (rhs.is_contradiction()) {
         return false;
     }
+    if (const auto range = eval_range(rhs.expression())) {
+        switch (rhs.kind()) {
+        case constraint_kind_t::EQUALS_ZERO: return range->singleton() == std::optional(number_t(0));
+        case constraint_kind_t::LESS_THAN_OR_EQUALS_ZERO: return range->ub() <= number_t(0);
+        case constraint_kind_t::LESS_THAN_ZERO: return range->ub() < number_t(0);
+        case constraint_kind_t::NOT_ZERO: return !range->contains(0);
+        }
+    }
     const interval_t interval = eval_interval(rhs.expression());
     switch (rhs.kind()) {
     case constraint_kind_t::EQUALS_ZERO:
@@ -1367,4 +1532,15 @@ interval_t SplitDBM::get_interval(const variable_t x, const int finite_width) co
 
 interval_t SplitDBM::operator[](const variable_t x) const { return domains::get_interval(vert_map, g, x, 0); }
 
+std::vector<std::pair<variable_t, interval_t>> SplitDBM::intervals() const {
+    std::vector<std::pair<variable_t, interval_t>> res;
+    for (const auto& [v, vert] : vert_map) {
+        const interval_t intv = domains::get_interval(vert_map, g, v, 0);
+        if (!intv.is_top()) {
+            res.emplace_back(v, intv);
+        }
+    }
+    return res;
+}
+
 } // namespace crab::domains
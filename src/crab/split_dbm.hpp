@@ -43,6 +43,30 @@ enum class arith_binop_t { ADD, SUB, MUL, SDIV, UDIV, SREM, UREM };
 enum class bitwise_binop_t { AND, OR, XOR, SHL, LSHR, ASHR };
 using binop_t = std::variant<arith_binop_t, bitwise_binop_t>;
 
+// As defined in the BPF ISA specification, the immediate value of an unsigned modulo and division is treated
+// differently depending on the width:
+// * for 32 bit, as a 32-bit unsigned integer
+// * for 64 bit, as a 32-bit (not 64 bit) signed integer
+inline number_t read_imm_for_udiv_or_umod(const number_t& imm, const int width) {
+    assert(width == 32 || width == 64);
+    if (width == 32) {
+        return number_t{imm.cast_to<uint32_t>()};
+    }
+    return number_t{imm.cast_to<int32_t>()};
+}
+
+// As defined in the BPF ISA specification, the immediate value of a signed modulo and division is treated
+// differently depending on the width:
+// * for 32 bit, as a 32-bit signed integer
+// * for 64 bit, as a 64-bit signed integer
+inline number_t read_imm_for_sdiv_or_smod(const number_t& imm, const int width) {
+    assert(width == 32 || width == 64);
+    if (width == 32) {
+        return number_t{imm.cast_to<int32_t>()};
+    }
+    return number_t{imm.cast_to<int64_t>()};
+}
+
 namespace domains {
 
 class SplitDBM final {
@@ -130,6 +154,16 @@ class SplitDBM final {
 
     void normalize();
 
+    // The relations split the variables into packs, the sets of variables that they connect. For each vertex, whether
+    // o has its whole pack with the same vertices and the same edges, as it does for the packs that neither changed
+    // since one was copied from the other. Join, widening and inclusion leave such a pack as it is, so they skip it.
+    [[nodiscard]]
+    std::vector<bool> shared_packs(const SplitDBM& o) const;
+
+    // Whether every variable is in a pack that o shares, so that joining or widening with o changes nothing.
+    [[nodiscard]]
+    bool shares_all_packs(const std::vector<bool>& shared) const;
+
     SplitDBM(vert_map_t&& _vert_map, rev_map_t&& _rev_map, graph_t&& _g, std::vector<Weight>&& _potential,
              vert_set_t&& _unstable)
         : vert_map(std::move(_vert_map)), rev_map(std::move(_rev_map)), g(std::move(_g)),
@@ -264,10 +298,19 @@ class SplitDBM final {
 
     interval_t operator[](variable_t x) const;
 
+    // The bounds of each variable that has some.
+    [[nodiscard]]
+    std::vector<std::pair<variable_t, interval_t>> intervals() const;
+
     void set(variable_t x, const interval_t& intv);
 
     void forget(const variable_vector_t& variables);
 
+    // Keep the bounds of each variable, and at most per_variable_limit of its differences with other variables and
+    // total_limit differences in all, preferring those that are the tightest compared to what the bounds imply. A limit
+    // without a value is no limit. Return whether any difference was forgotten.
+    bool limit_relations(std::optional<std::size_t> per_variable_limit, std::optional<std::size_t> total_limit);
+
     // return number of vertices and edges
     [[nodiscard]]
     std::pair<std::size_t, std::size_t> size() const {
@@ -275,15 +318,21 @@ class SplitDBM final {
     }
 
   private:
+    // The range of e when e is a constant, a bound on one variable, or a difference of two variables plus a constant.
+    // It is read off the closed graph, so it is exact and needs no copy.
+    [[nodiscard]]
+    std::optional<interval_t> eval_range(const linear_expression_t& e) const;
+
+    // Decide the constraints that eval_range cannot, by adding them to a scratch copy.
     [[nodiscard]]
     bool entail_aux(const linear_constraint_t& cst) const {
-        // copy is necessary
+        // The copy shares the graph, and only clones the rows that adding the constraint changes.
         return !SplitDBM(*this).add_constraint(cst.negate());
     }
 
     [[nodiscard]]
     bool intersect_aux(const linear_constraint_t& cst) const {
-        // copy is necessary
+        // The copy shares the graph, and only clones the rows that adding the constraint changes.
         return SplitDBM(*this).add_constraint(cst);
     }
 
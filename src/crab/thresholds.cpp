@@ -49,14 +49,14 @@ std::ostream& operator<<(std::ostream& o, const thresholds_t& t) {
     return o;
 }
 
-void wto_thresholds_t::get_thresholds(const label_t& label, thresholds_t& thresholds) const {}
+void wto_thresholds_t::get_thresholds(const node_id_t node, thresholds_t& thresholds) const {}
 
-void wto_thresholds_t::operator()(const label_t& vertex) {
+void wto_thresholds_t::operator()(const node_id_t vertex) {
     if (m_stack.empty()) {
         return;
     }
 
-    const label_t head = m_stack.back();
+    const node_id_t head = m_stack.back();
     const auto it = m_head_to_thresholds.find(head);
     if (it != m_head_to_thresholds.end()) {
         thresholds_t& thresholds = it->second;
@@ -68,12 +68,12 @@ void wto_thresholds_t::operator()(const label_t& vertex) {
 
 void wto_thresholds_t::operator()(const std::shared_ptr<wto_cycle_t>& cycle) {
     thresholds_t thresholds(m_max_size);
-    const auto& head = cycle->head();
+    const node_id_t head = cycle->head();
     get_thresholds(head, thresholds);
 
     // XXX: if we want to consider constants from loop
     // initializations
-    for (const auto& pre : m_cfg.parents_of(head)) {
+    for (const node_id_t pre : m_cfg.parents_of(head)) {
         if (pre != head) {
             get_thresholds(pre, thresholds);
         }
@@ -88,8 +88,8 @@ void wto_thresholds_t::operator()(const std::shared_ptr<wto_cycle_t>& cycle) {
 }
 
 std::ostream& operator<<(std::ostream& o, const wto_thresholds_t& t) {
-    for (const auto& [label, th] : t.m_head_to_thresholds) {
-        o << to_string(label) << "=" << th << "\n";
+    for (const auto& [head, th] : t.m_head_to_thresholds) {
+        o << to_string(t.m_cfg.label(head)) << "=" << th << "\n";
     }
     return o;
 }
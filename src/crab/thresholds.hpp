@@ -50,20 +50,20 @@ class thresholds_t final {
 class wto_thresholds_t final {
   private:
     // the cfg
-    cfg_t& m_cfg;
+    const frozen_cfg_t& m_cfg;
     // maximum number of thresholds
     size_t m_max_size;
     // keep a set of thresholds per wto head
-    std::map<label_t, thresholds_t> m_head_to_thresholds;
+    std::map<node_id_t, thresholds_t> m_head_to_thresholds;
     // the top of the stack is the current wto head
-    std::vector<label_t> m_stack;
+    std::vector<node_id_t> m_stack;
 
-    void get_thresholds(const label_t& label, thresholds_t& thresholds) const;
+    void get_thresholds(node_id_t node, thresholds_t& thresholds) const;
 
   public:
-    wto_thresholds_t(cfg_t& cfg, const size_t max_size) : m_cfg(cfg), m_max_size(max_size) {}
+    wto_thresholds_t(const frozen_cfg_t& cfg, const size_t max_size) : m_cfg(cfg), m_max_size(max_size) {}
 
-    void operator()(const label_t& vertex);
+    void operator()(node_id_t vertex);
 
     void operator()(const std::shared_ptr<wto_cycle_t>& cycle);
 
@@ -5,6 +5,8 @@
 // This file is eBPF-specific, not derived from CRAB.
 #include <functional>
 #include <map>
+#include <utility>
+#include <vector>
 #include <optional>
 
 #include "crab/array_domain.hpp"
@@ -135,21 +137,16 @@ reg_pack_t reg_pack(const int i) {
     };
 }
 
-void TypeDomain::add_extra_invariant(const NumAbsDomain& dst, std::map<variable_t, interval_t>& extra_invariants,
-                                     const variable_t type_variable, const type_encoding_t type, const data_kind_t kind,
-                                     const NumAbsDomain& src) const {
-    const bool dst_has_type = has_type(dst, type_variable, type);
-    const bool src_has_type = has_type(src, type_variable, type);
-    variable_t v = variable_t::kind_var(kind, type_variable);
-
-    // If type is contained in exactly one of dst or src,
-    // we need to remember the value.
-    if (dst_has_type && !src_has_type) {
-        extra_invariants.emplace(v, dst.eval_interval(v));
-    } else if (!dst_has_type && src_has_type) {
-        extra_invariants.emplace(v, src.eval_interval(v));
-    }
-}
+// The kinds of the variables that are specific to some types, and the types for which they are meaningful.
+static constexpr std::pair<data_kind_t, TypeSet> type_specific_kinds[]{
+    {data_kind_t::ctx_offsets, {T_CTX}},
+    {data_kind_t::map_fds, {T_MAP, T_MAP_PROGRAMS}},
+    {data_kind_t::packet_offsets, {T_PACKET}},
+    {data_kind_t::shared_offsets, {T_SHARED}},
+    {data_kind_t::stack_offsets, {T_STACK}},
+    {data_kind_t::shared_region_sizes, {T_SHARED}},
+    {data_kind_t::stack_numeric_sizes, {T_STACK}},
+};
 
 void TypeDomain::selectively_join_based_on_type(NumAbsDomain& dst, NumAbsDomain&& src) const {
     // Some variables are type-specific.  Type-specific variables
@@ -176,17 +173,22 @@ void TypeDomain::selectively_join_based_on_type(NumAbsDomain& dst, NumAbsDomain&
     // Output:
     //   r1.type={stack,packet}, r1.stack_offset=100, r1.packet_offset=4
 
-    std::map<variable_t, interval_t> extra_invariants;
+    std::vector<std::pair<variable_t, interval_t>> extra_invariants;
     if (!dst.is_bottom()) {
-        for (const variable_t v : variable_t::get_type_variables()) {
-            add_extra_invariant(dst, extra_invariants, v, T_CTX, data_kind_t::ctx_offsets, src);
-            add_extra_invariant(dst, extra_invariants, v, T_MAP, data_kind_t::map_fds, src);
-            add_extra_invariant(dst, extra_invariants, v, T_MAP_PROGRAMS, data_kind_t::map_fds, src);
-            add_extra_invariant(dst, extra_invariants, v, T_PACKET, data_kind_t::packet_offsets, src);
-            add_extra_invariant(dst, extra_invariants, v, T_SHARED, data_kind_t::shared_offsets, src);
-            add_extra_invariant(dst, extra_invariants, v, T_STACK, data_kind_t::stack_offsets, src);
-            add_extra_invariant(dst, extra_invariants, v, T_SHARED, data_kind_t::shared_region_sizes, src);
-            add_extra_invariant(dst, extra_invariants, v, T_STACK, data_kind_t::stack_numeric_sizes, src);
+        for (const variable_t type_variable : variable_t::get_type_variables()) {
+            const TypeSet dst_types = get_type_set(dst, type_variable);
+            const TypeSet src_types = get_type_set(src, type_variable);
+            if (dst_types == src_types) {
+                continue;
+            }
+            for (const auto& [kind, types] : type_specific_kinds) {
+                // If the kind is meaningful in exactly one of dst or src, we need to remember the value.
+                const bool in_dst = dst_types.intersects(types);
+                if (in_dst != src_types.intersects(types)) {
+                    const variable_t v = variable_t::kind_var(kind, type_variable);
+                    extra_invariants.emplace_back(v, (in_dst ? dst : src).eval_interval(v));
+                }
+            }
         }
     }
 
@@ -229,6 +231,18 @@ type_encoding_t TypeDomain::get_type(const NumAbsDomain& inv, const Reg& r) cons
     return res->narrow<type_encoding_t>();
 }
 
+TypeSet TypeDomain::get_type_set(const NumAbsDomain& inv, const linear_expression_t& v) const {
+    const interval_t interval = inv.eval_interval(v);
+    if (interval.is_bottom()) {
+        return {};
+    }
+    if (!(interval <= interval_t{T_MIN, T_MAX})) {
+        return TypeSet::all();
+    }
+    const auto [lb, ub] = interval.bound(T_MIN, T_MAX);
+    return TypeSet::range(lb, ub);
+}
+
 // Check whether a given type value is within the range of a given type variable's value.
 bool TypeDomain::has_type(const NumAbsDomain& inv, const Reg& r, const type_encoding_t type) const {
     const interval_t interval = inv.eval_interval(reg_pack(r).type);
@@ -242,8 +256,8 @@ bool TypeDomain::has_type(const NumAbsDomain& inv, const linear_expression_t& v,
 
 NumAbsDomain TypeDomain::join_over_types(const NumAbsDomain& inv, const Reg& reg,
                                          const std::function<void(NumAbsDomain&, type_encoding_t)>& transition) const {
-    interval_t types = inv.eval_interval(reg_pack(reg).type);
-    if (types.is_bottom()) {
+    const TypeSet types = get_type_set(inv, reg_pack(reg).type);
+    if (types.empty()) {
         return NumAbsDomain::bottom();
     }
     if (types.contains(T_UNINIT)) {
@@ -251,12 +265,19 @@ NumAbsDomain TypeDomain::join_over_types(const NumAbsDomain& inv, const Reg& reg
         transition(res, T_UNINIT);
         return res;
     }
+    if (const auto type = types.singleton()) {
+        // A single type needs no join.
+        NumAbsDomain res(inv);
+        transition(res, *type);
+        return res;
+    }
     NumAbsDomain res = NumAbsDomain::bottom();
-    auto [lb, ub] = types.bound(T_MIN, T_MAX);
-    for (type_encoding_t type : iterate_types(lb, ub)) {
-        NumAbsDomain tmp(inv);
-        transition(tmp, type);
-        selectively_join_based_on_type(res, std::move(tmp)); // res |= tmp;
+    for (const type_encoding_t type : iterate_types(T_MIN, T_MAX)) {
+        if (types.contains(type)) {
+            NumAbsDomain tmp(inv);
+            transition(tmp, type);
+            selectively_join_based_on_type(res, std::move(tmp)); // res |= tmp;
+        }
     }
     return res;
 }
@@ -288,24 +309,7 @@ bool TypeDomain::implies_type(const NumAbsDomain& inv, const linear_constraint_t
 }
 
 bool TypeDomain::is_in_group(const NumAbsDomain& inv, const Reg& r, const TypeGroup group) const {
-    using namespace crab::dsl_syntax;
-    const variable_t t = reg_pack(r).type;
-    switch (group) {
-    case TypeGroup::number: return inv.entail(t == T_NUM);
-    case TypeGroup::map_fd: return inv.entail(t == T_MAP);
-    case TypeGroup::map_fd_programs: return inv.entail(t == T_MAP_PROGRAMS);
-    case TypeGroup::ctx: return inv.entail(t == T_CTX);
-    case TypeGroup::packet: return inv.entail(t == T_PACKET);
-    case TypeGroup::stack: return inv.entail(t == T_STACK);
-    case TypeGroup::shared: return inv.entail(t == T_SHARED);
-    case TypeGroup::mem: return inv.entail(t >= T_PACKET);
-    case TypeGroup::mem_or_num: return inv.entail(t >= T_NUM) && inv.entail(t != T_CTX);
-    case TypeGroup::pointer: return inv.entail(t >= T_CTX);
-    case TypeGroup::ptr_or_num: return inv.entail(t >= T_NUM);
-    case TypeGroup::stack_or_packet: return inv.entail(t >= T_PACKET) && inv.entail(t <= T_STACK);
-    case TypeGroup::singleton_ptr: return inv.entail(t >= T_CTX) && inv.entail(t <= T_STACK);
-    default: CRAB_ERROR("Unsupported type group", group);
-    }
+    return get_type_set(inv, reg_pack(r).type).is_subset_of(to_type_set(group));
 }
 
 std::string typeset_to_string(const std::vector<type_encoding_t>& items) {
@@ -334,6 +338,25 @@ bool is_singleton_type(const TypeGroup t) {
     }
 }
 
+TypeSet to_type_set(const TypeGroup group) {
+    switch (group) {
+    case TypeGroup::number: return {T_NUM};
+    case TypeGroup::map_fd: return {T_MAP};
+    case TypeGroup::map_fd_programs: return {T_MAP_PROGRAMS};
+    case TypeGroup::ctx: return {T_CTX};
+    case TypeGroup::packet: return {T_PACKET};
+    case TypeGroup::stack: return {T_STACK};
+    case TypeGroup::shared: return {T_SHARED};
+    case TypeGroup::mem: return {T_PACKET, T_STACK, T_SHARED};
+    case TypeGroup::mem_or_num: return {T_NUM, T_PACKET, T_STACK, T_SHARED};
+    case TypeGroup::pointer: return {T_CTX, T_PACKET, T_STACK, T_SHARED};
+    case TypeGroup::ptr_or_num: return {T_NUM, T_CTX, T_PACKET, T_STACK, T_SHARED};
+    case TypeGroup::stack_or_packet: return {T_PACKET, T_STACK};
+    case TypeGroup::singleton_ptr: return {T_CTX, T_PACKET, T_STACK};
+    default: CRAB_ERROR("Unsupported type group", group);
+    }
+}
+
 std::ostream& operator<<(std::ostream& os, const TypeGroup ts) {
     using namespace crab;
     static const std::map<TypeGroup, std::string> string_to_type{
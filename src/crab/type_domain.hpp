@@ -46,6 +46,12 @@ struct TypeDomain {
     [[nodiscard]]
     type_encoding_t get_type(const NumAbsDomain& inv, const Reg& r) const;
 
+    /// The types that v may have in inv, or all types if inv allows a value that is not a type.
+    /// The type variables live in the numeric domain, so the set is read off their interval: it holds every type
+    /// between the lowest and the highest possible one.
+    [[nodiscard]]
+    TypeSet get_type_set(const NumAbsDomain& inv, const linear_expression_t& v) const;
+
     [[nodiscard]]
     bool has_type(const NumAbsDomain& inv, const linear_expression_t& v, type_encoding_t type) const;
     [[nodiscard]]
@@ -56,6 +62,8 @@ struct TypeDomain {
     [[nodiscard]]
     bool implies_type(const NumAbsDomain& inv, const linear_constraint_t& a, const linear_constraint_t& b) const;
 
+    /// Apply transition to inv for each type that reg may have, and join the results.
+    /// Each type gets its own copy of the whole numerical domain, including when reg has a single type.
     [[nodiscard]]
     NumAbsDomain join_over_types(const NumAbsDomain& inv, const Reg& reg,
                                  const std::function<void(NumAbsDomain&, type_encoding_t)>& transition) const;
@@ -64,9 +72,6 @@ struct TypeDomain {
                                  const std::function<void(NumAbsDomain&)>& if_true,
                                  const std::function<void(NumAbsDomain&)>& if_false) const;
     void selectively_join_based_on_type(NumAbsDomain& dst, NumAbsDomain&& src) const;
-    void add_extra_invariant(const NumAbsDomain& dst, std::map<variable_t, interval_t>& extra_invariants,
-                             variable_t type_variable, type_encoding_t type, data_kind_t kind,
-                             const NumAbsDomain& src) const;
 
     [[nodiscard]]
     bool is_in_group(const NumAbsDomain& inv, const Reg& r, TypeGroup group) const;
@@ -3,6 +3,10 @@
 
 #pragma once
 
+#include <bit>
+#include <cstdint>
+#include <initializer_list>
+#include <optional>
 #include <string>
 
 namespace crab {
@@ -49,6 +53,72 @@ std::string typeset_to_string(const std::vector<type_encoding_t>& items);
 std::ostream& operator<<(std::ostream& os, type_encoding_t s);
 type_encoding_t string_to_type_encoding(const std::string& s);
 
+/// A set of types, as a bitmask over type_encoding_t. Sets are ordered by inclusion and joined by union.
+/// It answers queries about the types a register may have, such as group membership. It is not where types are
+/// stored: the type variables stay in the numerical domain, which relates them to other variables.
+class TypeSet final {
+    uint8_t _bits{};
+
+    static constexpr uint8_t bit(const type_encoding_t type) { return static_cast<uint8_t>(1u << (type - T_MIN)); }
+
+    explicit constexpr TypeSet(const uint8_t bits) : _bits(bits) {}
+
+  public:
+    constexpr TypeSet() = default;
+
+    constexpr TypeSet(const std::initializer_list<type_encoding_t> types) {
+        for (const type_encoding_t type : types) {
+            _bits |= bit(type);
+        }
+    }
+
+    /// The set of the types in [lb, ub].
+    static constexpr TypeSet range(const type_encoding_t lb, const type_encoding_t ub) {
+        if (lb > ub) {
+            return {};
+        }
+        return TypeSet{static_cast<uint8_t>((bit(ub) << 1) - bit(lb))};
+    }
+
+    static constexpr TypeSet all() { return range(T_MIN, T_MAX); }
+
+    [[nodiscard]]
+    constexpr bool empty() const {
+        return _bits == 0;
+    }
+
+    [[nodiscard]]
+    constexpr bool contains(const type_encoding_t type) const {
+        return (_bits & bit(type)) != 0;
+    }
+
+    [[nodiscard]]
+    constexpr bool intersects(const TypeSet other) const {
+        return (_bits & other._bits) != 0;
+    }
+
+    [[nodiscard]]
+    constexpr bool is_subset_of(const TypeSet other) const {
+        return (_bits & ~other._bits) == 0;
+    }
+
+    [[nodiscard]]
+    constexpr std::optional<type_encoding_t> singleton() const {
+        if (_bits == 0 || (_bits & (_bits - 1)) != 0) {
+            return {};
+        }
+        return static_cast<type_encoding_t>(T_MIN + std::countr_zero(_bits));
+    }
+
+    constexpr TypeSet operator|(const TypeSet other) const {
+        return TypeSet{static_cast<uint8_t>(_bits | other._bits)};
+    }
+    constexpr TypeSet operator&(const TypeSet other) const {
+        return TypeSet{static_cast<uint8_t>(_bits & other._bits)};
+    }
+    constexpr bool operator==(const TypeSet&) const = default;
+};
+
 enum class TypeGroup {
     number,
     map_fd,
@@ -66,5 +136,6 @@ enum class TypeGroup {
 };
 
 bool is_singleton_type(TypeGroup t);
+TypeSet to_type_set(TypeGroup group);
 std::ostream& operator<<(std::ostream& os, TypeGroup ts);
 } // namespace crab
@@ -4,144 +4,80 @@
  * Factories for variable names.
  */
 
+#include <sstream>
+
+#include <gsl/narrow>
+
 #include "crab/label.hpp"
 #include "crab/variable.hpp"
+#include "crab_utils/debug.hpp"
 #include "crab_utils/lazy_allocator.hpp"
 
 namespace crab {
 
-variable_t variable_t::make(const std::string& name) {
-    const auto it = std::find(names->begin(), names->end(), name);
-    if (it == names->end()) {
-        names->emplace_back(name);
-        return variable_t(names->size() - 1);
+struct variable_t::shared_names_t {
+    variable_registry_t* names;
+    std::mutex mutex;
+};
+
+static thread_local std::shared_ptr<variable_t::shared_names_t> thread_local_shared_names;
+
+variable_registry_t& variable_t::current_names() {
+    if (thread_local_shared_names) {
+        return *thread_local_shared_names->names;
+    }
+    return *names;
+}
+
+std::mutex* variable_t::current_names_mutex() {
+    return thread_local_shared_names ? &thread_local_shared_names->mutex : nullptr;
+}
+
+std::shared_ptr<variable_t::shared_names_t> variable_t::share_names() {
+    if (!thread_local_shared_names) {
+        thread_local_shared_names = std::make_shared<shared_names_t>(&names.get());
     }
-    return variable_t(std::distance(names->begin(), it));
+    return thread_local_shared_names;
+}
+
+void variable_t::use_shared_names(std::shared_ptr<shared_names_t> shared) {
+    thread_local_shared_names = std::move(shared);
+}
+
+uint64_t variable_t::intern(std::vector<std::string> variable_registry_t::*table, const std::string& s) {
+    return with_names([&](variable_registry_t& registry) {
+        std::vector<std::string>& all = registry.*table;
+        const auto it = std::find(all.begin(), all.end(), s);
+        if (it == all.end()) {
+            all.emplace_back(s);
+            return gsl::narrow<uint64_t>(all.size() - 1);
+        }
+        return gsl::narrow<uint64_t>(std::distance(all.begin(), it));
+    });
 }
 
-std::vector<std::string> default_variable_names() {
-    return std::vector<std::string>{
-        "r0.svalue",
-        "r0.uvalue",
-        "r0.ctx_offset",
-        "r0.map_fd",
-        "r0.packet_offset",
-        "r0.shared_offset",
-        "r0.stack_offset",
-        "r0.type",
-        "r0.shared_region_size",
-        "r0.stack_numeric_size",
-        "r1.svalue",
-        "r1.uvalue",
-        "r1.ctx_offset",
-        "r1.map_fd",
-        "r1.packet_offset",
-        "r1.shared_offset",
-        "r1.stack_offset",
-        "r1.type",
-        "r1.shared_region_size",
-        "r1.stack_numeric_size",
-        "r2.svalue",
-        "r2.uvalue",
-        "r2.ctx_offset",
-        "r2.map_fd",
-        "r2.packet_offset",
-        "r2.shared_offset",
-        "r2.stack_offset",
-        "r2.type",
-        "r2.shared_region_size",
-        "r2.stack_numeric_size",
-        "r3.svalue",
-        "r3.uvalue",
-        "r3.ctx_offset",
-        "r3.map_fd",
-        "r3.packet_offset",
-        "r3.shared_offset",
-        "r3.stack_offset",
-        "r3.type",
-        "r3.shared_region_size",
-        "r3.stack_numeric_size",
-        "r4.svalue",
-        "r4.uvalue",
-        "r4.ctx_offset",
-        "r4.map_fd",
-        "r4.packet_offset",
-        "r4.shared_offset",
-        "r4.stack_offset",
-        "r4.type",
-        "r4.shared_region_size",
-        "r4.stack_numeric_size",
-        "r5.svalue",
-        "r5.uvalue",
-        "r5.ctx_offset",
-        "r5.map_fd",
-        "r5.packet_offset",
-        "r5.shared_offset",
-        "r5.stack_offset",
-        "r5.type",
-        "r5.shared_region_size",
-        "r5.stack_numeric_size",
-        "r6.svalue",
-        "r6.uvalue",
-        "r6.ctx_offset",
-        "r6.map_fd",
-        "r6.packet_offset",
-        "r6.shared_offset",
-        "r6.stack_offset",
-        "r6.type",
-        "r6.shared_region_size",
-        "r6.stack_numeric_size",
-        "r7.svalue",
-        "r7.uvalue",
-        "r7.ctx_offset",
-        "r7.map_fd",
-        "r7.packet_offset",
-        "r7.shared_offset",
-        "r7.stack_offset",
-        "r7.type",
-        "r7.shared_region_size",
-        "r7.stack_numeric_size",
-        "r8.svalue",
-        "r8.uvalue",
-        "r8.ctx_offset",
-        "r8.map_fd",
-        "r8.packet_offset",
-        "r8.shared_offset",
-        "r8.stack_offset",
-        "r8.type",
-        "r8.shared_region_size",
-        "r8.stack_numeric_size",
-        "r9.svalue",
-        "r9.uvalue",
-        "r9.ctx_offset",
-        "r9.map_fd",
-        "r9.packet_offset",
-        "r9.shared_offset",
-        "r9.stack_offset",
-        "r9.type",
-        "r9.shared_region_size",
-        "r9.stack_numeric_size",
-        "r10.svalue",
-        "r10.uvalue",
-        "r10.ctx_offset",
-        "r10.map_fd",
-        "r10.packet_offset",
-        "r10.shared_offset",
-        "r10.stack_offset",
-        "r10.type",
-        "r10.shared_region_size",
-        "r10.stack_numeric_size",
-        "data_size",
-        "meta_size",
-    };
+variable_t variable_t::registered(const variable_t v) {
+    if (v.tag() != tag_t::reg && v.is_type()) {
+        with_names([&](variable_registry_t& registry) {
+            if (registry.known_type_variables.insert(v._id).second) {
+                registry.type_variables.push_back(v._id);
+            }
+        });
+    }
+    return v;
 }
 
-thread_local lazy_allocator<std::vector<std::string>, default_variable_names> variable_t::names;
+thread_local lazy_allocator<variable_registry_t> variable_t::names;
 
 void variable_t::clear_thread_local_state() { names.clear(); }
 
+void variable_t::swap_thread_local_state(lazy_allocator<variable_registry_t>& registry) { names.swap(registry); }
+
+static constexpr int REG_SHIFT = 4;
+static constexpr int INDEX_SHIFT = 8;
+
 variable_t variable_t::reg(const data_kind_t kind, const int i) {
-    return make("r" + std::to_string(i) + "." + name_of(kind));
+    return make(tag_t::reg, gsl::narrow<uint64_t>(i) << REG_SHIFT | kind_bits(kind));
 }
 
 std::ostream& operator<<(std::ostream& o, const data_kind_t& s) { return o << name_of(s); }
@@ -157,47 +93,95 @@ static std::string mk_scalar_name(const data_kind_t kind, const number_t& o, con
 }
 
 variable_t variable_t::stack_frame_var(const data_kind_t kind, const int i, const std::string& prefix) {
-    return make(prefix + STACK_FRAME_DELIMITER + "r" + std::to_string(i) + "." + name_of(kind));
+    const uint64_t prefix_index = intern(&variable_registry_t::stack_frame_prefixes, prefix);
+    return registered(make(tag_t::stack_frame, prefix_index << INDEX_SHIFT |
+                                                   gsl::narrow<uint64_t>(i) << REG_SHIFT |
+                                                   kind_bits(kind)));
 }
 
 variable_t variable_t::cell_var(const data_kind_t array, const number_t& offset, const number_t& size) {
-    return make(mk_scalar_name(array, offset.cast_to<uint64_t>(), size));
+    const auto o = offset.cast_to<uint64_t>();
+    if (o < uint64_t{1} << CELL_OFFSET_BITS && size >= 0 && size < number_t{1} << CELL_SIZE_BITS) {
+        return registered(make(tag_t::cell, o << (CELL_SIZE_BITS + 4) | size.narrow<uint64_t>() << 4 |
+                                                kind_bits(array)));
+    }
+    const uint64_t index = with_names([&](variable_registry_t& registry) {
+        auto& all = registry.large_cells;
+        const auto it = std::find(all.begin(), all.end(), std::pair{o, size});
+        if (it == all.end()) {
+            all.emplace_back(o, size);
+            return gsl::narrow<uint64_t>(all.size() - 1);
+        }
+        return gsl::narrow<uint64_t>(std::distance(all.begin(), it));
+    });
+    return registered(make(tag_t::large_cell, index << 4 | kind_bits(array)));
 }
 
 // Given a type variable, get the associated variable of a given kind.
 variable_t variable_t::kind_var(const data_kind_t kind, const variable_t type_variable) {
-    const std::string name = type_variable.name();
-    return make(name.substr(0, name.rfind('.') + 1) + name_of(kind));
+    return registered(variable_t{(type_variable._id & ~KIND_MASK) | kind_bits(kind)});
 }
 
-variable_t variable_t::meta_offset() { return make("meta_offset"); }
-variable_t variable_t::packet_size() { return make("packet_size"); }
-variable_t variable_t::loop_counter(const std::string& label) { return make("pc[" + label + "]"); }
+variable_t variable_t::meta_offset() { return make(tag_t::special, 0); }
+variable_t variable_t::packet_size() { return make(tag_t::special, 1); }
+variable_t variable_t::loop_counter(const std::string& label) {
+    return make(tag_t::loop_counter, intern(&variable_registry_t::loop_counter_labels, label));
+}
 
-static bool ends_with(const std::string& str, const std::string& suffix) {
-    return str.size() >= suffix.size() && 0 == str.compare(str.size() - suffix.size(), suffix.size(), suffix);
+std::string variable_t::name() const {
+    const uint64_t payload = _id & ((uint64_t{1} << TAG_SHIFT) - 1);
+    switch (tag()) {
+    case tag_t::reg: return "r" + std::to_string(payload >> REG_SHIFT) + "." + name_of(kind());
+    case tag_t::stack_frame: {
+        const std::string prefix = with_names([&](const variable_registry_t& registry) {
+            return registry.stack_frame_prefixes.at(payload >> INDEX_SHIFT);
+        });
+        return prefix + STACK_FRAME_DELIMITER + "r" + std::to_string((payload >> REG_SHIFT) & 0xF) + "." +
+               name_of(kind());
+    }
+    case tag_t::cell: {
+        const uint64_t size = (payload >> 4) & ((uint64_t{1} << CELL_SIZE_BITS) - 1);
+        return mk_scalar_name(kind(), payload >> (CELL_SIZE_BITS + 4), size);
+    }
+    case tag_t::large_cell: {
+        const auto [offset, size] = with_names(
+            [&](const variable_registry_t& registry) { return registry.large_cells.at(payload >> 4); });
+        return mk_scalar_name(kind(), offset, size);
+    }
+    case tag_t::loop_counter: {
+        const std::string label =
+            with_names([&](const variable_registry_t& registry) { return registry.loop_counter_labels.at(payload); });
+        return "pc[" + label + "]";
+    }
+    case tag_t::special: return payload == 0 ? "meta_offset" : "packet_size";
+    }
+    CRAB_ERROR("unexpected variable id ", _id);
 }
 
 std::vector<variable_t> variable_t::get_type_variables() {
     std::vector<variable_t> res;
-    for (const std::string& name : *names) {
-        if (ends_with(name, ".type")) {
-            res.push_back(make(name));
-        }
+    for (int i = 0; i <= 10; i++) {
+        res.push_back(reg(data_kind_t::types, i));
     }
+    with_names([&](const variable_registry_t& registry) {
+        for (const uint64_t id : registry.type_variables) {
+            res.push_back(variable_t{id});
+        }
+    });
     return res;
 }
 
-bool variable_t::is_in_stack() const { return this->name()[0] == 's'; }
+bool variable_t::is_in_stack() const { return tag() == tag_t::cell || tag() == tag_t::large_cell; }
 
 bool variable_t::printing_order(const variable_t& a, const variable_t& b) { return a.name() < b.name(); }
 
 std::vector<variable_t> variable_t::get_loop_counters() {
+    const size_t count = with_names([](const variable_registry_t& registry) {
+        return registry.loop_counter_labels.size();
+    });
     std::vector<variable_t> res;
-    for (const std::string& name : *names) {
-        if (name.find("pc") == 0) {
-            res.push_back(make(name));
-        }
+    for (size_t i = 0; i < count; i++) {
+        res.push_back(make(tag_t::loop_counter, i));
     }
     return res;
 }
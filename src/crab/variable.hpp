@@ -4,7 +4,12 @@
 
 #include <iosfwd>
 #include <iostream>
+#include <iterator>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "crab/type_encoding.hpp"
@@ -13,15 +18,100 @@
 
 namespace crab {
 
-std::vector<std::string> default_variable_names();
+/// The strings and variables that variable_t ids refer to, and that cannot be derived from the ids alone.
+struct variable_registry_t {
+    std::vector<std::string> stack_frame_prefixes;
+    std::vector<std::string> loop_counter_labels;
+    /// Offset and size of the stack cells too large to be encoded in an id.
+    std::vector<std::pair<uint64_t, number_t>> large_cells;
+    /// Type variables other than those of the registers, in the order they were made.
+    std::vector<uint64_t> type_variables;
+    std::unordered_set<uint64_t> known_type_variables;
+};
 
 // Wrapper for typed variables used by the crab abstract domains and linear_constraints.
 // Being a class (instead of a type alias) enables overloading in dsl_syntax
+//
+// The id of a variable encodes what the variable is, so that making and classifying variables does not look
+// anything up. From the most significant bits down:
+//   register:          tag | register number (4 bits) | kind (4 bits)
+//   stack frame copy:  tag | prefix index (32 bits) | register number (4 bits) | kind (4 bits)
+//   stack cell:        tag | offset (32 bits) | size (24 bits) | kind (4 bits)
+//   large stack cell:  tag | index of offset and size (32 bits) | kind (4 bits)
+//   loop counter:      tag | label index (32 bits)
+//   special:           tag | which one
+// Only the prefixes, the labels and the large cells are kept in the registry, and names are built when printing.
 class variable_t final {
     uint64_t _id;
 
     explicit variable_t(const uint64_t id) : _id(id) {}
 
+    enum class tag_t : uint64_t { reg, special, stack_frame, cell, large_cell, loop_counter };
+    static constexpr int TAG_SHIFT = 60;
+    static constexpr uint64_t KIND_MASK = 0xF;
+    static constexpr int CELL_SIZE_BITS = 24;
+    static constexpr int CELL_OFFSET_BITS = TAG_SHIFT - CELL_SIZE_BITS - 4;
+
+    [[nodiscard]]
+    tag_t tag() const {
+        return static_cast<tag_t>(_id >> TAG_SHIFT);
+    }
+
+    /// Whether the low bits of the id are a data_kind_t.
+    [[nodiscard]]
+    bool has_kind() const {
+        return tag() != tag_t::special && tag() != tag_t::loop_counter;
+    }
+
+    // Kinds are ordered in ids as the variables of a register have always been ordered. The numerical domain
+    // is not entirely insensitive to the order of its variables, so this keeps its results unchanged.
+    static constexpr data_kind_t KIND_ORDER[] = {
+        data_kind_t::svalues,        data_kind_t::uvalues,       data_kind_t::ctx_offsets,
+        data_kind_t::map_fds,        data_kind_t::packet_offsets, data_kind_t::shared_offsets,
+        data_kind_t::stack_offsets,  data_kind_t::types,         data_kind_t::shared_region_sizes,
+        data_kind_t::stack_numeric_sizes,
+    };
+
+    static constexpr uint64_t kind_bits(const data_kind_t kind) {
+        for (uint64_t i = 0; i < std::size(KIND_ORDER); i++) {
+            if (KIND_ORDER[i] == kind) {
+                return i;
+            }
+        }
+        return KIND_MASK;
+    }
+
+    [[nodiscard]]
+    data_kind_t kind() const {
+        return KIND_ORDER[_id & KIND_MASK];
+    }
+
+    static variable_t make(tag_t tag, uint64_t payload) {
+        return variable_t{static_cast<uint64_t>(tag) << TAG_SHIFT | payload};
+    }
+
+    /// The registry used by the current thread, which is another thread's registry while it is shared.
+    static variable_registry_t& current_names();
+
+    /// The mutex serializing accesses to the current registry, or nullptr if it is not shared.
+    static std::mutex* current_names_mutex();
+
+    /// Call f on the current registry, holding the lock if it is shared with other threads.
+    template <typename F>
+    static auto with_names(F&& f) {
+        if (std::mutex* mutex = current_names_mutex()) {
+            std::lock_guard lock(*mutex);
+            return f(current_names());
+        }
+        return f(current_names());
+    }
+
+    /// Index of a string in a table of the registry, adding it if needed.
+    static uint64_t intern(std::vector<std::string> variable_registry_t::*table, const std::string& s);
+
+    /// Record a variable of kind types made from its parts, so that get_type_variables() finds it.
+    static variable_t registered(variable_t v);
+
   public:
     [[nodiscard]]
     std::size_t hash() const {
@@ -36,36 +126,54 @@ class variable_t final {
     bool operator<(const variable_t o) const { return _id < o._id; }
 
     [[nodiscard]]
-    std::string name() const {
-        return names->at(_id);
-    }
+    std::string name() const;
 
     [[nodiscard]]
     bool is_type() const {
-        return names->at(_id).find(".type") != std::string::npos;
+        return has_kind() && (_id & KIND_MASK) == kind_bits(data_kind_t::types);
     }
 
     [[nodiscard]]
     bool is_unsigned() const {
-        return names->at(_id).find(".uvalue") != std::string::npos;
+        return has_kind() && (_id & KIND_MASK) == kind_bits(data_kind_t::uvalues);
     }
 
-    friend std::ostream& operator<<(std::ostream& o, const variable_t v) { return o << names->at(v._id); }
+    /// Whether this is a copy of a callee-saved register made at a call.
+    [[nodiscard]]
+    bool is_stack_frame_var() const {
+        return tag() == tag_t::stack_frame;
+    }
+
+    friend std::ostream& operator<<(std::ostream& o, const variable_t v) { return o << v.name(); }
 
     // var_factory portion.
     // This singleton is eBPF-specific, to avoid lifetime issues and/or passing factory explicitly everywhere:
   private:
-    static variable_t make(const std::string& name);
+    static thread_local lazy_allocator<variable_registry_t> names;
+
+  public:
+    static void clear_thread_local_state();
+
+    /// Exchange the variable registry of the calling thread with that of a verifier context.
+    static void swap_thread_local_state(lazy_allocator<variable_registry_t>& registry);
+
+    /// Variable registry of one thread, made accessible to other threads.
+    struct shared_names_t;
 
     /**
-     * @brief Factory to always return the initial variable names.
+     * @brief Share the calling thread's variable registry with other threads.
+     * Until sharing stops, every access to the registry from the calling thread takes a lock.
      *
-     * @tparam[in] T Should always be std::vector<std::string>.
+     * @return A handle to pass to use_shared_names() on the other threads.
      */
-    static thread_local lazy_allocator<std::vector<std::string>, default_variable_names> names;
+    static std::shared_ptr<shared_names_t> share_names();
 
-  public:
-    static void clear_thread_local_state();
+    /**
+     * @brief Make the calling thread use a shared registry, or its own registry again if shared is null.
+     *
+     * @param[in] shared A handle obtained from share_names(), or nullptr.
+     */
+    static void use_shared_names(std::shared_ptr<shared_names_t> shared);
 
     static std::vector<variable_t> get_type_variables();
     static variable_t reg(data_kind_t, int);
@@ -12,16 +12,16 @@
 
 namespace crab {
 
-bool is_component_member(const label_t& label, const cycle_or_label& component) {
-    if (const auto plabel = std::get_if<label_t>(&component)) {
-        return *plabel == label;
+bool is_component_member(const node_id_t node, const cycle_or_label& component) {
+    if (const auto pnode = std::get_if<node_id_t>(&component)) {
+        return *pnode == node;
     }
     const auto cycle = std::get<std::shared_ptr<wto_cycle_t>>(component);
-    if (cycle->head() == label) {
+    if (cycle->head() == node) {
         return true;
     }
     for (const auto& sub_component : *cycle) {
-        if (is_component_member(label, sub_component)) {
+        if (is_component_member(node, sub_component)) {
             return true;
         }
     }
@@ -54,12 +54,12 @@ enum class visit_task_type_t {
 
 struct visit_args_t {
     visit_task_type_t type;
-    label_t vertex;
+    node_id_t vertex;
     wto_partition_t& partition;
     std::weak_ptr<wto_cycle_t> containing_cycle;
 
-    visit_args_t(const visit_task_type_t t, label_t v, wto_partition_t& p, std::weak_ptr<wto_cycle_t> cc)
-        : type(t), vertex(std::move(v)), partition(p), containing_cycle(std::move(cc)){};
+    visit_args_t(const visit_task_type_t t, const node_id_t v, wto_partition_t& p, std::weak_ptr<wto_cycle_t> cc)
+        : type(t), vertex(v), partition(p), containing_cycle(std::move(cc)){};
 };
 
 struct wto_vertex_data_t {
@@ -73,32 +73,35 @@ struct wto_vertex_data_t {
 constexpr static int DFN_INF = std::numeric_limits<decltype(wto_vertex_data_t::dfn)>::max();
 
 class wto_builder_t final {
-    // Original control-flow graph.
-    const cfg_t& _cfg;
+  public:
+    // Declared first, so that the graph it stores can be referred to below.
+    wto_t wto;
+
+  private:
+    // Original control-flow graph, as stored in the WTO.
+    const frozen_cfg_t& _cfg;
 
     // The following members are named to match the names in the paper.
-    std::map<label_t, wto_vertex_data_t> _vertex_data;
+    std::vector<wto_vertex_data_t> _vertex_data;
     int _num; // Highest DFN used so far.
-    std::stack<label_t> _stack;
+    std::stack<node_id_t> _stack;
 
     std::stack<visit_args_t> _visit_stack;
 
-    void push_successors(const label_t& vertex, wto_partition_t& partition,
+    void push_successors(node_id_t vertex, wto_partition_t& partition,
                          const std::weak_ptr<wto_cycle_t>& containing_cycle);
-    void start_visit(const label_t& vertex, wto_partition_t& partition,
-                     const std::weak_ptr<wto_cycle_t>& containing_cycle);
-    void continue_visit(const label_t& vertex, wto_partition_t& partition,
+    void start_visit(node_id_t vertex, wto_partition_t& partition, const std::weak_ptr<wto_cycle_t>& containing_cycle);
+    void continue_visit(node_id_t vertex, wto_partition_t& partition,
                         const std::weak_ptr<wto_cycle_t>& containing_cycle);
 
   public:
-    wto_t wto;
     // Construct a Weak Topological Ordering from a control-flow graph using
     // the algorithm of figure 4 in the paper, where this constructor matches
     // what is shown there as the Partition function.
-    explicit wto_builder_t(const cfg_t& cfg);
+    explicit wto_builder_t(frozen_cfg_t cfg);
 };
 
-void wto_builder_t::push_successors(const label_t& vertex, wto_partition_t& partition,
+void wto_builder_t::push_successors(const node_id_t vertex, wto_partition_t& partition,
                                     const std::weak_ptr<wto_cycle_t>& containing_cycle) {
     if (_vertex_data[vertex].dfn != 0) {
         // We found an alternate path to a node already visited, so nothing to do.
@@ -110,19 +113,19 @@ void wto_builder_t::push_successors(const label_t& vertex, wto_partition_t& part
     // Schedule the next task for this vertex once we're done with anything else.
     _visit_stack.emplace(visit_task_type_t::StartVisit, vertex, partition, containing_cycle);
 
-    for (const label_t& succ : std::ranges::reverse_view(_cfg.children_of(vertex))) {
+    for (const node_id_t succ : std::ranges::reverse_view(_cfg.children_of(vertex))) {
         if (_vertex_data[succ].dfn == 0) {
             _visit_stack.emplace(visit_task_type_t::PushSuccessors, succ, partition, containing_cycle);
         }
     }
 }
 
-void wto_builder_t::start_visit(const label_t& vertex, wto_partition_t& partition,
+void wto_builder_t::start_visit(const node_id_t vertex, wto_partition_t& partition,
                                 const std::weak_ptr<wto_cycle_t>& containing_cycle) {
     wto_vertex_data_t& vertex_data = _vertex_data[vertex];
     int head_dfn = vertex_data.dfn;
     bool loop = false;
-    for (const label_t& succ : _cfg.children_of(vertex)) {
+    for (const node_id_t succ : _cfg.children_of(vertex)) {
         const wto_vertex_data_t& data = _vertex_data[succ];
         int min_dfn = data.dfn;
         if (data.head_dfn != 0 && data.dfn != DFN_INF) {
@@ -139,7 +142,7 @@ void wto_builder_t::start_visit(const label_t& vertex, wto_partition_t& partitio
 
     if (head_dfn == vertex_data.dfn) {
         vertex_data.dfn = DFN_INF;
-        label_t element = _stack.top();
+        node_id_t element = _stack.top();
         _stack.pop();
         if (loop) {
             while (element != vertex) {
@@ -158,7 +161,7 @@ void wto_builder_t::start_visit(const label_t& vertex, wto_partition_t& partitio
 
             // Walk the control flow graph, adding nodes to this cycle.
             // This is the Component() function described in figure 4 of the paper.
-            for (const label_t& succ : std::ranges::reverse_view(_cfg.children_of(vertex))) {
+            for (const node_id_t succ : std::ranges::reverse_view(_cfg.children_of(vertex))) {
                 if (_vertex_data.at(succ).dfn == 0) {
                     _visit_stack.emplace(visit_task_type_t::PushSuccessors, succ, cycle->_components, cycle);
                 }
@@ -169,12 +172,12 @@ void wto_builder_t::start_visit(const label_t& vertex, wto_partition_t& partitio
         partition.emplace_back(vertex);
 
         // Remember that we put the vertex into the caller's cycle.
-        wto._containing_cycle.emplace(vertex, containing_cycle);
+        wto._containing_cycle[vertex] = containing_cycle;
     }
     vertex_data.head_dfn = head_dfn;
 }
 
-void wto_builder_t::continue_visit(const label_t& vertex, wto_partition_t& partition,
+void wto_builder_t::continue_visit(const node_id_t vertex, wto_partition_t& partition,
                                    const std::weak_ptr<wto_cycle_t>& containing_cycle) {
     // Add the vertex at the start of the cycle
     // (end of the vector which stores the cycle in reverse order).
@@ -186,20 +189,22 @@ void wto_builder_t::continue_visit(const label_t& vertex, wto_partition_t& parti
     partition.emplace_back(cycle);
 
     // Remember that we put the vertex into the new cycle.
-    wto._containing_cycle.emplace(vertex, cycle);
+    wto._containing_cycle[vertex] = cycle;
 }
 
-wto_builder_t::wto_builder_t(const cfg_t& cfg) : _cfg(cfg) {
-    // Create a map for holding a "depth-first number (DFN)" for each vertex.
-    for (const label_t& label : cfg.labels()) {
-        _vertex_data.emplace(label, 0);
-    }
+wto_builder_t::wto_builder_t(frozen_cfg_t cfg) : _cfg(wto._cfg) {
+    wto._cfg = std::move(cfg);
+    wto._containing_cycle.resize(_cfg.size());
+    wto._nesting.resize(_cfg.size());
+
+    // Create a table holding a "depth-first number (DFN)" for each vertex.
+    _vertex_data.resize(_cfg.size());
 
     // Initialize the DFN counter.
     _num = 0;
 
     // Push the entry vertex on the stack to process.
-    _visit_stack.emplace(visit_args_t(visit_task_type_t::PushSuccessors, cfg.entry_label(), wto._components, {}));
+    _visit_stack.emplace(visit_args_t(visit_task_type_t::PushSuccessors, _cfg.entry(), wto._components, {}));
 
     // Keep processing tasks until we're done.
     while (!_visit_stack.empty()) {
@@ -220,11 +225,12 @@ wto_builder_t::wto_builder_t(const cfg_t& cfg) : _cfg(cfg) {
 
 class print_visitor {
     std::ostream& o;
+    const frozen_cfg_t& cfg;
 
   public:
-    explicit print_visitor(std::ostream& o) : o(o) {}
+    print_visitor(std::ostream& o, const frozen_cfg_t& cfg) : o(o), cfg(cfg) {}
 
-    void operator()(const label_t& label) { o << label; }
+    void operator()(const node_id_t node) { o << cfg.label(node); }
 
     void operator()(const wto_cycle_t& cycle) {
         o << "( ";
@@ -250,62 +256,59 @@ class print_visitor {
 
     // Output the nesting in order from outermost to innermost.
     void operator()(const wto_nesting_t& nesting) {
-        for (const auto& _head : std::ranges::reverse_view(nesting._heads)) {
-            o << _head << " ";
+        for (const node_id_t _head : std::ranges::reverse_view(nesting._heads)) {
+            o << cfg.label(_head) << " ";
         }
     }
 };
 
 std::ostream& operator<<(std::ostream& o, const wto_t& wto) {
-    print_visitor{o}(wto._components);
+    print_visitor{o, wto._cfg}(wto._components);
     return o << std::endl;
 }
 
 // Get the vertex at the head of the component containing a given
-// label, as discussed in section 4.2 of the paper.  If the label
+// node, as discussed in section 4.2 of the paper.  If the node
 // is itself a head of a component, we want the head of whatever
-// contains that entire component.  Returns nullopt if the label is
+// contains that entire component.  Returns nullopt if the node is
 // not nested, i.e., the head is logically the entry point of the CFG.
-std::optional<label_t> wto_t::head(const label_t& label) const {
-    const auto it = _containing_cycle.find(label);
-    if (it == _containing_cycle.end()) {
-        // Label is not in any cycle.
-        return {};
-    }
-    const std::shared_ptr<wto_cycle_t> cycle = it->second.lock();
+std::optional<node_id_t> wto_t::head(const node_id_t node) const {
+    const std::shared_ptr<wto_cycle_t> cycle = _containing_cycle.at(node).lock();
     if (cycle == nullptr) {
+        // Node is not in any cycle.
         return {};
     }
-    if (const label_t& first = cycle->head(); first != label) {
-        // Return the head of the cycle the label is inside.
+    if (const node_id_t first = cycle->head(); first != node) {
+        // Return the head of the cycle the node is inside.
         return first;
     }
 
-    // This label is already the head of a cycle, so get the cycle's parent.
+    // This node is already the head of a cycle, so get the cycle's parent.
     if (const auto parent = cycle->_containing_cycle.lock()) {
         return parent->head();
     }
     return {};
 }
 
-wto_t::wto_t(const cfg_t& cfg) : wto_t{std::move(wto_builder_t(cfg).wto)} {}
+wto_t::wto_t(const cfg_t& cfg) : wto_t{std::move(wto_builder_t(frozen_cfg_t{cfg}).wto)} {}
 
-std::vector<label_t> wto_t::collect_heads(const label_t& label) const {
-    std::vector<label_t> heads;
-    for (auto h = head(label); h; h = head(*h)) {
+std::vector<node_id_t> wto_t::collect_heads(const node_id_t node) const {
+    std::vector<node_id_t> heads;
+    for (auto h = head(node); h; h = head(*h)) {
         heads.push_back(*h);
     }
     return heads;
 }
 
-// Compute the set of heads of the nested components containing a given label.
+// Compute the set of heads of the nested components containing a given node.
 // See section 3.1 of the paper for discussion, which uses the notation w(c).
-const wto_nesting_t& wto_t::nesting(const label_t& label) const {
-    if (!_nesting.contains(label)) {
+const wto_nesting_t& wto_t::nesting(const node_id_t node) const {
+    std::optional<wto_nesting_t>& nesting = _nesting.at(node);
+    if (!nesting) {
         // Not found in the cache yet, so construct the list of heads of the
-        // nested components containing the label, stored in reverse order.
-        _nesting.emplace(label, collect_heads(label));
+        // nested components containing the node, stored in reverse order.
+        nesting.emplace(collect_heads(node));
     }
-    return _nesting.at(label);
+    return *nesting;
 }
 } // namespace crab
@@ -17,7 +17,7 @@
 //   1 --> 2 --------> 8
 //
 // results in the WTO: 1 2 (3 4 (5 6) 7) 8
-// where a single vertex is represented via label_t, and a
+// where a single vertex is represented via its node_id_t in the frozen cfg, and a
 // cycle such as (5 6) is represented via a wto_cycle_t.
 // Each arrow points to a cycle_or_label, which can be either a
 // single vertex such as 8, or a cycle such as (5 6).
@@ -40,19 +40,19 @@ namespace crab {
 class wto_nesting_t final {
     // To optimize insertion performance, the list of heads is stored in reverse
     // order, i.e., from innermost to outermost cycle.
-    std::vector<label_t> _heads;
+    std::vector<node_id_t> _heads;
 
     friend class print_visitor;
 
   public:
-    explicit wto_nesting_t(std::vector<label_t>&& heads) : _heads(std::move(heads)) {}
+    explicit wto_nesting_t(std::vector<node_id_t>&& heads) : _heads(std::move(heads)) {}
 
     // Test whether this nesting is a longer subset of another nesting.
     bool operator>(const wto_nesting_t& nesting) const;
 };
 
 // Define types used by both this header file and wto_cycle.hpp
-using cycle_or_label = std::variant<std::shared_ptr<class wto_cycle_t>, label_t>;
+using cycle_or_label = std::variant<std::shared_ptr<class wto_cycle_t>, node_id_t>;
 using wto_partition_t = std::vector<cycle_or_label>;
 
 // Bourdoncle, "Efficient chaotic iteration strategies with widenings", 1993
@@ -72,17 +72,17 @@ class wto_cycle_t final {
 
     // Get a vertex of an entry point of the cycle.
     [[nodiscard]]
-    const label_t& head() const {
+    node_id_t head() const {
         // Any cycle must start with a vertex, not another cycle,
         // per Definition 1 in the paper.  Since the vector is in reverse
         // order, the head is the last element.
         if (_components.empty()) {
             CRAB_ERROR("Empty cycle");
         }
-        if (const auto label = std::get_if<label_t>(&_components.back())) {
-            return *label;
+        if (const auto node = std::get_if<node_id_t>(&_components.back())) {
+            return *node;
         }
-        CRAB_ERROR("Expected label_t at the back of _components");
+        CRAB_ERROR("Expected node_id_t at the back of _components");
     }
 
     [[nodiscard]]
@@ -97,22 +97,25 @@ class wto_cycle_t final {
 };
 
 // Check if node is a member of the wto component.
-bool is_component_member(const label_t& label, const cycle_or_label& component);
+bool is_component_member(node_id_t node, const cycle_or_label& component);
 
 class wto_t final {
+    // The graph the WTO orders, whose node ids the components refer to.
+    frozen_cfg_t _cfg;
+
     // Top level components, in reverse order.
     wto_partition_t _components;
 
-    // Table mapping label to the cycle containing the label.
-    std::map<label_t, std::weak_ptr<wto_cycle_t>> _containing_cycle;
+    // Table mapping node to the cycle containing the node.
+    std::vector<std::weak_ptr<wto_cycle_t>> _containing_cycle;
 
-    // Table mapping label to the list of heads of cycles containing the label.
+    // Table mapping node to the list of heads of cycles containing the node.
     // This is an on-demand cache, since for most vertices the nesting is never
     // looked at so we only create a wto_nesting_t for cases we actually need it.
-    mutable std::map<label_t, wto_nesting_t> _nesting;
+    mutable std::vector<std::optional<wto_nesting_t>> _nesting;
 
-    std::vector<label_t> collect_heads(const label_t& label) const;
-    std::optional<label_t> head(const label_t& label) const;
+    std::vector<node_id_t> collect_heads(node_id_t node) const;
+    std::optional<node_id_t> head(node_id_t node) const;
 
     wto_t() = default;
     friend class wto_builder_t;
@@ -120,6 +123,11 @@ class wto_t final {
   public:
     explicit wto_t(const cfg_t& cfg);
 
+    [[nodiscard]]
+    const frozen_cfg_t& cfg() const {
+        return _cfg;
+    }
+
     [[nodiscard]]
     wto_partition_t::const_reverse_iterator begin() const {
         return _components.crbegin();
@@ -131,19 +139,19 @@ class wto_t final {
     }
 
     friend std::ostream& operator<<(std::ostream& o, const wto_t& wto);
-    const wto_nesting_t& nesting(const label_t& label) const;
+    const wto_nesting_t& nesting(node_id_t node) const;
 
     /**
      * Visit the heads of all loops in the WTO.
      *
-     * @param f The callable to be invoked for each loop head.
+     * @param f The callable to be invoked for the label of each loop head.
      *
      * The order in which the heads are visited is not specified.
      */
     void for_each_loop_head(auto&& f) const {
         for (const auto& component : *this) {
             if (const auto pc = std::get_if<std::shared_ptr<wto_cycle_t>>(&component)) {
-                f((*pc)->head());
+                f(_cfg.label((*pc)->head()));
             }
         }
     }
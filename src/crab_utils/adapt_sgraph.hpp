@@ -2,10 +2,17 @@
 // SPDX-License-Identifier: Apache-2.0
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
+#include <numeric>
+#include <optional>
+#include <utility>
+#include <vector>
 
 #include <boost/container/flat_map.hpp>
 
+#include "crab_utils/num_big.hpp"
 #include "crab_utils/num_safeint.hpp"
 
 namespace crab {
@@ -13,7 +20,7 @@ namespace crab {
 class TreeSMap final {
   public:
     using key_t = uint16_t;
-    using val_t = size_t;
+    using val_t = number_t;
 
   private:
     using col = boost::container::flat_map<key_t, val_t>;
@@ -124,12 +131,20 @@ class TreeSMap final {
     }
 
     [[nodiscard]]
-    std::optional<val_t> lookup(key_t k) const {
+    const val_t* find(key_t k) const {
         auto v = map.find(k);
         if (v != map.end()) {
-            return {v->second};
+            return &v->second;
         }
-        return std::nullopt;
+        return nullptr;
+    }
+
+    val_t* find(key_t k) {
+        auto v = map.find(k);
+        if (v != map.end()) {
+            return &v->second;
+        }
+        return nullptr;
     }
 
     // precondition: k \in S
@@ -140,9 +155,51 @@ class TreeSMap final {
     void clear() { map.clear(); }
 };
 
-// Adaptive sparse-set based weighted graph implementation
+/**
+ * Adaptive sparse-set based weighted graph implementation.
+ *
+ * The graph is persistent: copies share their adjacency rows, and a row is cloned when a graph that did not create it
+ * modifies it. Copying a graph is constant-time, and a change to a copy costs a copy of the row pointers (once per
+ * copy) plus a copy of the rows it touches. The weight of an edge is stored in both the row of its source and the row
+ * of its destination, so that changing an edge does not touch any other edge.
+ *
+ * Whether a row may be changed in place does not depend on reference counts, which other threads may change at any
+ * time. A graph that changes takes an owner token that no other graph has, and marks the table and the rows it creates
+ * with it. It changes in place only what carries its token. Copying a graph takes its token away, so that neither the
+ * graph nor its copy can change what they share.
+ */
 class AdaptGraph final {
     using smap_t = TreeSMap;
+    using row_ptr = std::shared_ptr<smap_t>;
+
+    // 0 is the token of no graph.
+    using owner_t = uint64_t;
+
+    struct table_t {
+        std::vector<row_ptr> preds;
+        std::vector<row_ptr> succs;
+        // The graph that created each row, and so may change it.
+        std::vector<owner_t> preds_owner;
+        std::vector<owner_t> succs_owner;
+        std::vector<int> is_free;
+        std::vector<unsigned int> free_id;
+        owner_t owner{};
+    };
+
+    static owner_t new_owner() {
+        static std::atomic<owner_t> last{0};
+        return last.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    // Shared by every empty row and every empty graph, and owned by no graph.
+    static const row_ptr& empty_row() {
+        static const row_ptr row = std::make_shared<smap_t>();
+        return row;
+    }
+    static const std::shared_ptr<table_t>& empty_table() {
+        static const std::shared_ptr<table_t> table = std::make_shared<table_t>();
+        return table;
+    }
 
   public:
     /** DBM weights (Weight) can be represented using one of the following
@@ -159,18 +216,41 @@ class AdaptGraph final {
      * overflow is not a concern, but it might not be what you need
      * when reasoning about programs with wraparound semantics.
      **/
-    using Weight = number_t; // previously template
+    using Weight = smap_t::val_t; // previously template
     using vert_id = unsigned int;
 
-    AdaptGraph() : edge_count(0) {}
+    AdaptGraph() : _table(empty_table()), edge_count(0) {}
 
-    AdaptGraph(AdaptGraph&& o) noexcept = default;
+    // A moved-from graph is empty, not invalid.
+    AdaptGraph(AdaptGraph&& o) noexcept
+        : _table(std::exchange(o._table, empty_table())), edge_count(std::exchange(o.edge_count, 0)),
+          _packs(std::move(o._packs)), _owner(o._owner.exchange(0, std::memory_order_relaxed)) {}
 
-    AdaptGraph(const AdaptGraph& o) = default;
+    // Several threads may copy the same graph at once, so o gives up its token atomically.
+    AdaptGraph(const AdaptGraph& o) : _table(o._table), edge_count(o.edge_count), _packs(o._packs) {
+        o._owner.store(0, std::memory_order_relaxed);
+    }
 
-    AdaptGraph& operator=(const AdaptGraph& o) = default;
+    AdaptGraph& operator=(const AdaptGraph& o) {
+        if (this != &o) {
+            _table = o._table;
+            edge_count = o.edge_count;
+            _packs = o._packs;
+            _owner.store(0, std::memory_order_relaxed);
+            o._owner.store(0, std::memory_order_relaxed);
+        }
+        return *this;
+    }
 
-    AdaptGraph& operator=(AdaptGraph&& o) noexcept = default;
+    AdaptGraph& operator=(AdaptGraph&& o) noexcept {
+        if (this != &o) {
+            _table = std::exchange(o._table, empty_table());
+            edge_count = std::exchange(o.edge_count, 0);
+            _packs = std::move(o._packs);
+            _owner.store(o._owner.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        return *this;
+    }
 
     template <class G>
     static AdaptGraph copy(G& o) {
@@ -224,7 +304,7 @@ class AdaptGraph final {
     };
     [[nodiscard]]
     vert_const_range verts() const {
-        return vert_const_range{is_free};
+        return vert_const_range{_table->is_free};
     }
 
     struct edge_const_iter {
@@ -234,9 +314,8 @@ class AdaptGraph final {
         };
 
         smap_t::elt_iter_t it{};
-        const std::vector<Weight>* ws{};
 
-        edge_const_iter(const smap_t::elt_iter_t& _it, const std::vector<Weight>& _ws) : it(_it), ws(&_ws) {}
+        explicit edge_const_iter(const smap_t::elt_iter_t& _it) : it(_it) {}
         edge_const_iter(const edge_const_iter& o) = default;
         edge_const_iter& operator=(const edge_const_iter& o) = default;
         edge_const_iter() = default;
@@ -247,7 +326,7 @@ class AdaptGraph final {
         inline static std::unique_ptr<edge_const_iter> _empty_iter = std::make_unique<edge_const_iter>();
         static edge_const_iter empty_iterator() { return *_empty_iter; }
 
-        edge_ref operator*() const { return edge_ref{it->first, (*ws)[it->second]}; }
+        edge_ref operator*() const { return edge_ref{it->first, it->second}; }
         edge_const_iter operator++() {
             ++it;
             return *this;
@@ -260,15 +339,14 @@ class AdaptGraph final {
         using iterator = edge_const_iter;
 
         elt_range_t r;
-        const std::vector<Weight>& ws;
 
         [[nodiscard]]
         edge_const_iter begin() const {
-            return edge_const_iter(r.begin(), ws);
+            return edge_const_iter(r.begin());
         }
         [[nodiscard]]
         edge_const_iter end() const {
-            return edge_const_iter(r.end(), ws);
+            return edge_const_iter(r.end());
         }
         [[nodiscard]]
         size_t size() const {
@@ -286,11 +364,11 @@ class AdaptGraph final {
 
     [[nodiscard]]
     adj_const_range_t succs(vert_id v) const {
-        return _succs[v].keys();
+        return _table->succs[v]->keys();
     }
     [[nodiscard]]
     adj_const_range_t preds(vert_id v) const {
-        return _preds[v].keys();
+        return _table->preds[v]->keys();
     }
 
     using fwd_edge_range = edge_const_range_t;
@@ -298,11 +376,11 @@ class AdaptGraph final {
 
     [[nodiscard]]
     edge_const_range_t e_succs(vert_id v) const {
-        return {_succs[v].elts(), _ws};
+        return {_table->succs[v]->elts()};
     }
     [[nodiscard]]
     edge_const_range_t e_preds(vert_id v) const {
-        return {_preds[v].elts(), _ws};
+        return {_table->preds[v]->elts()};
     }
 
     using e_neighbour_const_range = edge_const_range_t;
@@ -314,110 +392,148 @@ class AdaptGraph final {
     }
     [[nodiscard]]
     size_t size() const {
-        return _succs.size();
+        return _table->succs.size();
     }
     [[nodiscard]]
     size_t num_edges() const {
         return edge_count;
     }
+
+    // Whether v has the same edges in o without comparing them: the rows of v are shared by copies of a graph until
+    // one of them changes an edge of v.
+    [[nodiscard]]
+    bool shares_edges_of(const AdaptGraph& o, const vert_id v) const {
+        return v < size() && v < o.size() && _table->succs[v] == o._table->succs[v] &&
+               _table->preds[v] == o._table->preds[v];
+    }
+
+    // The representative of the pack of each vertex, where two vertices are in the same pack when a path of edges links
+    // them. The edges of vertex 0 are bounds, which link nothing. The partition is computed once and shared by the
+    // copies of the graph until it changes.
+    [[nodiscard]]
+    const std::vector<vert_id>& packs() const {
+        if (!_packs) {
+            _packs = std::make_shared<const std::vector<vert_id>>(compute_packs());
+        }
+        return *_packs;
+    }
     vert_id new_vertex() {
+        table_t& t = mut_table();
         vert_id v;
-        if (!free_id.empty()) {
-            v = free_id.back();
-            assert(v < _succs.size());
-            free_id.pop_back();
-            is_free[v] = false;
+        if (!t.free_id.empty()) {
+            v = t.free_id.back();
+            assert(v < t.succs.size());
+            t.free_id.pop_back();
+            t.is_free[v] = false;
         } else {
-            v = static_cast<vert_id>(_succs.size());
-            is_free.push_back(false);
-            _succs.emplace_back();
-            _preds.emplace_back();
+            v = static_cast<vert_id>(t.succs.size());
+            t.is_free.push_back(false);
+            t.succs.push_back(empty_row());
+            t.preds.push_back(empty_row());
+            t.succs_owner.push_back(0);
+            t.preds_owner.push_back(0);
         }
 
         return v;
     }
 
     void growTo(size_t v) {
-        _succs.reserve(v);
-        _preds.reserve(v);
+        if (size() >= v) {
+            return;
+        }
+        table_t& t = mut_table();
+        t.succs.reserve(v);
+        t.preds.reserve(v);
+        t.succs_owner.reserve(v);
+        t.preds_owner.reserve(v);
         while (size() < v) {
             new_vertex();
         }
     }
 
     void forget(vert_id v) {
-        if (is_free[v]) {
+        if (_table->is_free[v]) {
             return;
         }
+        table_t& t = mut_table();
 
-        for (const auto& [key, val] : _succs[v].elts()) {
-            free_widx.push_back(val);
-            _preds[key].remove(v);
+        // Hold the rows of v, since removing v from its neighbours may replace the row pointers in the table.
+        const row_ptr succs_of_v = t.succs[v];
+        for (smap_t::key_t k : succs_of_v->keys()) {
+            mut_preds(k).remove(v);
         }
-        edge_count -= _succs[v].size();
-        _succs[v].clear();
+        edge_count -= succs_of_v->size();
+        t.succs[v] = empty_row();
+        t.succs_owner[v] = 0;
 
-        for (smap_t::key_t k : _preds[v].keys()) {
-            _succs[k].remove(v);
+        const row_ptr preds_of_v = t.preds[v];
+        for (smap_t::key_t k : preds_of_v->keys()) {
+            mut_succs(k).remove(v);
         }
-        edge_count -= _preds[v].size();
-        _preds[v].clear();
+        edge_count -= preds_of_v->size();
+        t.preds[v] = empty_row();
+        t.preds_owner[v] = 0;
 
-        is_free[v] = true;
-        free_id.push_back(v);
+        t.is_free[v] = true;
+        t.free_id.push_back(v);
     }
 
     void clear_edges() {
-        _ws.clear();
+        table_t& t = mut_table();
         for (vert_id v : verts()) {
-            _succs[v].clear();
-            _preds[v].clear();
+            t.succs[v] = empty_row();
+            t.preds[v] = empty_row();
+            t.succs_owner[v] = 0;
+            t.preds_owner[v] = 0;
         }
         edge_count = 0;
     }
     void clear() {
-        _ws.clear();
-        _succs.clear();
-        _preds.clear();
-        is_free.clear();
-        free_id.clear();
-        free_widx.clear();
-
+        _table = empty_table();
         edge_count = 0;
+        _packs.reset();
     }
 
     [[nodiscard]]
     bool elem(vert_id s, vert_id d) const {
-        return _succs[s].contains(d);
+        return _table->succs[s]->contains(d);
     }
 
-    const Weight& edge_val(vert_id s, vert_id d) const { return _ws[*_succs[s].lookup(d)]; }
+    const Weight& edge_val(vert_id s, vert_id d) const { return *_table->succs[s]->find(d); }
 
+    /// A reference to the weight of an edge. Assigning to it changes the edge in the graph it was looked up in.
     class mut_val_ref_t {
       public:
-        mut_val_ref_t() : w(nullptr) {}
+        mut_val_ref_t() = default;
         operator Weight() const {
-            assert(w);
-            return *w;
+            assert(g);
+            return w;
         }
         [[nodiscard]]
         Weight get() const {
-            assert(w);
-            return *w;
+            assert(g);
+            return w;
         }
-        void operator=(Weight* _w) { w = _w; }
         void operator=(Weight _w) {
-            assert(w);
-            *w = _w;
+            assert(g);
+            g->set_edge(s, _w, d);
+            w = std::move(_w);
         }
 
       private:
-        Weight* w;
+        friend class AdaptGraph;
+        AdaptGraph* g{};
+        vert_id s{};
+        vert_id d{};
+        Weight w;
     };
 
     bool lookup(vert_id s, vert_id d, mut_val_ref_t* w) {
-        if (auto idx = _succs[s].lookup(d)) {
-            *w = &_ws[*idx];
+        if (const Weight* val = _table->succs[s]->find(d)) {
+            w->g = this;
+            w->s = s;
+            w->d = d;
+            w->w = *val;
             return true;
         }
         return false;
@@ -425,39 +541,34 @@ class AdaptGraph final {
 
     [[nodiscard]]
     std::optional<Weight> lookup(vert_id s, vert_id d) const {
-        if (auto idx = _succs[s].lookup(d)) {
-            return _ws[*idx];
+        if (const Weight* val = _table->succs[s]->find(d)) {
+            return *val;
         }
         return {};
     }
 
     void add_edge(vert_id s, Weight w, vert_id d) {
-        size_t idx;
-        if (!free_widx.empty()) {
-            idx = free_widx.back();
-            free_widx.pop_back();
-            _ws[idx] = w;
-        } else {
-            idx = _ws.size();
-            _ws.push_back(w);
-        }
-
-        _succs[s].add(d, idx);
-        _preds[d].add(s, idx);
+        mut_succs(s).add(d, w);
+        mut_preds(d).add(s, w);
         edge_count++;
     }
 
     void update_edge(vert_id s, Weight w, vert_id d) {
-        if (auto idx = _succs[s].lookup(d)) {
-            _ws[*idx] = std::min(_ws[*idx], w);
+        if (const Weight* val = _table->succs[s]->find(d)) {
+            // Only take the rows for writing when the edge actually changes.
+            if (w < *val) {
+                *mut_succs(s).find(d) = w;
+                *mut_preds(d).find(s) = w;
+            }
         } else {
             add_edge(s, w, d);
         }
     }
 
     void set_edge(vert_id s, Weight w, vert_id d) {
-        if (auto idx = _succs[s].lookup(d)) {
-            _ws[*idx] = w;
+        if (_table->succs[s]->contains(d)) {
+            *mut_succs(s).find(d) = w;
+            *mut_preds(d).find(s) = w;
         } else {
             add_edge(s, w, d);
         }
@@ -490,16 +601,76 @@ class AdaptGraph final {
         return o;
     }
 
-    // Ick. This'll have another indirection on every operation.
-    // We'll see what the performance costs are like.
-    std::vector<smap_t> _preds{};
-    std::vector<smap_t> _succs{};
-    std::vector<Weight> _ws{};
+  private:
+    // The table and the rows that this graph did not create are cloned before they change. A graph is only ever
+    // changed by one thread at a time, and not while another thread copies it.
+    table_t& mut_table() {
+        _packs.reset();
+        owner_t owner = _owner.load(std::memory_order_relaxed);
+        if (owner == 0) {
+            owner = new_owner();
+            _owner.store(owner, std::memory_order_relaxed);
+        }
+        if (_table->owner != owner) {
+            _table = std::make_shared<table_t>(*_table);
+            _table->owner = owner;
+        }
+        return *_table;
+    }
+
+    static smap_t& mut_row(row_ptr& row, owner_t& row_owner, const owner_t owner) {
+        if (row_owner != owner) {
+            row = std::make_shared<smap_t>(*row);
+            row_owner = owner;
+        }
+        return *row;
+    }
+
+    smap_t& mut_succs(vert_id v) {
+        table_t& t = mut_table();
+        return mut_row(t.succs[v], t.succs_owner[v], t.owner);
+    }
+    smap_t& mut_preds(vert_id v) {
+        table_t& t = mut_table();
+        return mut_row(t.preds[v], t.preds_owner[v], t.owner);
+    }
+
+    [[nodiscard]]
+    std::vector<vert_id> compute_packs() const {
+        std::vector<vert_id> parent(size());
+        std::iota(parent.begin(), parent.end(), 0);
+        const auto find = [&parent](vert_id v) {
+            while (parent[v] != v) {
+                parent[v] = parent[parent[v]];
+                v = parent[v];
+            }
+            return v;
+        };
+        for (const vert_id s : verts()) {
+            if (s == 0) {
+                continue;
+            }
+            for (const vert_id d : succs(s)) {
+                if (d != 0) {
+                    parent[find(s)] = find(d);
+                }
+            }
+        }
+        for (vert_id v = 0; v < parent.size(); v++) {
+            parent[v] = find(v);
+        }
+        return parent;
+    }
+
+    std::shared_ptr<table_t> _table;
 
     size_t edge_count{};
 
-    std::vector<int> is_free{};
-    std::vector<vert_id> free_id{};
-    std::vector<size_t> free_widx{};
+    // Every change to the graph goes through mut_table(), which drops the partition. The partition itself is never
+    // modified, so copies of the graph can share it.
+    mutable std::shared_ptr<const std::vector<vert_id>> _packs;
+
+    // The token of this graph, or 0 until it changes after it was created or copied.
+    mutable std::atomic<owner_t> _owner{0};
 };
 } // namespace crab
@@ -524,11 +524,17 @@ class GraphOps {
     static inline thread_local unsigned int ts;
     static inline thread_local unsigned int ts_idx;
 
+    // Row-major distances and the original edges of the dense closure.
+    static inline thread_local lazy_allocator<std::vector<int64_t>> dense_dists;
+    static inline thread_local lazy_allocator<std::vector<int64_t>> dense_edges;
+
   public:
     static void clear_thread_local_state() {
         dists.clear();
         dists_alt.clear();
         dist_ts.clear();
+        dense_dists.clear();
+        dense_edges.clear();
         edge_marks.clear();
         dual_queue.clear();
         vert_marks.clear();
@@ -537,6 +543,36 @@ class GraphOps {
         ts_idx = 0;
     }
 
+    // The scratch space of a verifier context while another one is bound to the thread.
+    struct scratch_t {
+        lazy_allocator<std::vector<char>> edge_marks;
+        lazy_allocator<std::vector<vert_id>> dual_queue;
+        lazy_allocator<std::vector<int>> vert_marks;
+        size_t scratch_sz{};
+        lazy_allocator<std::vector<Weight>> dists;
+        lazy_allocator<std::vector<Weight>> dists_alt;
+        lazy_allocator<std::vector<unsigned int>> dist_ts;
+        unsigned int ts{};
+        unsigned int ts_idx{};
+        lazy_allocator<std::vector<int64_t>> dense_dists;
+        lazy_allocator<std::vector<int64_t>> dense_edges;
+    };
+
+    // Exchange the scratch space of the calling thread with that of a context, without copying the buffers.
+    static void swap_thread_local_state(scratch_t& scratch) {
+        edge_marks.swap(scratch.edge_marks);
+        dual_queue.swap(scratch.dual_queue);
+        vert_marks.swap(scratch.vert_marks);
+        std::swap(scratch_sz, scratch.scratch_sz);
+        dists.swap(scratch.dists);
+        dists_alt.swap(scratch.dists_alt);
+        dist_ts.swap(scratch.dist_ts);
+        std::swap(ts, scratch.ts);
+        std::swap(ts_idx, scratch.ts_idx);
+        dense_dists.swap(scratch.dense_dists);
+        dense_edges.swap(scratch.dense_edges);
+    }
+
   private:
     static void grow_scratch(const size_t sz) {
         if (sz <= scratch_sz) {
@@ -1051,6 +1087,72 @@ class GraphOps {
         return delta;
     }
 
+    // Graphs with at most this many vertices can be closed on a dense matrix, by Floyd-Warshall over rows of 64-bit
+    // weights, which compilers vectorize. "[graph-benchmark]" in test_number.cpp compares it with the sparse closures
+    // on random graphs of half an edge to four edges per vertex (GCC 12, -O2, x86-64):
+    // - After a meet, it beats close_after_meet at every size and density, by 2x at 32 vertices and half an edge per
+    //   vertex (10us against 24us) and by 20x at 32 vertices and 4 edges per vertex (63us against 1.2ms).
+    // - After a widening, close_after_widen only searches from the unstable vertices, and is faster when they are
+    //   fewer than a quarter of the vertices of a graph of more than 8 (see SplitDBM::normalize).
+    // Up to 32 vertices, the matrix takes at most 8KB. Beyond, closing a sparse graph from scratch is faster on its
+    // sparse rows (48 vertices with half an edge each: 14us against 18us).
+    static constexpr size_t max_dense_size = 32;
+
+    // The edges to add or tighten to close g, which must be consistent, computed on a dense matrix. Nothing if g is
+    // too big for that, or has a weight so big that a path could overflow 64 bits.
+    static std::optional<edge_vector> close_dense(const auto& g) {
+        const size_t sz = g.size();
+        if (sz > max_dense_size) {
+            return {};
+        }
+        // A shortest path has fewer than max_dense_size edges, so no sum of two distances overflows, and any sum with
+        // an infinite distance stays above infinity / 2.
+        constexpr int64_t max_weight = int64_t{1} << 48;
+        constexpr int64_t infinity = std::numeric_limits<int64_t>::max() / 2;
+        std::vector<int64_t>& dist = *dense_dists;
+        dist.assign(sz * sz, infinity);
+        for (const vert_id s : g.verts()) {
+            for (const auto e : g.e_succs(s)) {
+                if (!e.val.template fits<int64_t>()) {
+                    return {};
+                }
+                const int64_t w = e.val.template narrow<int64_t>();
+                if (w > max_weight || w < -max_weight) {
+                    return {};
+                }
+                dist[s * sz + e.vert] = w;
+            }
+        }
+        std::vector<int64_t>& before = *dense_edges;
+        before = dist;
+
+        for (size_t k = 0; k < sz; k++) {
+            const int64_t* row_k = &dist[k * sz];
+            for (size_t i = 0; i < sz; i++) {
+                const int64_t d_ik = dist[i * sz + k];
+                if (i == k || d_ik > infinity / 2) {
+                    continue;
+                }
+                // Branch-free, so that it runs on vector registers.
+                int64_t* row_i = &dist[i * sz];
+                for (size_t j = 0; j < sz; j++) {
+                    row_i[j] = std::min(row_i[j], d_ik + row_k[j]);
+                }
+            }
+        }
+
+        edge_vector delta;
+        for (const vert_id s : g.verts()) {
+            for (const vert_id d : g.verts()) {
+                const size_t i = s * sz + d;
+                if (s != d && dist[i] <= infinity / 2 && dist[i] < before[i]) {
+                    delta.emplace_back(s, d, Weight{dist[i]});
+                }
+            }
+        }
+        return delta;
+    }
+
   private:
     // Compute the transitive closure of edges reachable from v, assuming
     // (1) the subgraph G \ {v} is closed, and
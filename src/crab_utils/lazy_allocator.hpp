@@ -47,6 +47,13 @@ class lazy_allocator {
      */
     void set(T value) { _value = value; }
 
+    /**
+     * @brief Exchange the objects of two allocators, whether they are allocated or not.
+     *
+     * @param[in,out] other The allocator to exchange with.
+     */
+    void swap(lazy_allocator& other) { _value.swap(other._value); }
+
     // Ideally we would overload the . operator, but that is not possible
     // so we use -> instead and modify the callers from . to ->
 
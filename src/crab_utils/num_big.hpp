@@ -2,10 +2,14 @@
 // SPDX-License-Identifier: MIT
 #pragma once
 
+#include <bit>
 #include <climits>
+#include <cstdint>
+#include <limits>
 #include <sstream>
 #include <string>
 #include <utility>
+#include <variant>
 
 #include <boost/multiprecision/cpp_int.hpp>
 
@@ -16,45 +20,112 @@ using boost::multiprecision::cpp_int;
 
 namespace crab {
 
+/**
+ * An arbitrary-precision integer.
+ *
+ * Nearly all the numbers the analysis computes fit in 64 bits, so a number is stored as an int64_t as long as it fits,
+ * and as a cpp_int only otherwise. Arithmetic on two int64_t is checked for overflow, and falls back to cpp_int
+ * when it overflows. A result that fits in 64 bits is always stored as an int64_t, so that equal numbers have the
+ * same representation.
+ */
 class number_t final {
-    cpp_int _n{};
+    std::variant<int64_t, cpp_int> _n{int64_t{0}};
+
+    [[nodiscard]]
+    const int64_t* small() const {
+        return std::get_if<int64_t>(&_n);
+    }
+
+    [[nodiscard]]
+    cpp_int big() const {
+        if (const int64_t* n = small()) {
+            return *n;
+        }
+        return std::get<cpp_int>(_n);
+    }
+
+    // Apply f to this and x as cpp_int, without copying those already stored as such.
+    template <typename F>
+    [[nodiscard]]
+    number_t big_op(const number_t& x, F f) const {
+        const cpp_int* a = std::get_if<cpp_int>(&_n);
+        const cpp_int* b = std::get_if<cpp_int>(&x._n);
+        if (a && b) {
+            return number_t(f(*a, *b));
+        }
+        return number_t(f(a ? *a : cpp_int{*small()}, b ? *b : cpp_int{*x.small()}));
+    }
+
+    // Construct the alternative in place rather than assigning it over the default int64_t: GCC cannot follow the
+    // assignment and reports reads of the limbs of the cpp_int as uninitialized (-Wmaybe-uninitialized).
+    static std::variant<int64_t, cpp_int> representation_of(const std::integral auto n) {
+        if (std::in_range<int64_t>(n)) {
+            return std::variant<int64_t, cpp_int>{std::in_place_type<int64_t>, static_cast<int64_t>(n)};
+        }
+        return std::variant<int64_t, cpp_int>{std::in_place_type<cpp_int>, n};
+    }
+
+    void set(cpp_int n) {
+        if (std::numeric_limits<int64_t>::min() <= n && n <= std::numeric_limits<int64_t>::max()) {
+            _n.emplace<int64_t>(static_cast<int64_t>(n));
+        } else {
+            _n.emplace<cpp_int>(std::move(n));
+        }
+    }
+
+    // Callers make sure the value fits in T.
+    template <std::integral T>
+    [[nodiscard]]
+    T unchecked_cast() const {
+        if (const int64_t* n = small()) {
+            return static_cast<T>(*n);
+        }
+        return static_cast<T>(std::get<cpp_int>(_n));
+    }
 
   public:
     number_t() = default;
-    number_t(cpp_int n) : _n(std::move(n)) {}
-    number_t(std::integral auto n) : _n{n} {}
-    number_t(is_enum auto n) : _n{static_cast<std::underlying_type_t<decltype(n)>>(n)} {}
-    explicit number_t(const std::string& s) { _n = cpp_int(s); }
+    number_t(cpp_int n) { set(std::move(n)); }
+    number_t(std::integral auto n) : _n{representation_of(n)} {}
+    number_t(is_enum auto n) : number_t{static_cast<std::underlying_type_t<decltype(n)>>(n)} {}
+    explicit number_t(const std::string& s) { set(cpp_int(s)); }
 
     template <std::integral T>
     T narrow() const {
         if (!fits<T>()) {
-            CRAB_ERROR("number_t ", _n, " does not fit into ", typeid(T).name());
+            CRAB_ERROR("number_t ", *this, " does not fit into ", typeid(T).name());
         }
-        return static_cast<T>(_n);
+        return unchecked_cast<T>();
     }
 
     template <is_enum T>
     T narrow() const {
-        return static_cast<T>(static_cast<std::underlying_type_t<T>>(_n));
+        return static_cast<T>(unchecked_cast<std::underlying_type_t<T>>());
     }
 
     template <is_enum T>
     T cast_to() const {
-        return static_cast<T>(static_cast<std::underlying_type_t<T>>(_n));
+        return static_cast<T>(unchecked_cast<std::underlying_type_t<T>>());
     }
 
-    explicit operator cpp_int() const { return _n; }
+    explicit operator cpp_int() const { return big(); }
 
     [[nodiscard]]
     friend std::size_t hash_value(const number_t& z) {
-        return hash_value(z._n);
+        if (const int64_t* n = z.small()) {
+            return std::hash<int64_t>{}(*n);
+        }
+        return hash_value(std::get<cpp_int>(z._n));
     }
 
     template <std::integral T>
     [[nodiscard]]
     bool fits() const {
-        return std::numeric_limits<T>::min() <= _n && _n <= std::numeric_limits<T>::max();
+        if (const int64_t* n = small()) {
+            return std::in_range<T>(*n);
+        }
+        const cpp_int& n = std::get<cpp_int>(_n);
+        return std::numeric_limits<T>::min() <= n && n <= std::numeric_limits<T>::max();
     }
 
     template <std::integral T>
@@ -67,13 +138,13 @@ class number_t final {
     [[nodiscard]]
     T cast_to() const {
         if (fits<T>()) {
-            return static_cast<T>(_n);
+            return unchecked_cast<T>();
         }
         using Q = swap_signedness<T>;
         if (fits<Q>()) {
-            return static_cast<T>(static_cast<Q>(_n));
+            return static_cast<T>(unchecked_cast<Q>());
         }
-        CRAB_ERROR("number_t ", _n, " does not fit into ", typeid(T).name());
+        CRAB_ERROR("number_t ", *this, " does not fit into ", typeid(T).name());
     }
 
     // Allow casting to intX_t as needed for finite width operations.
@@ -105,8 +176,12 @@ class number_t final {
     template <std::integral T>
     T truncate_to() const {
         using U = std::make_unsigned_t<T>;
+        if (const int64_t* n = small()) {
+            // Converting to an unsigned type keeps the low bits of the two's complement representation.
+            return static_cast<T>(static_cast<U>(*n));
+        }
         constexpr U mask = std::numeric_limits<U>::max();
-        return static_cast<T>(static_cast<U>(_n & mask));
+        return static_cast<T>(static_cast<U>(std::get<cpp_int>(_n) & mask));
     }
 
     // Allow truncating to signed int as needed for finite width operations.
@@ -117,12 +192,23 @@ class number_t final {
         if (width <= 0) {
             return *this;
         }
+        if (const int64_t* n = small()) {
+            if (width >= 64) {
+                return *this;
+            }
+            const uint64_t value_mask = (uint64_t{1} << width) - 1;
+            const uint64_t truncated = static_cast<uint64_t>(*n) & value_mask;
+            if (truncated >> (width - 1)) {
+                return static_cast<int64_t>(truncated | ~value_mask);
+            }
+            return static_cast<int64_t>(truncated);
+        }
 
         // Create a mask for the sign bit.
         const cpp_int sign_bit = cpp_int(1) << (width - 1);
         const cpp_int value_mask = (cpp_int(1) << width) - 1;
 
-        const cpp_int truncated = _n & value_mask;
+        const cpp_int truncated = std::get<cpp_int>(_n) & value_mask;
 
         // If sign bit is set, extend with 1s; otherwise, return truncated.
         if (truncated & sign_bit) {
@@ -139,79 +225,115 @@ class number_t final {
         if (width <= 0) {
             return *this;
         }
+        if (const int64_t* n = small()) {
+            if (width < 64) {
+                return static_cast<int64_t>(static_cast<uint64_t>(*n) & ((uint64_t{1} << width) - 1));
+            }
+            if (width == 64 || *n >= 0) {
+                return static_cast<uint64_t>(*n);
+            }
+        }
         const cpp_int value_mask = (cpp_int(1) << width) - 1;
-        const cpp_int truncated = _n & value_mask;
+        const cpp_int truncated = big() & value_mask;
         return truncated;
     }
 
     static number_t max_uint(const int width) { return max_int(width + 1); }
 
-    static number_t max_int(const int width) { return number_t{(cpp_int(1) << (width - 1)) - 1}; }
+    static number_t max_int(const int width) {
+        if (width <= 64) {
+            return static_cast<int64_t>((uint64_t{1} << (width - 1)) - 1);
+        }
+        return number_t{(cpp_int(1) << (width - 1)) - 1};
+    }
 
-    static number_t min_int(const int width) { return number_t{-(cpp_int(1) << (width - 1))}; }
+    static number_t min_int(const int width) {
+        if (width <= 64) {
+            return static_cast<int64_t>(~((uint64_t{1} << (width - 1)) - 1));
+        }
+        return number_t{-(cpp_int(1) << (width - 1))};
+    }
 
-    number_t operator+(const number_t& x) const { return number_t(_n + x._n); }
+    number_t operator+(const number_t& x) const {
+        if (small() && x.small()) {
+            if (const auto r = checked_add(*small(), *x.small())) {
+                return *r;
+            }
+        }
+        return big_op(x, [](const cpp_int& a, const cpp_int& b) -> cpp_int { return a + b; });
+    }
 
-    number_t operator*(const number_t& x) const { return number_t(_n * x._n); }
+    number_t operator*(const number_t& x) const {
+        if (small() && x.small()) {
+            if (const auto r = checked_mul(*small(), *x.small())) {
+                return *r;
+            }
+        }
+        return big_op(x, [](const cpp_int& a, const cpp_int& b) -> cpp_int { return a * b; });
+    }
 
-    number_t operator-(const number_t& x) const { return number_t(_n - x._n); }
+    number_t operator-(const number_t& x) const {
+        if (small() && x.small()) {
+            if (const auto r = checked_sub(*small(), *x.small())) {
+                return *r;
+            }
+        }
+        return big_op(x, [](const cpp_int& a, const cpp_int& b) -> cpp_int { return a - b; });
+    }
 
-    number_t operator-() const { return number_t(-_n); }
+    number_t operator-() const {
+        if (const int64_t* n = small(); n && *n != std::numeric_limits<int64_t>::min()) {
+            return -*n;
+        }
+        return number_t(-big());
+    }
 
     number_t operator/(const number_t& x) const {
-        if (x._n.is_zero()) {
+        if (x == 0) {
             CRAB_ERROR("number_t: division by zero [1]");
         }
-        return number_t(_n / x._n);
+        if (small() && x.small()) {
+            if (const auto r = checked_div(*small(), *x.small())) {
+                return *r;
+            }
+        }
+        return big_op(x, [](const cpp_int& a, const cpp_int& b) -> cpp_int { return a / b; });
     }
 
     number_t operator%(const number_t& x) const {
-        if (x._n.is_zero()) {
+        if (x == 0) {
             CRAB_ERROR("number_t: division by zero [2]");
         }
-        return number_t(_n % x._n);
+        if (small() && x.small()) {
+            // The remainder has the sign of the dividend, as with cpp_int. Dividing by -1 could overflow.
+            return *x.small() == -1 ? 0 : *small() % *x.small();
+        }
+        return big_op(x, [](const cpp_int& a, const cpp_int& b) -> cpp_int { return a % b; });
     }
 
-    number_t& operator+=(const number_t& x) {
-        _n += x._n;
-        return *this;
-    }
+    number_t& operator+=(const number_t& x) { return *this = *this + x; }
 
-    number_t& operator*=(const number_t& x) {
-        _n *= x._n;
-        return *this;
-    }
+    number_t& operator*=(const number_t& x) { return *this = *this * x; }
 
-    number_t& operator-=(const number_t& x) {
-        _n -= x._n;
-        return *this;
-    }
+    number_t& operator-=(const number_t& x) { return *this = *this - x; }
 
     number_t& operator/=(const number_t& x) {
-        if (x._n.is_zero()) {
+        if (x == 0) {
             CRAB_ERROR("number_t: division by zero [3]");
         }
-        _n /= x._n;
-        return *this;
+        return *this = *this / x;
     }
 
     number_t& operator%=(const number_t& x) {
-        if (x._n.is_zero()) {
+        if (x == 0) {
             CRAB_ERROR("number_t: division by zero [4]");
         }
-        _n %= x._n;
-        return *this;
+        return *this = *this % x;
     }
 
-    number_t& operator--() & {
-        --_n;
-        return *this;
-    }
+    number_t& operator--() & { return *this -= 1; }
 
-    number_t& operator++() & {
-        ++_n;
-        return *this;
-    }
+    number_t& operator++() & { return *this += 1; }
 
     number_t operator++(int) & {
         number_t r(*this);
@@ -225,34 +347,74 @@ class number_t final {
         return r;
     }
 
+  private:
+    // Negative, zero or positive as this is less than, equal to or greater than x.
+    [[nodiscard]]
+    int compare(const number_t& x) const {
+        if (small() && x.small()) {
+            return (*small() > *x.small()) - (*small() < *x.small());
+        }
+        // A number stored as a cpp_int does not fit in 64 bits, so it is beyond every number stored as an int64_t.
+        if (small()) {
+            return -std::get<cpp_int>(x._n).sign();
+        }
+        if (x.small()) {
+            return std::get<cpp_int>(_n).sign();
+        }
+        return std::get<cpp_int>(_n).compare(std::get<cpp_int>(x._n));
+    }
+
+  public:
     bool operator==(const number_t& x) const { return _n == x._n; }
 
     bool operator!=(const number_t& x) const { return _n != x._n; }
 
-    bool operator<(const number_t& x) const { return _n < x._n; }
+    bool operator<(const number_t& x) const { return compare(x) < 0; }
 
-    bool operator<=(const number_t& x) const { return _n <= x._n; }
+    bool operator<=(const number_t& x) const { return compare(x) <= 0; }
 
-    bool operator>(const number_t& x) const { return _n > x._n; }
+    bool operator>(const number_t& x) const { return compare(x) > 0; }
 
-    bool operator>=(const number_t& x) const { return _n >= x._n; }
+    bool operator>=(const number_t& x) const { return compare(x) >= 0; }
 
-    number_t abs() const { return _n < 0 ? -_n : _n; }
+    number_t abs() const { return *this < 0 ? -*this : *this; }
 
-    number_t operator&(const number_t& x) const { return number_t(_n & x._n); }
+    number_t operator&(const number_t& x) const {
+        if (small() && x.small()) {
+            return *small() & *x.small();
+        }
+        return big_op(x, [](const cpp_int& a, const cpp_int& b) -> cpp_int { return a & b; });
+    }
 
-    number_t operator|(const number_t& x) const { return number_t(_n | x._n); }
+    number_t operator|(const number_t& x) const {
+        if (small() && x.small()) {
+            return *small() | *x.small();
+        }
+        return big_op(x, [](const cpp_int& a, const cpp_int& b) -> cpp_int { return a | b; });
+    }
 
-    number_t operator^(const number_t& x) const { return number_t(_n ^ x._n); }
+    number_t operator^(const number_t& x) const {
+        if (small() && x.small()) {
+            return *small() ^ *x.small();
+        }
+        return big_op(x, [](const cpp_int& a, const cpp_int& b) -> cpp_int { return a ^ b; });
+    }
 
     number_t operator<<(const number_t& x) const {
         if (x < 0) {
             CRAB_ERROR("Shift amount cannot be negative");
         }
         if (!x.fits<int32_t>()) {
-            CRAB_ERROR("number_t ", x._n, " does not fit into an int32");
+            CRAB_ERROR("number_t ", x, " does not fit into an int32");
         }
-        return number_t(_n << x.narrow<int32_t>());
+        const int32_t shift = x.narrow<int32_t>();
+        if (const int64_t* n = small(); n && shift < 64) {
+            const int64_t r = static_cast<int64_t>(static_cast<uint64_t>(*n) << shift);
+            if (r >> shift == *n) {
+                return r;
+            }
+        }
+        return number_t(big() << shift);
     }
 
     number_t operator>>(const number_t& x) const {
@@ -260,17 +422,25 @@ class number_t final {
             CRAB_ERROR("Shift amount cannot be negative");
         }
         if (!x.fits<int32_t>()) {
-            CRAB_ERROR("number_t ", x._n, " does not fit into an int32");
+            CRAB_ERROR("number_t ", x, " does not fit into an int32");
+        }
+        const int32_t shift = x.narrow<int32_t>();
+        if (const int64_t* n = small()) {
+            // Like cpp_int, shift negative numbers arithmetically.
+            return shift < 64 ? *n >> shift : (*n < 0 ? -1 : 0);
         }
-        return number_t(_n >> x.narrow<int32_t>());
+        return number_t(std::get<cpp_int>(_n) >> shift);
     }
 
     [[nodiscard]]
     number_t fill_ones() const {
-        if (_n.is_zero()) {
+        if (*this == 0) {
             return number_t(static_cast<signed long long>(0));
         }
-        return number_t{(cpp_int(1) << (msb(_n) + 1)) - 1};
+        if (const int64_t* n = small(); n && *n > 0) {
+            return static_cast<int64_t>((uint64_t{1} << std::bit_width(static_cast<uint64_t>(*n))) - 1);
+        }
+        return number_t{(cpp_int(1) << (msb(big()) + 1)) - 1};
     }
 
     friend std::ostream& operator<<(std::ostream& o, const number_t& z);
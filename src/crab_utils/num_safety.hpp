@@ -3,6 +3,12 @@
 #pragma once
 
 #include <concepts>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#ifndef __GNUC__
+#include <boost/multiprecision/cpp_int.hpp>
+#endif
 
 #include <gsl/narrow>
 
@@ -27,4 +33,40 @@ constexpr auto keep_signed(std::signed_integral auto x) -> decltype(x) { return
 
 // a guard to ensure that the signedness of the result is the same as the input
 constexpr auto keep_unsigned(std::unsigned_integral auto x) -> decltype(x) { return x; }
+
+// Overflow-checked 64-bit arithmetic, returning nothing on overflow.
+// Current implementation is based on
+// https://blog.regehr.org/archives/1139 using wider integers.
+#ifdef __GNUC__
+// TODO/FIXME: the current code compiles assuming the type __int128
+// exists. Both clang and gcc supports __int128 if the targeted
+// architecture is x86/64, but it won't work with 32 bits.
+using checked_wideint_t = __int128;
+#else
+using checked_wideint_t = boost::multiprecision::int128_t;
+#endif
+
+inline std::optional<int64_t> checked_narrow(const checked_wideint_t lr) {
+    if (lr > std::numeric_limits<int64_t>::max() || lr < std::numeric_limits<int64_t>::min()) {
+        return {};
+    }
+    return static_cast<int64_t>(lr);
+}
+
+inline std::optional<int64_t> checked_add(const int64_t a, const int64_t b) {
+    return checked_narrow(static_cast<checked_wideint_t>(a) + static_cast<checked_wideint_t>(b));
+}
+
+inline std::optional<int64_t> checked_sub(const int64_t a, const int64_t b) {
+    return checked_narrow(static_cast<checked_wideint_t>(a) - static_cast<checked_wideint_t>(b));
+}
+
+inline std::optional<int64_t> checked_mul(const int64_t a, const int64_t b) {
+    return checked_narrow(static_cast<checked_wideint_t>(a) * static_cast<checked_wideint_t>(b));
+}
+
+// precondition: b != 0
+inline std::optional<int64_t> checked_div(const int64_t a, const int64_t b) {
+    return checked_narrow(static_cast<checked_wideint_t>(a) / static_cast<checked_wideint_t>(b));
+}
 } // namespace crab
@@ -21,6 +21,11 @@ void CrabStats::clear_thread_local_state() {
     sw.clear();
 }
 
+void CrabStats::swap_thread_local_state(state_t& state) {
+    counters.swap(state.counters);
+    sw.swap(state.sw);
+}
+
 // Gets the amount of user CPU time used, in microseconds.
 long Stopwatch::systemTime() const {
 #ifdef _WIN32
@@ -40,7 +40,14 @@ class CrabStats {
     static thread_local lazy_allocator<std::map<std::string, Stopwatch>> sw;
 
   public:
+    /// The statistics of a verifier context while another one is bound to the thread.
+    struct state_t {
+        lazy_allocator<std::map<std::string, unsigned>> counters;
+        lazy_allocator<std::map<std::string, Stopwatch>> sw;
+    };
+
     static void clear_thread_local_state();
+    static void swap_thread_local_state(state_t& state);
 
     static void reset();
 
@@ -0,0 +1,196 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#include <exception>
+#include <optional>
+
+#include "crab_utils/work_stealing_pool.hpp"
+
+namespace crab {
+
+/// The pool the current thread is a worker of, if any, and the index of its queue in that pool.
+static thread_local const work_stealing_pool_t* current_pool = nullptr;
+static thread_local size_t current_pool_queue = 0;
+
+struct work_stealing_pool_t::dag_state_t {
+    const std::vector<std::vector<size_t>>& successors;
+    const std::function<void(size_t)>& body;
+    std::vector<std::atomic<size_t>> pending;
+    std::atomic<size_t> remaining;
+    /// Number of nodes of this DAG sitting in some queue.
+    std::atomic<size_t> queued{0};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+};
+
+work_stealing_pool_t::work_stealing_pool_t(const size_t n_workers, const std::function<void()>& on_start) {
+    for (size_t i = 0; i <= n_workers; i++) {
+        _queues.emplace_back(std::make_unique<queue_t>());
+    }
+    for (size_t i = 1; i <= n_workers; i++) {
+        _workers.emplace_back([this, i, on_start] { worker_loop(i, on_start); });
+    }
+}
+
+work_stealing_pool_t::~work_stealing_pool_t() {
+    {
+        std::lock_guard lock(_mutex);
+        _stop = true;
+    }
+    _cv.notify_all();
+    for (auto& worker : _workers) {
+        worker.join();
+    }
+}
+
+size_t work_stealing_pool_t::current_queue() const { return current_pool == this ? current_pool_queue : 0; }
+
+void work_stealing_pool_t::push(const size_t queue, const entry_t entry) {
+    {
+        // Count the entry before it becomes visible, since the DAG may be gone as soon as it has been run.
+        // Increment under the lock so that a thread about to wait cannot miss the notification.
+        std::lock_guard lock(_mutex);
+        ++entry.dag->queued;
+        ++_queued;
+    }
+    {
+        std::lock_guard lock(_queues[queue]->mutex);
+        _queues[queue]->tasks.push_back(entry);
+    }
+    // Not every waiting thread may take this entry, so wake them all.
+    _cv.notify_all();
+}
+
+void work_stealing_pool_t::wake_all() {
+    { std::lock_guard lock(_mutex); }
+    _cv.notify_all();
+}
+
+bool work_stealing_pool_t::try_run_one(const size_t queue, const dag_state_t* only_dag) {
+    std::optional<entry_t> entry;
+    for (size_t i = 0; i < _queues.size() && !entry; i++) {
+        const size_t victim = (queue + i) % _queues.size();
+        std::lock_guard lock(_queues[victim]->mutex);
+        auto& tasks = _queues[victim]->tasks;
+        if (only_dag) {
+            // Our own queue is searched from the back, other queues from the front.
+            if (victim == queue) {
+                for (auto it = tasks.end(); it != tasks.begin();) {
+                    if ((--it)->dag == only_dag) {
+                        entry = *it;
+                        tasks.erase(it);
+                        break;
+                    }
+                }
+            } else {
+                for (auto it = tasks.begin(); it != tasks.end(); ++it) {
+                    if (it->dag == only_dag) {
+                        entry = *it;
+                        tasks.erase(it);
+                        break;
+                    }
+                }
+            }
+        } else if (!tasks.empty()) {
+            // Work on our own most recent task (best locality), but steal the oldest task of others.
+            if (victim == queue) {
+                entry = tasks.back();
+                tasks.pop_back();
+            } else {
+                entry = tasks.front();
+                tasks.pop_front();
+            }
+        }
+        if (entry) {
+            --entry->dag->queued;
+            --_queued;
+        }
+    }
+    if (!entry) {
+        return false;
+    }
+    run_node(*entry->dag, entry->node);
+    return true;
+}
+
+void work_stealing_pool_t::run_node(dag_state_t& dag, const size_t node) {
+    if (!dag.failed) {
+        try {
+            dag.body(node);
+        } catch (...) {
+            std::lock_guard lock(dag.error_mutex);
+            if (!dag.failed.exchange(true)) {
+                dag.error = std::current_exception();
+            }
+        }
+    }
+    for (const size_t s : dag.successors[node]) {
+        if (--dag.pending[s] == 0) {
+            push(current_queue(), {&dag, s});
+        }
+    }
+    // Once the count drops to zero, run_dag() may return and destroy the DAG state.
+    if (--dag.remaining == 0) {
+        wake_all();
+    }
+}
+
+void work_stealing_pool_t::worker_loop(const size_t queue, const std::function<void()>& on_start) {
+    current_pool = this;
+    current_pool_queue = queue;
+    if (on_start) {
+        on_start();
+    }
+    while (true) {
+        if (try_run_one(queue, nullptr)) {
+            continue;
+        }
+        std::unique_lock lock(_mutex);
+        _cv.wait(lock, [this] { return _stop || _queued > 0; });
+        if (_stop) {
+            return;
+        }
+    }
+}
+
+void work_stealing_pool_t::run_dag(const std::vector<std::vector<size_t>>& successors,
+                                   const std::function<void(size_t)>& body) {
+    const size_t n = successors.size();
+    if (n == 0) {
+        return;
+    }
+
+    dag_state_t dag{.successors = successors,
+                    .body = body,
+                    .pending = std::vector<std::atomic<size_t>>(n),
+                    .remaining = n};
+    for (const auto& succs : successors) {
+        for (const size_t s : succs) {
+            ++dag.pending[s];
+        }
+    }
+
+    // Collect the sources before pushing any of them, since running a source may already release other nodes.
+    std::vector<size_t> sources;
+    for (size_t node = 0; node < n; node++) {
+        if (dag.pending[node] == 0) {
+            sources.push_back(node);
+        }
+    }
+    const size_t queue = current_queue();
+    for (const size_t node : sources) {
+        push(queue, {&dag, node});
+    }
+    while (dag.remaining > 0) {
+        if (try_run_one(queue, &dag)) {
+            continue;
+        }
+        std::unique_lock lock(_mutex);
+        _cv.wait(lock, [&] { return dag.remaining == 0 || dag.queued > 0; });
+    }
+    if (dag.error) {
+        std::rethrow_exception(dag.error);
+    }
+}
+
+} // namespace crab
@@ -0,0 +1,87 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace crab {
+
+/**
+ * @brief A fixed set of threads that execute the nodes of dependency DAGs.
+ *
+ * Each thread owns a deque of ready tasks. A thread pops the most recently pushed task from its own deque
+ * and, once that deque is empty, steals the oldest task from the deque of another thread.
+ * The thread that calls run_dag() takes part in the work until the whole DAG has been executed,
+ * so run_dag() may be called again from inside a task to run a nested DAG. While waiting, it only runs
+ * nodes of its own DAG: picking up an unrelated task could leave its own DAG unable to finish until
+ * that task does, and that task could in turn be waiting for a DAG buried below on the same thread.
+ */
+class work_stealing_pool_t final {
+  public:
+    /**
+     * @brief Start the worker threads.
+     *
+     * @param[in] n_workers Number of threads to spawn in addition to the thread calling run_dag().
+     * @param[in] on_start Called once on each spawned thread before it runs any task,
+     * typically to set up its thread-local state.
+     */
+    work_stealing_pool_t(size_t n_workers, const std::function<void()>& on_start);
+
+    work_stealing_pool_t(const work_stealing_pool_t&) = delete;
+    work_stealing_pool_t& operator=(const work_stealing_pool_t&) = delete;
+
+    ~work_stealing_pool_t();
+
+    /**
+     * @brief Call body(i) once for every node i of a DAG, each call starting only after
+     * body(j) returned for every j such that i is in successors[j].
+     *
+     * If some call throws, the remaining nodes are not run and the first exception is rethrown
+     * once no call is in progress anymore.
+     *
+     * @param[in] successors Adjacency list of the DAG. Nodes are 0 .. successors.size() - 1.
+     * @param[in] body The work to do for each node.
+     */
+    void run_dag(const std::vector<std::vector<size_t>>& successors, const std::function<void(size_t)>& body);
+
+  private:
+    struct dag_state_t;
+
+    struct entry_t {
+        dag_state_t* dag;
+        size_t node;
+    };
+
+    struct queue_t {
+        std::mutex mutex;
+        std::deque<entry_t> tasks;
+    };
+
+    /// One queue per spawned worker, plus queue 0 which belongs to threads outside the pool.
+    std::vector<std::unique_ptr<queue_t>> _queues;
+    std::vector<std::thread> _workers;
+
+    /// Protects the idle-wait protocol below.
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    std::atomic<size_t> _queued{0};
+    bool _stop{false};
+
+    [[nodiscard]]
+    size_t current_queue() const;
+    void push(size_t queue, entry_t entry);
+    bool try_run_one(size_t queue, const dag_state_t* only_dag);
+    void run_node(dag_state_t& dag, size_t node);
+    void wake_all();
+    void worker_loop(size_t queue, const std::function<void()>& on_start);
+};
+
+} // namespace crab
@@ -5,6 +5,7 @@
  *  the verification process and returning the results.
  **/
 
+#include <algorithm>
 #include <map>
 #include <ranges>
 #include <string>
@@ -13,6 +14,7 @@
 #include "asm_syntax.hpp"
 #include "crab/ebpf_domain.hpp"
 #include "crab/fwd_analyzer.hpp"
+#include "crab_utils/graph_ops.hpp"
 #include "crab_utils/lazy_allocator.hpp"
 #include "crab_verifier.hpp"
 #include "string_constraints.hpp"
@@ -24,22 +26,107 @@ thread_local crab::lazy_allocator<program_info> thread_local_program_info;
 thread_local ebpf_verifier_options_t thread_local_options;
 void ebpf_verifier_clear_before_analysis();
 
+Invariants::Invariants(const Program& prog, crab::analysis_result_t&& result)
+    : invariants(std::move(result.invariants)), loop_stats(std::move(result.loop_statistics)),
+      over_budget_transfers(result.over_budget_transfers), chains(std::move(result.chains)) {
+    if (!chains.empty()) {
+        this->prog = &prog;
+        for (const auto& [first, bb] : chains) {
+            for (const label_t& label : bb) {
+                chain_of.emplace(label, first);
+            }
+        }
+    }
+    for (crab::analysis_result_t& context : result.call_contexts) {
+        call_contexts.emplace_back(prog, std::move(context));
+    }
+}
+
+bool Invariants::contains(const label_t& label) const {
+    return prog ? chain_of.contains(label) : invariants.contains(label);
+}
+
+crab::invariant_map_pair Invariants::at(const label_t& label) const {
+    if (!call_contexts.empty() && !contains(label)) {
+        crab::invariant_map_pair res{ebpf_domain_t::bottom(), ebpf_domain_t::bottom()};
+        for (const Invariants& context : call_contexts) {
+            if (context.contains(label)) {
+                auto [pre, post] = context.at(label);
+                res.pre |= std::move(pre);
+                res.post |= std::move(post);
+            }
+        }
+        return res;
+    }
+    if (!prog) {
+        return invariants.at(label);
+    }
+    const label_t& first = chain_of.at(label);
+    const crab::basic_block_t& bb = chains.at(first);
+    ebpf_domain_t pre = invariants.at(first).pre;
+    for (const label_t& prev : bb) {
+        if (prev == label) {
+            break;
+        }
+        crab::apply_transformer(*prog, prev, pre);
+    }
+    if (label == bb.last_label()) {
+        return {std::move(pre), invariants.at(first).post};
+    }
+    ebpf_domain_t post = pre;
+    crab::apply_transformer(*prog, label, post);
+    return {std::move(pre), std::move(post)};
+}
+
+bool Invariants::for_each_label(
+    const std::function<bool(const label_t&, const ebpf_domain_t&, const ebpf_domain_t&)>& f) const {
+    if (!prog) {
+        for (const auto& [label, inv_pair] : invariants) {
+            if (!f(label, inv_pair.pre, inv_pair.post)) {
+                return false;
+            }
+        }
+    } else {
+        for (const auto& [first, bb] : chains) {
+            const auto& chain_invariants = invariants.at(first);
+            ebpf_domain_t pre = chain_invariants.pre;
+            for (const label_t& label : bb) {
+                if (label == bb.last_label()) {
+                    if (!f(label, pre, chain_invariants.post)) {
+                        return false;
+                    }
+                    break;
+                }
+                ebpf_domain_t post = pre;
+                crab::apply_transformer(*prog, label, post);
+                if (!f(label, pre, post)) {
+                    return false;
+                }
+                pre = std::move(post);
+            }
+        }
+    }
+    return std::ranges::all_of(call_contexts,
+                               [&](const Invariants& context) { return context.for_each_label(f); });
+}
+
 bool Invariants::is_valid_after(const label_t& label, const string_invariant& state) const {
     const ebpf_domain_t abstract_state =
         ebpf_domain_t::from_constraints(state.value(), thread_local_options.setup_constraints);
-    return abstract_state <= invariants.at(label).post;
+    return abstract_state <= at(label).post;
 }
 
-string_invariant Invariants::invariant_at(const label_t& label) const { return invariants.at(label).post.to_set(); }
+string_invariant Invariants::invariant_at(const label_t& label) const { return at(label).post.to_set(); }
 
-crab::interval_t Invariants::exit_value() const { return invariants.at(label_t::exit).post.get_r0(); }
+crab::interval_t Invariants::exit_value() const { return at(label_t::exit).post.get_r0(); }
 
 int Invariants::max_loop_count() const {
     crab::extended_number max_loop_count{0};
     // Gather the upper bound of loop counts from post-invariants.
-    for (const auto& inv_pair : std::views::values(invariants)) {
-        max_loop_count = std::max(max_loop_count, inv_pair.post.get_loop_count_upper_bound());
-    }
+    for_each_label([&](const label_t&, const ebpf_domain_t&, const ebpf_domain_t& post) {
+        max_loop_count = std::max(max_loop_count, post.get_loop_count_upper_bound());
+        return true;
+    });
     const auto m = max_loop_count.number();
     if (m && m->fits<int32_t>()) {
         return m->cast_to<int32_t>();
@@ -47,8 +134,29 @@ int Invariants::max_loop_count() const {
     return std::numeric_limits<int>::max();
 }
 
+unsigned Invariants::over_budget_count() const {
+    unsigned res = over_budget_transfers;
+    for (const Invariants& context : call_contexts) {
+        res += context.over_budget_count();
+    }
+    return res;
+}
+
+std::pair<std::size_t, std::size_t> Invariants::max_numeric_size() const {
+    std::pair<std::size_t, std::size_t> res;
+    for_each_label([&](const label_t&, const ebpf_domain_t& pre, const ebpf_domain_t& post) {
+        for (const ebpf_domain_t* inv : {&pre, &post}) {
+            const auto [vertices, edges] = inv->numeric_size();
+            res.first = std::max(res.first, vertices);
+            res.second = std::max(res.second, edges);
+        }
+        return true;
+    });
+    return res;
+}
+
 Invariants analyze(const Program& prog, ebpf_domain_t&& entry_invariant) {
-    return Invariants{run_forward_analyzer(prog, std::move(entry_invariant))};
+    return Invariants{prog, run_forward_analyzer(prog, std::move(entry_invariant))};
 }
 
 Invariants analyze(const Program& prog) {
@@ -62,39 +170,103 @@ Invariants analyze(const Program& prog, const string_invariant& entry_invariant)
                    ebpf_domain_t::from_constraints(entry_invariant.value(), thread_local_options.setup_constraints));
 }
 
+static std::optional<crab::assertion_failure_t> verify_fail_fast(const Program& prog,
+                                                                 ebpf_domain_t&& entry_invariant) {
+    return run_forward_analyzer(prog, std::move(entry_invariant), true).failure;
+}
+
+std::optional<crab::assertion_failure_t> verify_fail_fast(const Program& prog) {
+    ebpf_verifier_clear_before_analysis();
+    return verify_fail_fast(prog, ebpf_domain_t::setup_entry(thread_local_options.setup_constraints));
+}
+
+std::optional<crab::assertion_failure_t> verify_fail_fast(const Program& prog,
+                                                          const string_invariant& entry_invariant) {
+    ebpf_verifier_clear_before_analysis();
+    return verify_fail_fast(
+        prog, ebpf_domain_t::from_constraints(entry_invariant.value(), thread_local_options.setup_constraints));
+}
+
+std::optional<Invariants> analyze_intervals(const Program& prog) {
+    // Restore the option even if the analysis throws.
+    struct restore_numeric_domain_t {
+        numeric_domain_t saved = thread_local_options.numeric_domain;
+        ~restore_numeric_domain_t() { thread_local_options.numeric_domain = saved; }
+    } restore;
+    thread_local_options.numeric_domain = numeric_domain_t::interval;
+
+    ebpf_verifier_clear_before_analysis();
+    crab::analysis_result_t result =
+        run_forward_analyzer(prog, ebpf_domain_t::setup_entry(thread_local_options.setup_constraints), true);
+    if (result.failure) {
+        return {};
+    }
+    return Invariants{prog, std::move(result)};
+}
+
+tiered_verdict_t verify_tiered(const Program& prog) {
+    // With the interval domain, there is only one tier.
+    if (thread_local_options.numeric_domain != numeric_domain_t::interval && analyze_intervals(prog)) {
+        return {.failure = {}, .tier = numeric_domain_t::interval};
+    }
+    return {.failure = verify_fail_fast(prog), .tier = thread_local_options.numeric_domain};
+}
+
+std::string to_string(const numeric_domain_t domain) {
+    switch (domain) {
+    case numeric_domain_t::interval: return "intervalCrab";
+    case numeric_domain_t::bounded_zone: return "boundedZoneCrab";
+    case numeric_domain_t::zone: return "zoneCrab";
+    }
+    return {};
+}
+
+std::optional<numeric_domain_t> numeric_domain_from_string(const std::string& name) {
+    for (const auto domain : {numeric_domain_t::interval, numeric_domain_t::bounded_zone, numeric_domain_t::zone}) {
+        if (to_string(domain) == name) {
+            return domain;
+        }
+    }
+    return {};
+}
+
 bool Invariants::verified(const Program& prog) const {
-    for (const auto& [label, inv_pair] : invariants) {
-        if (inv_pair.pre.is_bottom()) {
-            continue;
+    bool res = true;
+    for_each_label([&](const label_t& label, const ebpf_domain_t& pre, const ebpf_domain_t&) {
+        if (pre.is_bottom()) {
+            return true;
         }
         for (const Assertion& assertion : prog.assertions_at(label)) {
-            if (!ebpf_domain_check(inv_pair.pre, assertion).empty()) {
+            if (!ebpf_domain_check(pre, assertion).empty()) {
+                res = false;
                 return false;
             }
         }
-    }
-    return true;
+        return true;
+    });
+    return res;
 }
 
 Report Invariants::check_assertions(const Program& prog) const {
     Report report;
-    for (const auto& [label, inv_pair] : invariants) {
-        if (inv_pair.pre.is_bottom()) {
-            continue;
+    for_each_label([&](const label_t& label, const ebpf_domain_t& pre, const ebpf_domain_t& post) {
+        if (pre.is_bottom()) {
+            return true;
         }
         for (const Assertion& assertion : prog.assertions_at(label)) {
-            const auto warnings = ebpf_domain_check(inv_pair.pre, assertion);
+            const auto warnings = ebpf_domain_check(pre, assertion);
             for (const auto& msg : warnings) {
                 report.warnings[label].emplace_back(msg);
             }
         }
         if (const auto passume = std::get_if<Assume>(&prog.instruction_at(label))) {
-            if (inv_pair.post.is_bottom()) {
+            if (post.is_bottom()) {
                 const auto s = to_string(*passume);
                 report.reachability[label].emplace_back("Code becomes unreachable (" + s + ")");
             }
         }
-    }
+        return true;
+    });
     return report;
 }
 
@@ -109,3 +281,33 @@ void ebpf_verifier_clear_thread_local_state() {
     crab::domains::clear_thread_local_state();
     crab::domains::SplitDBM::clear_thread_local_state();
 }
+
+struct verifier_context_t::state_t {
+    ebpf_verifier_options_t options;
+    crab::lazy_allocator<program_info> info;
+    crab::lazy_allocator<crab::variable_registry_t> names;
+    std::shared_ptr<crab::domains::array_map_state_t> array_map = crab::domains::make_array_map_state();
+    crab::CrabStats::state_t stats;
+    crab::GraphOps::scratch_t graph_scratch;
+
+    // Binding and unbinding are the same exchange, so each gives the other side back what it had.
+    void swap_with_thread() {
+        std::swap(options, thread_local_options);
+        info.swap(thread_local_program_info);
+        crab::variable_t::swap_thread_local_state(names);
+        crab::domains::swap_thread_local_state(*array_map);
+        crab::CrabStats::swap_thread_local_state(stats);
+        crab::GraphOps::swap_thread_local_state(graph_scratch);
+    }
+};
+
+verifier_context_t::verifier_context_t() : _state(std::make_unique<state_t>()) {}
+verifier_context_t::~verifier_context_t() = default;
+verifier_context_t::verifier_context_t(verifier_context_t&&) noexcept = default;
+verifier_context_t& verifier_context_t::operator=(verifier_context_t&&) noexcept = default;
+
+verifier_context_t::scope_t::scope_t(verifier_context_t& context) : _state(*context._state) {
+    _state.swap_with_thread();
+}
+
+verifier_context_t::scope_t::~scope_t() { _state.swap_with_thread(); }
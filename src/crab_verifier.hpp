@@ -2,6 +2,13 @@
 // SPDX-License-Identifier: MIT
 #pragma once
 
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
 #include "config.hpp"
 #include "crab/fwd_analyzer.hpp"
 #include "program.hpp"
@@ -51,9 +58,34 @@ class Report final {
 
 class Invariants final {
     crab::invariant_table_t invariants;
+    crab::loop_statistics_table_t loop_stats;
+    unsigned over_budget_transfers{};
+
+    // When the invariants are compact, they are only kept for whole chains of labels, and those of the labels in
+    // a chain are recomputed from the pre of the chain. The program must then outlive this object.
+    const Program* prog{};
+    std::map<label_t, crab::basic_block_t> chains;
+    /// First label of the chain of each label.
+    std::map<label_t, label_t> chain_of;
+
+    /// When local calls are summarized, the invariants of the subprograms in each calling context.
+    std::vector<Invariants> call_contexts;
+
+    /// Whether these invariants are over the control-flow graph the label is in.
+    bool contains(const label_t& label) const;
+
+    /// The invariants before and after a label. Those of a label of a subprogram are joined over its calling contexts.
+    crab::invariant_map_pair at(const label_t& label) const;
+
+    /// Call f with each label and the invariants before and after it, until it returns false.
+    /// The labels of subprograms come once for each calling context.
+    /// @return Whether f always returned true.
+    bool for_each_label(
+        const std::function<bool(const label_t&, const crab::ebpf_domain_t&, const crab::ebpf_domain_t&)>& f) const;
 
   public:
     explicit Invariants(crab::invariant_table_t&& invariants) : invariants(std::move(invariants)) {}
+    Invariants(const Program& prog, crab::analysis_result_t&& result);
     Invariants(Invariants&& invariants) = default;
     Invariants(const Invariants& invariants) = default;
 
@@ -64,6 +96,17 @@ class Invariants final {
     crab::interval_t exit_value() const;
 
     int max_loop_count() const;
+
+    /// The largest number of vertices, and of edges, of the graph of the numerical domain in any invariant.
+    std::pair<std::size_t, std::size_t> max_numeric_size() const;
+
+    /// Work done by the fixpoint iterator on each loop, by loop head.
+    const crab::loop_statistics_table_t& loop_statistics() const { return loop_stats; }
+
+    /// Number of transformers after which the numerical domain forgot relations to stay within its budget, including
+    /// those of the calling contexts of subprograms.
+    unsigned over_budget_count() const;
+
     bool verified(const Program& prog) const;
     Report check_assertions(const Program& prog) const;
 
@@ -72,11 +115,65 @@ class Invariants final {
 
 Invariants analyze(const Program& prog);
 Invariants analyze(const Program& prog, const string_invariant& entry_invariant);
+
+/// Check the assertions of the program during the analysis, and stop at the first one that fails.
+/// This is faster than analyze() when only the verdict is needed, most of all for programs that are rejected.
+/// @return The failed assertion, or nothing if the program is verified.
+std::optional<crab::assertion_failure_t> verify_fail_fast(const Program& prog);
+std::optional<crab::assertion_failure_t> verify_fail_fast(const Program& prog, const string_invariant& entry_invariant);
 inline bool verify(const Program& prog) { return analyze(prog).verified(prog); }
 
+/// Analyze the program with the interval domain, and check its assertions during the analysis.
+/// @return The invariants if they prove every assertion, or nothing if the program needs a more precise domain.
+std::optional<Invariants> analyze_intervals(const Program& prog);
+
+struct tiered_verdict_t {
+    /// The failed assertion, or nothing if the program is verified.
+    std::optional<crab::assertion_failure_t> failure;
+    /// The numerical domain that decided.
+    numeric_domain_t tier{};
+};
+
+/// Verify the program with intervals first, and with the numerical domain of the options only when intervals do not
+/// prove it safe. The verdict is that of verify_fail_fast(), and usually comes much sooner for simple programs.
+tiered_verdict_t verify_tiered(const Program& prog);
+
+/// The name of a numerical domain, as check --domain takes it.
+std::string to_string(numeric_domain_t domain);
+std::optional<numeric_domain_t> numeric_domain_from_string(const std::string& name);
+
 int create_map_crab(const EbpfMapType& map_type, uint32_t key_size, uint32_t value_size, uint32_t max_entries,
                     ebpf_verifier_options_t options);
 
 EbpfMapDescriptor* find_map_descriptor(int map_fd);
 
 void ebpf_verifier_clear_thread_local_state();
+
+/// The state that the verifier finds on the thread it runs on: the options and program info that unmarshal() and
+/// Program::from_sequence() record, the variable names and array cells that the analysis makes, the statistics, and
+/// the scratch space of the graph algorithms. A context holds its own copy of all of it, and makes it the state of a
+/// thread while a scope binds it there. Analyses can thus take turns on one thread, each within a scope of its own
+/// context, and a context that is bound again reuses the scratch space it already allocated.
+class verifier_context_t final {
+    struct state_t;
+    std::unique_ptr<state_t> _state;
+
+  public:
+    verifier_context_t();
+    ~verifier_context_t();
+    verifier_context_t(verifier_context_t&&) noexcept;
+    verifier_context_t& operator=(verifier_context_t&&) noexcept;
+
+    /// Binds a context to the calling thread until the scope ends, and then gives the thread back the state it had.
+    /// A context is bound to at most one thread at a time, and the scopes of a thread end in the reverse order of
+    /// their start.
+    class scope_t final {
+        state_t& _state;
+
+      public:
+        explicit scope_t(verifier_context_t& context);
+        ~scope_t();
+        scope_t(const scope_t&) = delete;
+        scope_t& operator=(const scope_t&) = delete;
+    };
+};
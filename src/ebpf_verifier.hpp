@@ -8,3 +8,4 @@
 #include "crab_verifier.hpp"
 #include "platform.hpp"
 #include "program.hpp"
+#include "result_cache.hpp"
@@ -1,6 +1,7 @@
 // Copyright (c) Prevail Verifier contributors.
 // SPDX-License-Identifier: MIT
 #include <iostream>
+#include <optional>
 #include <vector>
 
 #include <boost/functional/hash.hpp>
@@ -11,6 +12,7 @@
 #else
 #include "memsize_linux.hpp"
 #endif
+#include "crab_utils/work_stealing_pool.hpp"
 #include "linux_verifier.hpp"
 
 // Avoid affecting other headers by macros.
@@ -65,6 +67,69 @@ static std::optional<raw_program> find_program(vector<raw_program>& raw_progs, c
     return {};
 }
 
+/// The verdict on one program of --all, and how long it took.
+struct program_verdict_t {
+    bool verified{};
+    double seconds{};
+    /// Why the program could not be analyzed, if it could not.
+    std::string error;
+};
+
+/// Verify one program of --all. Each thread verifies one program at a time with its own thread-local state, which
+/// is cleared for the next program.
+static program_verdict_t verify_program(const raw_program& raw_prog, const ebpf_verifier_options_t& options,
+                                        const std::optional<result_cache_t>& cache) {
+    program_verdict_t verdict;
+    const auto begin = std::chrono::steady_clock::now();
+    try {
+        if (cache) {
+            verdict.verified = verify_cached(raw_prog, options, *cache).verified;
+        } else {
+            thread_local_options = options;
+            std::variant<InstructionSeq, std::string> prog_or_error = unmarshal(raw_prog);
+            if (const auto error = std::get_if<string>(&prog_or_error)) {
+                throw UnmarshalError(*error);
+            }
+            const Program prog =
+                Program::from_sequence(std::get<InstructionSeq>(prog_or_error), raw_prog.info, options);
+            verdict.verified = options.tiered_verification ? !verify_tiered(prog).failure : !verify_fail_fast(prog);
+        }
+    } catch (const std::exception& e) {
+        // Any failure, such as a gsl::narrowing_error, is that of this program only, and must not end the batch.
+        verdict.error = e.what();
+    }
+    const auto end = std::chrono::steady_clock::now();
+    verdict.seconds = std::chrono::duration<double>(end - begin).count();
+    ebpf_verifier_clear_thread_local_state();
+    return verdict;
+}
+
+/// Print the failures, the loop bound and the tier of a verdict as the options ask, then the verdict line. Every path
+/// that verifies one program reports through here, so that the output does not depend on which path decided. When the
+/// analysis report is at hand, the failures are printed from it with their line information.
+/// @return The exit code.
+static int report_verdict(const verification_result_t& result, const double seconds,
+                          const ebpf_verifier_options_t& options, const Report* report = nullptr) {
+    if (options.verbosity_opts.print_failures) {
+        if (report) {
+            print_warnings(std::cout, *report);
+        } else {
+            for (const string& warning : result.warnings) {
+                std::cout << warning << "\n";
+            }
+            std::cout << "\n";
+        }
+    }
+    if (result.verified && options.cfg_opts.check_for_termination) {
+        std::cout << "Program terminates within " << result.max_loop_count << " loop iterations\n";
+    }
+    if (options.tiered_verification) {
+        std::cout << "Decided by " << to_string(result.tier) << "\n";
+    }
+    std::cout << result.verified << "," << seconds << "," << resident_set_size_kb() << "\n";
+    return result.verified ? 0 : 1;
+}
+
 int main(int argc, char** argv) {
     // Always call ebpf_verifier_clear_thread_local_state on scope exit.
     at_scope_exit<ebpf_verifier_clear_thread_local_state> clear_thread_local_state;
@@ -90,11 +155,20 @@ int main(int argc, char** argv) {
     bool list = false;
     app.add_flag("-l", list, "List programs");
 
+    bool all = false;
+    app.add_flag("--all", all,
+                 "Verify every program, and print section,function,verdict,seconds for each in the order of -l");
+
+    int jobs = 1;
+    app.add_option("--jobs", jobs, "Number of programs that --all verifies at once. Default: 1")
+        ->type_name("N")
+        ->check(CLI::PositiveNumber);
+
     std::string domain = "zoneCrab";
     app.add_option("--domain", domain, "Abstract domain")
         ->type_name("DOMAIN")
         ->capture_default_str()
-        ->check(CLI::IsMember({"stats", "linux", "zoneCrab", "cfg"}));
+        ->check(CLI::IsMember({"stats", "linux", "intervalCrab", "boundedZoneCrab", "zoneCrab", "cfg"}));
 
     app.add_flag("--termination,!--no-verify-termination", ebpf_verifier_options.cfg_opts.check_for_termination,
                  "Verify termination. Default: ignore")
@@ -108,6 +182,45 @@ int main(int argc, char** argv) {
                  "Apply additional checks that would cause runtime failures")
         ->group("Features");
 
+    app.add_option("--threads", ebpf_verifier_options.analysis_threads,
+                   "Number of threads used to analyze independent regions of the program. Default: 1")
+        ->group("Features")
+        ->type_name("N")
+        ->check(CLI::PositiveNumber);
+
+    app.add_option("--max-relations-per-variable", ebpf_verifier_options.max_relations_per_variable,
+                   "Most relations with other variables that boundedZoneCrab keeps for each variable; 0 keeps only "
+                   "the bounds. Default: 4")
+        ->group("Features")
+        ->type_name("N")
+        ->check(CLI::NonNegativeNumber);
+
+    app.add_option("--max-relations", ebpf_verifier_options.max_relations,
+                   "Most relations between variables that boundedZoneCrab keeps in all; 0 keeps only the bounds. "
+                   "Default: no limit")
+        ->group("Features")
+        ->type_name("N")
+        ->check(CLI::NonNegativeNumber);
+
+    app.add_flag("--compact-invariants", ebpf_verifier_options.compact_invariants,
+                 "Keep invariants only at the boundaries of chains of instructions to save memory. Default: disabled")
+        ->group("Features");
+
+    app.add_flag("--prune-dead-variables", ebpf_verifier_options.prune_dead_variables,
+                 "Forget dead registers and stack bytes before joins to keep the numerical domain small. "
+                 "Default: disabled")
+        ->group("Features");
+
+    app.add_flag("--tiered", ebpf_verifier_options.tiered_verification,
+                 "Try to verify with intervalCrab before the domain of --domain, and print which of the two decided. "
+                 "With -i, print the invariants of the domain that decided. Default: disabled")
+        ->group("Features");
+
+    app.add_flag("--summarize-local-calls", ebpf_verifier_options.cfg_opts.summarize_local_calls,
+                 "Analyze each subprogram once per calling context instead of inlining it at every call site. "
+                 "Default: disabled")
+        ->group("Features");
+
     std::set<std::string> include_groups = _get_conformance_group_names();
     app.add_option("--include_groups", include_groups, "Include conformance groups")
         ->group("Features")
@@ -142,6 +255,13 @@ int main(int argc, char** argv) {
     bool verbose = false;
     app.add_flag("-v", verbose, "Print both invariants and failures")->group("Verbosity");
 
+    std::string cache_dir;
+    app.add_option("--cache", cache_dir,
+                   "Reuse the results of earlier runs stored in DIR, and store new results there. "
+                   "Ignored when printing invariants")
+        ->group("Features")
+        ->type_name("DIR");
+
     std::string asmfile;
     app.add_option("--asm", asmfile, "Print disassembly to FILE")->group("CFG output")->type_name("FILE");
     std::string dotfile;
@@ -192,6 +312,10 @@ int main(int argc, char** argv) {
     if (domain == "linux") {
         ebpf_verifier_options.mock_map_fds = false;
     }
+    const std::optional<numeric_domain_t> numeric_domain = numeric_domain_from_string(domain);
+    if (numeric_domain) {
+        ebpf_verifier_options.numeric_domain = *numeric_domain;
+    }
 
     // Read a set of raw program sections from an ELF file.
     vector<raw_program> raw_progs;
@@ -202,6 +326,40 @@ int main(int argc, char** argv) {
         return 1;
     }
 
+    if (all && !list) {
+        if (!numeric_domain) {
+            std::cerr << "error: --all needs one of the domains intervalCrab, boundedZoneCrab or zoneCrab\n";
+            return 64;
+        }
+        std::optional<result_cache_t> cache;
+        if (!cache_dir.empty()) {
+            cache.emplace(cache_dir);
+            if (cache->off_reason()) {
+                std::cerr << "warning: not caching results: " << *cache->off_reason() << std::endl;
+                cache.reset();
+            }
+        }
+        // The ELF file is read once, and its programs are independent, so they are the nodes of a DAG with no edges.
+        std::vector<program_verdict_t> verdicts(raw_progs.size());
+        crab::work_stealing_pool_t pool(jobs - 1, {});
+        pool.run_dag(vector<vector<size_t>>(raw_progs.size()), [&](const size_t i) {
+            verdicts[i] = verify_program(raw_progs[i], ebpf_verifier_options, cache);
+        });
+        bool all_verified = true;
+        for (size_t i = 0; i < raw_progs.size(); i++) {
+            const raw_program& raw_prog = raw_progs[i];
+            const program_verdict_t& verdict = verdicts[i];
+            if (!verdict.error.empty()) {
+                std::cerr << "error: " << raw_prog.section_name << " " << raw_prog.function_name << ": "
+                          << verdict.error << std::endl;
+            }
+            std::cout << raw_prog.section_name << "," << raw_prog.function_name << "," << verdict.verified << ","
+                      << verdict.seconds << "\n";
+            all_verified = all_verified && verdict.verified;
+        }
+        return all_verified ? 0 : 1;
+    }
+
     std::optional<raw_program> found_prog = find_program(raw_progs, desired_program);
     if (list || !found_prog) {
         if (!list) {
@@ -221,6 +379,24 @@ int main(int argc, char** argv) {
     }
     raw_program raw_prog = *found_prog;
 
+    if (!cache_dir.empty() && numeric_domain && !ebpf_verifier_options.verbosity_opts.print_invariants &&
+        asmfile.empty()) {
+        try {
+            const auto begin = std::chrono::steady_clock::now();
+            const result_cache_t cache{cache_dir};
+            if (cache.off_reason()) {
+                std::cerr << "warning: not caching results: " << *cache.off_reason() << std::endl;
+            }
+            const verification_result_t result = verify_cached(raw_prog, ebpf_verifier_options, cache);
+            const auto end = std::chrono::steady_clock::now();
+            const auto seconds = std::chrono::duration<double>(end - begin).count();
+            return report_verdict(result, seconds, ebpf_verifier_options);
+        } catch (UnmarshalError& e) {
+            std::cerr << "error: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
     // Convert the raw program section to a set of instructions.
     std::variant<InstructionSeq, std::string> prog_or_error = unmarshal(raw_prog);
     if (auto prog = std::get_if<string>(&prog_or_error)) {
@@ -235,7 +411,7 @@ int main(int argc, char** argv) {
         print_map_descriptors(thread_local_program_info->map_descriptors, out);
     }
 
-    if (domain == "zoneCrab" || domain == "cfg") {
+    if (numeric_domain || domain == "cfg") {
         // Convert the instruction sequence to a control-flow graph.
         try {
             const auto verbosity = ebpf_verifier_options.verbosity_opts;
@@ -245,27 +421,57 @@ int main(int argc, char** argv) {
                 return 0;
             }
             const auto begin = std::chrono::steady_clock::now();
-            auto invariants = analyze(prog);
+            verification_result_t result;
+            if (!verbosity.print_invariants && !verbosity.print_failures &&
+                !ebpf_verifier_options.cfg_opts.check_for_termination) {
+                // Only the verdict is needed, so stop at the first failed assertion. The loop bound of --termination
+                // needs the invariants of the whole program.
+                const tiered_verdict_t verdict =
+                    ebpf_verifier_options.tiered_verification
+                        ? verify_tiered(prog)
+                        : tiered_verdict_t{.failure = verify_fail_fast(prog),
+                                           .tier = ebpf_verifier_options.numeric_domain};
+                const auto end = std::chrono::steady_clock::now();
+                const auto seconds = std::chrono::duration<double>(end - begin).count();
+                result.verified = !verdict.failure;
+                result.tier = verdict.tier;
+                return report_verdict(result, seconds, ebpf_verifier_options);
+            }
+            // With --tiered, the invariants are those of the first domain that proves the program safe. With the
+            // interval domain, there is only one tier.
+            const bool tiered = ebpf_verifier_options.tiered_verification &&
+                                ebpf_verifier_options.numeric_domain != numeric_domain_t::interval;
+            std::optional<Invariants> invariants = tiered ? analyze_intervals(prog) : std::nullopt;
+            result.tier = numeric_domain_t::interval;
+            if (!invariants) {
+                invariants.emplace(analyze(prog));
+                result.tier = ebpf_verifier_options.numeric_domain;
+            }
             const auto end = std::chrono::steady_clock::now();
             const auto seconds = std::chrono::duration<double>(end - begin).count();
             if (verbosity.print_invariants) {
-                print_invariants(std::cout, prog, verbosity.simplify, invariants);
+                print_invariants(std::cout, prog, verbosity.simplify, *invariants);
+                for (const auto& [head, stats] : invariants->loop_statistics()) {
+                    std::cout << "Loop at " << head << ": " << stats.transfers << " transfers, "
+                              << stats.skipped_transfers << " skipped\n";
+                }
+                const auto [vertices, edges] = invariants->max_numeric_size();
+                std::cout << "Largest numerical domain: " << vertices << " vertices, " << edges << " edges\n";
+                if (result.tier == numeric_domain_t::bounded_zone) {
+                    std::cout << "Relations forgotten over budget after " << invariants->over_budget_count()
+                              << " transfers\n";
+                }
             }
 
-            bool pass;
+            std::optional<Report> report;
             if (verbosity.print_failures) {
-                auto report = invariants.check_assertions(prog);
-                print_warnings(std::cout, report);
-                pass = report.verified();
+                report = invariants->check_assertions(prog);
+                result.verified = report->verified();
             } else {
-                pass = invariants.verified(prog);
-            }
-            if (pass && ebpf_verifier_options.cfg_opts.check_for_termination &&
-                (verbosity.print_failures || verbosity.print_invariants)) {
-                std::cout << "Program terminates within " << invariants.max_loop_count() << " loop iterations\n";
+                result.verified = invariants->verified(prog);
             }
-            std::cout << pass << "," << seconds << "," << resident_set_size_kb() << "\n";
-            return pass ? 0 : 1;
+            result.max_loop_count = invariants->max_loop_count();
+            return report_verdict(result, seconds, ebpf_verifier_options, report ? &*report : nullptr);
         } catch (UnmarshalError& e) {
             std::cerr << "error: " << e.what() << std::endl;
             return 1;
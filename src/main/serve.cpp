@@ -0,0 +1,329 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+
+// A verifier that keeps running and answers requests read from its standard input, one per line, so that a loader
+// does not pay for starting a process and warming up the verifier for each program.
+//
+// A request is a line of space-separated key=value words:
+//   id=ID                 Echoed at the start of each line of the response. Required.
+//   elf=PATH              The program is in an ELF file,
+//   section=SECTION       in this section
+//   function=FUNCTION     and this function, which may be left out when there is only one.
+//   bytes=HEX             Or, the program is these instruction bytes,
+//   type=TYPE             of the program type of ELF sections named TYPE, e.g., xdp,
+//   map=FD:TYPE:KEY_SIZE:VALUE_SIZE:MAX_ENTRIES
+//                         using a map with this descriptor; repeat for each map.
+//   domain=DOMAIN         intervalCrab, boundedZoneCrab or zoneCrab.
+//   termination=0|1, strict=0|1, tiered=0|1, timeout=SECONDS
+//                         Override the options the server was started with.
+//
+// Each request gets one of these responses, whose lines are written together:
+//   ID ok VERIFIED SECONDS WARNINGS   followed by WARNINGS lines "ID warning TEXT"
+//   ID timeout SECONDS
+//   ID error MESSAGE
+// Requests are verified concurrently, so responses may come in another order than the requests.
+
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ebpf_verifier.hpp"
+
+// Avoid affecting other headers by macros.
+#include "CLI11/CLI11.hpp"
+
+using std::string;
+using std::vector;
+
+/// Lines waiting for a worker. Reading more requests blocks while it is full.
+class request_queue_t final {
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    std::deque<string> _lines;
+    const size_t _capacity;
+    bool _closed{false};
+
+  public:
+    explicit request_queue_t(const size_t capacity) : _capacity(capacity) {}
+
+    void push(string line) {
+        std::unique_lock lock(_mutex);
+        _cv.wait(lock, [this] { return _lines.size() < _capacity; });
+        _lines.push_back(std::move(line));
+        _cv.notify_all();
+    }
+
+    /// No more lines will be pushed.
+    void close() {
+        std::lock_guard lock(_mutex);
+        _closed = true;
+        _cv.notify_all();
+    }
+
+    /// The next line, or nothing once the queue is closed and empty.
+    std::optional<string> pop() {
+        std::unique_lock lock(_mutex);
+        _cv.wait(lock, [this] { return _closed || !_lines.empty(); });
+        if (_lines.empty()) {
+            return {};
+        }
+        string line = std::move(_lines.front());
+        _lines.pop_front();
+        _cv.notify_all();
+        return line;
+    }
+};
+
+class request_error_t final : public std::runtime_error {
+  public:
+    explicit request_error_t(const string& what) : std::runtime_error(what) {}
+};
+
+struct request_t {
+    string id;
+    raw_program raw_prog;
+    ebpf_verifier_options_t options;
+};
+
+static bool parse_flag(const string& key, const string& value) {
+    if (value != "0" && value != "1") {
+        throw request_error_t(key + " must be 0 or 1");
+    }
+    return value == "1";
+}
+
+static vector<ebpf_inst> parse_instructions(const string& hex) {
+    if (hex.size() % (2 * sizeof(ebpf_inst)) != 0) {
+        throw request_error_t("bytes must hold a whole number of instructions");
+    }
+    vector<uint8_t> bytes;
+    for (size_t i = 0; i < hex.size(); i += 2) {
+        size_t end{};
+        const unsigned long byte = std::stoul(hex.substr(i, 2), &end, 16);
+        if (end != 2) {
+            throw request_error_t("bytes must be hexadecimal");
+        }
+        bytes.push_back(static_cast<uint8_t>(byte));
+    }
+    vector<ebpf_inst> prog(bytes.size() / sizeof(ebpf_inst));
+    std::memcpy(prog.data(), bytes.data(), bytes.size());
+    return prog;
+}
+
+static EbpfMapDescriptor parse_map(const string& value) {
+    vector<unsigned int> fields;
+    std::istringstream in{value};
+    for (string field; std::getline(in, field, ':');) {
+        fields.push_back(static_cast<unsigned int>(std::stoul(field)));
+    }
+    if (fields.size() != 5) {
+        throw request_error_t("map must be FD:TYPE:KEY_SIZE:VALUE_SIZE:MAX_ENTRIES");
+    }
+    return EbpfMapDescriptor{.original_fd = static_cast<int>(fields[0]),
+                             .type = fields[1],
+                             .key_size = fields[2],
+                             .value_size = fields[3],
+                             .max_entries = fields[4],
+                             .inner_map_fd = DEFAULT_MAP_FD};
+}
+
+/// Read the program of a request, from its ELF file or its bytes.
+static request_t parse_request(const string& line, const ebpf_verifier_options_t& defaults,
+                               const ebpf_platform_t& platform, const int default_timeout) {
+    request_t request{.options = defaults};
+    string elf, section, function, bytes, type;
+    vector<EbpfMapDescriptor> maps;
+    int timeout = default_timeout;
+    std::istringstream words{line};
+    for (string word; words >> word;) {
+        const size_t eq = word.find('=');
+        if (eq == string::npos) {
+            throw request_error_t("expected key=value, not " + word);
+        }
+        const string key = word.substr(0, eq);
+        const string value = word.substr(eq + 1);
+        if (key == "id") {
+            request.id = value;
+        } else if (key == "elf") {
+            elf = value;
+        } else if (key == "section") {
+            section = value;
+        } else if (key == "function") {
+            function = value;
+        } else if (key == "bytes") {
+            bytes = value;
+        } else if (key == "type") {
+            type = value;
+        } else if (key == "map") {
+            maps.push_back(parse_map(value));
+        } else if (key == "domain") {
+            const auto domain = numeric_domain_from_string(value);
+            if (!domain) {
+                throw request_error_t("unknown domain " + value);
+            }
+            request.options.numeric_domain = *domain;
+        } else if (key == "termination") {
+            request.options.cfg_opts.check_for_termination = parse_flag(key, value);
+        } else if (key == "strict") {
+            request.options.strict = parse_flag(key, value);
+        } else if (key == "tiered") {
+            request.options.tiered_verification = parse_flag(key, value);
+        } else if (key == "timeout") {
+            timeout = std::stoi(value);
+        } else {
+            throw request_error_t("unknown key " + key);
+        }
+    }
+    if (timeout > 0) {
+        request.options.deadline = std::chrono::steady_clock::now() + std::chrono::seconds{timeout};
+    }
+
+    if (!elf.empty()) {
+        for (raw_program& raw_prog : read_elf(elf, section, request.options, &platform)) {
+            if (function.empty() || raw_prog.function_name == function) {
+                if (!request.raw_prog.prog.empty()) {
+                    throw request_error_t("please specify a function");
+                }
+                request.raw_prog = std::move(raw_prog);
+            }
+        }
+        if (request.raw_prog.prog.empty()) {
+            throw request_error_t("program not found");
+        }
+    } else if (!bytes.empty()) {
+        if (type.empty()) {
+            throw request_error_t("bytes need a type");
+        }
+        request.raw_prog = raw_program{.filename = "request",
+                                       .section_name = type,
+                                       .function_name = type,
+                                       .prog = parse_instructions(bytes),
+                                       .info = {.platform = &platform,
+                                                .map_descriptors = std::move(maps),
+                                                .type = platform.get_program_type(type, "")}};
+    } else {
+        throw request_error_t("expected elf or bytes");
+    }
+    return request;
+}
+
+/// The id of a request that could not be parsed, if it has one.
+static string id_of(const string& line) {
+    std::istringstream words{line};
+    for (string word; words >> word;) {
+        if (word.starts_with("id=")) {
+            return word.substr(3);
+        }
+    }
+    return "-";
+}
+
+/// Answer the requests of the queue until it is closed. The requests of a worker share one verifier context, so that
+/// each reuses the scratch space that the previous ones allocated, and every analysis resets what it depends on
+/// before starting.
+static void serve_requests(request_queue_t& queue, std::mutex& output_mutex, const ebpf_verifier_options_t& defaults,
+                           const ebpf_platform_t& platform, const int default_timeout,
+                           const std::optional<result_cache_t>& cache) {
+    verifier_context_t context;
+    while (const std::optional<string> line = queue.pop()) {
+        const verifier_context_t::scope_t scope(context);
+        std::ostringstream response;
+        const auto begin = std::chrono::steady_clock::now();
+        const auto seconds = [&begin] {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        };
+        string id = id_of(*line);
+        try {
+            const request_t request = parse_request(*line, defaults, platform, default_timeout);
+            id = request.id;
+            const verification_result_t result = cache ? verify_cached(request.raw_prog, request.options, *cache)
+                                                       : verify_raw_program(request.raw_prog, request.options);
+            response << id << " ok " << result.verified << " " << seconds() << " " << result.warnings.size() << "\n";
+            for (const string& warning : result.warnings) {
+                response << id << " warning " << warning << "\n";
+            }
+        } catch (const crab::AnalysisTimeout&) {
+            response << id << " timeout " << seconds() << "\n";
+        } catch (const std::exception& e) {
+            response << id << " error " << e.what() << "\n";
+        }
+        std::lock_guard lock(output_mutex);
+        std::cout << response.str() << std::flush;
+    }
+}
+
+int main(int argc, char** argv) {
+    crab::CrabEnableWarningMsg(false);
+
+    CLI::App app{"Answer verification requests read from standard input, one per line, until its end."};
+
+    int jobs = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    app.add_option("--jobs", jobs, "Number of requests verified at once. Default: one per core")
+        ->type_name("N")
+        ->check(CLI::PositiveNumber);
+
+    int queue_size = 0;
+    app.add_option("--queue", queue_size,
+                   "Number of requests read ahead of the workers before waiting for one to be done. Default: --jobs")
+        ->type_name("N")
+        ->check(CLI::PositiveNumber);
+
+    int timeout = 0;
+    app.add_option("--timeout", timeout, "Seconds after which a request gives up, or 0 for no limit. Default: 0")
+        ->type_name("SECONDS")
+        ->check(CLI::NonNegativeNumber);
+
+    std::string domain = "zoneCrab";
+    app.add_option("--domain", domain, "Numerical domain of requests that do not choose one")
+        ->type_name("DOMAIN")
+        ->capture_default_str()
+        ->check(CLI::IsMember({"intervalCrab", "boundedZoneCrab", "zoneCrab"}));
+
+    ebpf_verifier_options_t options;
+    app.add_flag("--termination", options.cfg_opts.check_for_termination,
+                 "Verify termination unless requests say otherwise. Default: ignore");
+
+    std::string cache_dir;
+    app.add_option("--cache", cache_dir, "Reuse the results stored in DIR, and store new results there")
+        ->type_name("DIR");
+
+    CLI11_PARSE(app, argc, argv);
+
+    options.numeric_domain = *numeric_domain_from_string(domain);
+    ebpf_platform_t platform = g_ebpf_platform_linux;
+    platform.supported_conformance_groups = bpf_conformance_groups_t::default_groups;
+
+    std::optional<result_cache_t> cache;
+    if (!cache_dir.empty()) {
+        cache.emplace(cache_dir);
+        if (cache->off_reason()) {
+            std::cerr << "warning: not caching results: " << *cache->off_reason() << std::endl;
+            cache.reset();
+        }
+    }
+
+    request_queue_t queue(queue_size > 0 ? queue_size : jobs);
+    std::mutex output_mutex;
+    vector<std::thread> workers;
+    for (int i = 0; i < jobs; i++) {
+        workers.emplace_back(serve_requests, std::ref(queue), std::ref(output_mutex), std::cref(options),
+                             std::cref(platform), timeout, std::cref(cache));
+    }
+    for (string line; std::getline(std::cin, line);) {
+        if (line.find_first_not_of(" \t\r") != string::npos) {
+            queue.push(std::move(line));
+        }
+    }
+    queue.close();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    return 0;
+}
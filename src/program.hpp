@@ -20,11 +20,17 @@ class Program {
     std::map<label_t, std::vector<Assertion>> m_assertions{{label_t::entry, {}}, {label_t::exit, {}}};
     crab::cfg_t m_cfg;
 
+    // When local calls are summarized, the control-flow graph of each subprogram, by the target of the calls to it.
+    // Their labels are in the stack frame of the subprogram, and their instructions and assertions are stored above.
+    std::map<label_t, crab::cfg_t> m_subprograms;
+
     // TODO: add program_info field
 
   public:
     const crab::cfg_t& cfg() const { return m_cfg; }
 
+    const std::map<label_t, crab::cfg_t>& subprograms() const { return m_subprograms; }
+
     //! return a view of the labels, including entry and exit
     [[nodiscard]]
     auto labels() const {
@@ -45,7 +51,7 @@ class Program {
         return m_instructions.at(label);
     }
 
-    std::vector<Assertion> assertions_at(const label_t& label) const {
+    const std::vector<Assertion>& assertions_at(const label_t& label) const {
         if (!m_assertions.contains(label)) {
             CRAB_ERROR("Label ", to_string(label), " not found in the CFG: ");
         }
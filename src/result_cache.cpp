@@ -0,0 +1,390 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <thread>
+
+#include "asm_files.hpp"
+#include "asm_unmarshal.hpp"
+#include "crab_verifier.hpp"
+#include "platform.hpp"
+#include "result_cache.hpp"
+
+// The build generates this header, with a hash of the sources of the verifier as the id of the build.
+#if __has_include("verifier_build_id.hpp")
+#include "verifier_build_id.hpp"
+#endif
+
+// Bump when the format of an entry, or what goes into a key, changes.
+static constexpr int CACHE_FORMAT_VERSION = 3;
+static constexpr auto ENTRY_HEADER = "prevail verification result";
+
+namespace {
+
+/// SHA-256 (FIPS 180-4). Entries are named after the digest, so a weaker hash could make two programs share a result.
+class sha256_t final {
+    static constexpr std::array<uint32_t, 64> k{
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+    std::array<uint32_t, 8> h{0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                              0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    std::array<uint8_t, 64> block{};
+    size_t block_size{};
+    uint64_t total_bytes{};
+
+    void compress() {
+        std::array<uint32_t, 64> w{};
+        for (size_t i = 0; i < 16; i++) {
+            w[i] = uint32_t{block[4 * i]} << 24 | uint32_t{block[4 * i + 1]} << 16 | uint32_t{block[4 * i + 2]} << 8 |
+                   uint32_t{block[4 * i + 3]};
+        }
+        for (size_t i = 16; i < 64; i++) {
+            const uint32_t s0 = std::rotr(w[i - 15], 7) ^ std::rotr(w[i - 15], 18) ^ w[i - 15] >> 3;
+            const uint32_t s1 = std::rotr(w[i - 2], 17) ^ std::rotr(w[i - 2], 19) ^ w[i - 2] >> 10;
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        auto [a, b, c, d, e, f, g, hh] = h;
+        for (size_t i = 0; i < 64; i++) {
+            const uint32_t t1 =
+                hh + (std::rotr(e, 6) ^ std::rotr(e, 11) ^ std::rotr(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+            const uint32_t t2 = (std::rotr(a, 2) ^ std::rotr(a, 13) ^ std::rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            hh = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
+        h[5] += f;
+        h[6] += g;
+        h[7] += hh;
+    }
+
+  public:
+    void update(const void* data, const size_t size) {
+        const auto bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++) {
+            block[block_size++] = bytes[i];
+            if (block_size == block.size()) {
+                compress();
+                block_size = 0;
+            }
+        }
+        total_bytes += size;
+    }
+
+    std::string hex_digest() {
+        const uint64_t total_bits = total_bytes * 8;
+        constexpr uint8_t one = 0x80;
+        update(&one, 1);
+        constexpr uint8_t zero = 0;
+        while (block_size != 56) {
+            update(&zero, 1);
+        }
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            const uint8_t byte = static_cast<uint8_t>(total_bits >> shift);
+            update(&byte, 1);
+        }
+        std::ostringstream os;
+        os << std::hex;
+        for (const uint32_t word : h) {
+            os.width(8);
+            os.fill('0');
+            os << word;
+        }
+        return os.str();
+    }
+};
+
+/// Feeds the fields of a key to the hash in a fixed layout, independent of the host and of struct padding.
+class key_writer_t final {
+    sha256_t sha;
+
+  public:
+    void add(const uint64_t value) {
+        std::array<uint8_t, 8> bytes{};
+        for (size_t i = 0; i < bytes.size(); i++) {
+            bytes[i] = static_cast<uint8_t>(value >> (8 * i));
+        }
+        sha.update(bytes.data(), bytes.size());
+    }
+
+    void add(const std::optional<size_t>& value) {
+        add(value.has_value());
+        add(value.value_or(0));
+    }
+
+    void add(const std::string& s) {
+        add(s.size());
+        sha.update(s.data(), s.size());
+    }
+
+    std::string digest() { return sha.hex_digest(); }
+};
+
+std::string escape(const std::string& s) {
+    std::string res;
+    for (const char c : s) {
+        switch (c) {
+        case '\\': res += "\\\\"; break;
+        case '\n': res += "\\n"; break;
+        case '\r': res += "\\r"; break;
+        default: res += c;
+        }
+    }
+    return res;
+}
+
+std::optional<std::string> unescape(const std::string& s) {
+    std::string res;
+    for (size_t i = 0; i < s.size(); i++) {
+        if (s[i] != '\\') {
+            res += s[i];
+            continue;
+        }
+        if (++i == s.size()) {
+            return {};
+        }
+        switch (s[i]) {
+        case '\\': res += '\\'; break;
+        case 'n': res += '\n'; break;
+        case 'r': res += '\r'; break;
+        default: return {};
+        }
+    }
+    return res;
+}
+
+} // namespace
+
+std::string sha256_hex(const std::string_view data) {
+    sha256_t sha;
+    sha.update(data.data(), data.size());
+    return sha.hex_digest();
+}
+
+result_cache_t::result_cache_t(std::filesystem::path dir) : _dir(std::move(dir)) {
+#ifdef VERIFIER_BUILD_ID
+    std::error_code ec;
+    std::filesystem::create_directories(_dir, ec);
+    if (ec) {
+        _off_reason = "cannot create " + _dir.string() + ": " + ec.message();
+    }
+#else
+    // The results of another build, with another analysis, could not be told apart from those of this one.
+    _off_reason = "this build of the verifier has no id";
+#endif
+}
+
+std::filesystem::path result_cache_t::path_of(const std::string& key) const {
+    // Spread the entries over subdirectories so that no single directory grows too large.
+    return _dir / key.substr(0, 2) / key;
+}
+
+std::string result_cache_t::key(const raw_program& raw_prog, const ebpf_verifier_options_t& options) {
+    key_writer_t w;
+    w.add(std::string{ENTRY_HEADER});
+    w.add(CACHE_FORMAT_VERSION);
+#ifdef VERIFIER_BUILD_ID
+    w.add(std::string{VERIFIER_BUILD_ID});
+#endif
+
+    w.add(raw_prog.prog.size());
+    for (const ebpf_inst& inst : raw_prog.prog) {
+        w.add(inst.opcode);
+        w.add(inst.dst);
+        w.add(inst.src);
+        w.add(static_cast<uint16_t>(inst.offset));
+        w.add(static_cast<uint32_t>(inst.imm));
+    }
+
+    const program_info& info = raw_prog.info;
+    w.add(info.platform != nullptr);
+    if (info.platform) {
+        w.add(static_cast<uint64_t>(info.platform->supported_conformance_groups));
+        w.add(info.platform->map_record_size);
+    }
+    w.add(info.type.platform_specific_data);
+    w.add(info.type.is_privileged);
+    w.add(info.type.context_descriptor != nullptr);
+    if (const ebpf_context_descriptor_t* context = info.type.context_descriptor) {
+        w.add(static_cast<uint32_t>(context->size));
+        w.add(static_cast<uint32_t>(context->data));
+        w.add(static_cast<uint32_t>(context->end));
+        w.add(static_cast<uint32_t>(context->meta));
+    }
+    w.add(info.map_descriptors.size());
+    for (const EbpfMapDescriptor& map : info.map_descriptors) {
+        w.add(static_cast<uint32_t>(map.original_fd));
+        w.add(map.type);
+        w.add(map.key_size);
+        w.add(map.value_size);
+        w.add(map.max_entries);
+        w.add(map.inner_map_fd);
+    }
+
+    // The number of threads, the compactness of the invariants and the verbosity do not change the result.
+    w.add(options.cfg_opts.check_for_termination);
+    w.add(options.cfg_opts.must_have_exit);
+    w.add(options.cfg_opts.summarize_local_calls);
+    w.add(options.assume_assertions);
+    w.add(options.mock_map_fds);
+    w.add(options.strict);
+    w.add(options.allow_division_by_zero);
+    w.add(options.setup_constraints);
+    w.add(options.big_endian);
+    w.add(options.prune_dead_variables);
+    w.add(static_cast<uint64_t>(options.numeric_domain));
+    w.add(options.max_relations_per_variable);
+    w.add(options.max_relations);
+    w.add(options.tiered_verification);
+    return w.digest();
+}
+
+std::optional<verification_result_t> result_cache_t::lookup(const std::string& key) const {
+    if (_off_reason) {
+        return {};
+    }
+    std::ifstream in{path_of(key)};
+    if (!in) {
+        return {};
+    }
+    std::string header;
+    std::string stored_key;
+    if (!std::getline(in, header) || header != ENTRY_HEADER + (" " + std::to_string(CACHE_FORMAT_VERSION)) ||
+        !std::getline(in, stored_key) || stored_key != key) {
+        return {};
+    }
+
+    verification_result_t result;
+    std::string field;
+    std::string tier;
+    size_t n_warnings{};
+    if (!(in >> field >> result.verified) || field != "verified" || !(in >> field >> result.max_loop_count) ||
+        field != "max_loop_count" || !(in >> field >> tier) || field != "tier" ||
+        !(in >> field >> n_warnings) || field != "warnings") {
+        return {};
+    }
+    if (const auto domain = numeric_domain_from_string(tier)) {
+        result.tier = *domain;
+    } else {
+        return {};
+    }
+    in.ignore(1);
+    for (size_t i = 0; i < n_warnings; i++) {
+        std::string line;
+        if (!std::getline(in, line)) {
+            return {};
+        }
+        auto warning = unescape(line);
+        if (!warning) {
+            return {};
+        }
+        result.warnings.push_back(std::move(*warning));
+    }
+    // A writer that was interrupted leaves no file behind, but check that the entry is complete anyway.
+    if (!std::getline(in, field) || field != "end") {
+        return {};
+    }
+    return result;
+}
+
+bool result_cache_t::store(const std::string& key, const verification_result_t& result) const {
+    if (_off_reason) {
+        return false;
+    }
+    // A name no other writer uses, so that concurrent writers of the same entry do not interleave.
+    static std::atomic<uint64_t> counter{0};
+    std::ostringstream tmp_name;
+    tmp_name << ".tmp-" << std::hash<std::thread::id>{}(std::this_thread::get_id()) << "-" << std::random_device{}()
+             << "-" << counter++;
+
+    const std::filesystem::path path = path_of(key);
+    const std::filesystem::path tmp_path = path.parent_path() / tmp_name.str();
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+    if (ec) {
+        return false;
+    }
+    {
+        std::ofstream out{tmp_path, std::ios::trunc};
+        out << ENTRY_HEADER << " " << CACHE_FORMAT_VERSION << "\n";
+        out << key << "\n";
+        out << "verified " << result.verified << "\n";
+        out << "max_loop_count " << result.max_loop_count << "\n";
+        out << "tier " << to_string(result.tier) << "\n";
+        out << "warnings " << result.warnings.size() << "\n";
+        for (const std::string& warning : result.warnings) {
+            out << escape(warning) << "\n";
+        }
+        out << "end\n";
+        out.close();
+        if (!out) {
+            std::filesystem::remove(tmp_path, ec);
+            return false;
+        }
+    }
+    // Renaming within a directory is atomic, so readers see either the old entry or the new one.
+    std::filesystem::rename(tmp_path, path, ec);
+    if (ec) {
+        std::filesystem::remove(tmp_path, ec);
+        return false;
+    }
+    return true;
+}
+
+verification_result_t verify_raw_program(const raw_program& raw_prog, const ebpf_verifier_options_t& options) {
+    thread_local_options = options;
+    auto prog_or_error = unmarshal(raw_prog);
+    if (const auto error = std::get_if<std::string>(&prog_or_error)) {
+        throw UnmarshalError(*error);
+    }
+    const Program prog = Program::from_sequence(std::get<InstructionSeq>(prog_or_error), raw_prog.info, options);
+    verification_result_t result;
+    // With the interval domain, there is only one tier.
+    const bool tiered = options.tiered_verification && options.numeric_domain != numeric_domain_t::interval;
+    std::optional<Invariants> invariants = tiered ? analyze_intervals(prog) : std::nullopt;
+    if (invariants) {
+        result.verified = true;
+        result.tier = numeric_domain_t::interval;
+    } else {
+        invariants.emplace(analyze(prog));
+        const Report report = invariants->check_assertions(prog);
+        result.verified = report.verified();
+        const auto warnings = report.warning_set();
+        result.warnings.assign(warnings.begin(), warnings.end());
+        result.tier = options.numeric_domain;
+    }
+    result.max_loop_count = invariants->max_loop_count();
+    return result;
+}
+
+verification_result_t verify_cached(const raw_program& raw_prog, const ebpf_verifier_options_t& options,
+                                    const result_cache_t& cache) {
+    const std::string key = result_cache_t::key(raw_prog, options);
+    if (auto cached = cache.lookup(key)) {
+        return std::move(*cached);
+    }
+    verification_result_t result = verify_raw_program(raw_prog, options);
+    cache.store(key, result);
+    return result;
+}
@@ -0,0 +1,81 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "config.hpp"
+#include "spec_type_descriptors.hpp"
+
+/// The outcome of verifying a program.
+struct verification_result_t {
+    bool verified{};
+    /// The failed assertions, as "label: message".
+    std::vector<std::string> warnings;
+    /// Upper bound of the number of loop iterations. Only meaningful when termination is checked.
+    int max_loop_count{};
+    /// The numerical domain that decided the verdict.
+    numeric_domain_t tier{numeric_domain_t::zone};
+
+    bool operator==(const verification_result_t&) const = default;
+};
+
+/**
+ * @brief A directory of verification results, each in a file named after a hash of everything the result depends on.
+ *
+ * An entry is written to a temporary file that is then renamed into place, so a reader never sees a partial entry
+ * and several processes may share the directory. A file that cannot be read as an entry for the key is a miss.
+ */
+class result_cache_t final {
+    std::filesystem::path _dir;
+
+    /// Why the cache is off, or nothing if it is on.
+    std::optional<std::string> _off_reason;
+
+    [[nodiscard]]
+    std::filesystem::path path_of(const std::string& key) const;
+
+  public:
+    /// Use a directory as cache, creating it if needed.
+    /// The cache is off if the directory cannot be created, or if this build of the verifier has no id to tell its
+    /// results from those of other builds. A cache that is off finds no entry and stores none.
+    explicit result_cache_t(std::filesystem::path dir);
+
+    /// Why the cache is off, to warn about, or nothing if it is on.
+    [[nodiscard]]
+    const std::optional<std::string>& off_reason() const {
+        return _off_reason;
+    }
+
+    /**
+     * @brief The key of a program in the cache.
+     *
+     * It covers the instructions, the program info (program type, context descriptor and map descriptors),
+     * the options that can change the result, the conformance groups of the platform, and the build of the verifier.
+     * The helper prototypes of the platform are not covered, so a cache must not be shared across platforms.
+     */
+    static std::string key(const raw_program& raw_prog, const ebpf_verifier_options_t& options);
+
+    [[nodiscard]]
+    std::optional<verification_result_t> lookup(const std::string& key) const;
+
+    /// Add an entry, or replace the one with the same key.
+    /// @return Whether the entry was written. The cache is only an optimization, so this does not throw.
+    bool store(const std::string& key, const verification_result_t& result) const;
+};
+
+/// The SHA-256 digest of some bytes, as 64 lowercase hexadecimal digits. Cache keys are digests made this way.
+std::string sha256_hex(std::string_view data);
+
+/// Verify a program, and collect what the cache stores about it.
+/// Throws UnmarshalError if the program cannot be unmarshaled, and InvalidControlFlow if it has no valid CFG.
+verification_result_t verify_raw_program(const raw_program& raw_prog, const ebpf_verifier_options_t& options);
+
+/// Verify a program, unless the cache already has its result. A new result is added to the cache.
+/// Throws UnmarshalError if the program cannot be unmarshaled, and InvalidControlFlow if it has no valid CFG.
+verification_result_t verify_cached(const raw_program& raw_prog, const ebpf_verifier_options_t& options,
+                                    const result_cache_t& cache);
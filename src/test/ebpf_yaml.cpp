@@ -5,6 +5,7 @@
 #include <bit>
 #include <iostream>
 #include <set>
+#include <sstream>
 #include <variant>
 
 #include <boost/algorithm/string.hpp>
@@ -200,6 +201,8 @@ static ebpf_verifier_options_t raw_options_to_options(const std::set<string>& ra
             options.big_endian = false;
         } else if (name == "assume_assertions") {
             options.assume_assertions = true;
+        } else if (name == "prune_dead_variables") {
+            options.prune_dead_variables = true;
         } else {
             throw std::runtime_error("Unknown option: " + name);
         }
@@ -271,6 +274,22 @@ std::optional<Failure> run_yaml_test_case(TestCase test_case, bool debug) {
     }
 }
 
+std::string yaml_test_case_invariants(TestCase test_case) {
+    ebpf_context_descriptor_t context_descriptor{64, 0, 4, -1};
+    EbpfProgramType program_type = make_program_type(test_case.name, &context_descriptor);
+
+    program_info info{&g_platform_test, {}, program_type};
+    thread_local_options = test_case.options;
+    std::ostringstream os;
+    try {
+        const Program prog = Program::from_sequence(test_case.instruction_seq, info, test_case.options);
+        print_invariants(os, prog, false, analyze(prog, test_case.assumed_pre_invariant));
+    } catch (InvalidControlFlow& ex) {
+        os << ex.what() << "\n";
+    }
+    return os.str();
+}
+
 template <typename T>
     requires std::is_trivially_copyable_v<T>
 static vector<T> vector_of(const std::vector<std::byte>& bytes) {
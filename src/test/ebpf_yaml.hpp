@@ -34,6 +34,10 @@ void print_failure(const Failure& failure, std::ostream& os = std::cout);
 
 std::optional<Failure> run_yaml_test_case(TestCase test_case, bool debug = false);
 
+/// The invariants of every label of a test case, as print_invariants() writes them, or the error if its control flow
+/// is invalid.
+std::string yaml_test_case_invariants(TestCase test_case);
+
 struct ConformanceTestResult {
     bool success{};
     crab::interval_t r0_value = crab::interval_t::top();
@@ -0,0 +1,201 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#include <catch2/catch_all.hpp>
+
+#include <random>
+#include <set>
+#include <string>
+
+#include "crab_utils/graph_ops.hpp"
+#include "crab_utils/num_big.hpp"
+
+using crab::number_t;
+
+TEST_CASE("number_t arithmetic across the 64-bit boundary", "[number]") {
+    const number_t max64 = std::numeric_limits<int64_t>::max();
+    const number_t min64 = std::numeric_limits<int64_t>::min();
+    const number_t two64 = number_t{cpp_int{1} << 64};
+
+    REQUIRE(max64 + 1 == number_t{cpp_int{max64} + 1});
+    REQUIRE(min64 - 1 == number_t{cpp_int{min64} - 1});
+    REQUIRE(max64 * 2 == number_t{cpp_int{max64} * 2});
+    REQUIRE(-min64 == number_t{-cpp_int{min64}});
+    REQUIRE(min64 / -1 == -min64);
+    REQUIRE(min64 % -1 == 0);
+    REQUIRE(min64.abs() == -min64);
+    REQUIRE(number_t{-7} / 2 == -3);
+    REQUIRE(number_t{-7} % 2 == -1);
+
+    // Results that fit in 64 bits again compare and hash like any 64-bit number.
+    REQUIRE(max64 + 1 - 1 == max64);
+    REQUIRE(hash_value(max64 + 1 - 1) == hash_value(max64));
+    REQUIRE(two64 - two64 == 0);
+
+    REQUIRE(max64 < max64 + 1);
+    REQUIRE(min64 - 1 < min64);
+    REQUIRE(-two64 < 0);
+    REQUIRE(two64 > max64);
+    REQUIRE((max64 + 1).fits<uint64_t>());
+    REQUIRE(!(max64 + 1).fits<int64_t>());
+    REQUIRE(number_t{std::numeric_limits<uint64_t>::max()} == two64 - 1);
+
+    REQUIRE((number_t{1} << 63) == max64 + 1);
+    REQUIRE((number_t{-1} << 70) == -number_t{cpp_int{1} << 70});
+    REQUIRE((number_t{-5} >> 1) == -3);
+    REQUIRE((number_t{-1} >> 100) == -1);
+    REQUIRE((two64 >> 1) == max64 + 1);
+
+    REQUIRE(number_t{-1}.zero_extend(64) == two64 - 1);
+    REQUIRE(number_t{-1}.zero_extend(32) == 0xffffffff);
+    REQUIRE(number_t{0xff}.sign_extend(8) == -1);
+    REQUIRE((two64 - 1).sign_extend(64) == -1);
+    REQUIRE(number_t{-1}.truncate_to<uint32_t>() == 0xffffffff);
+    REQUIRE(number_t::max_uint(64) == two64 - 1);
+    REQUIRE(number_t::max_int(64) == max64);
+    REQUIRE(number_t::min_int(64) == min64);
+    REQUIRE(number_t{5}.fill_ones() == 7);
+    REQUIRE(max64.fill_ones() == max64);
+    REQUIRE((max64 + 1).fill_ones() == two64 - 1);
+
+    REQUIRE(max64.to_string() == "9223372036854775807");
+    REQUIRE((max64 + 1).to_string() == "9223372036854775808");
+}
+
+// Run with: tests "[number-benchmark]"
+TEST_CASE("DBM closure benchmark", "[.][number-benchmark]") {
+    using crab::AdaptGraph;
+    using crab::GraphOps;
+    using vert_id = AdaptGraph::vert_id;
+    constexpr vert_id n_verts = 64;
+
+    // Add random difference constraints to a graph, keeping it closed as SplitDBM does.
+    const auto run = [](const int64_t max_weight) {
+        std::mt19937 rng{42};
+        std::uniform_int_distribution<vert_id> vert(1, n_verts - 1);
+        std::uniform_int_distribution<int64_t> weight(0, max_weight);
+        AdaptGraph g;
+        g.growTo(n_verts);
+        GraphOps::WeightVector potential(n_verts, number_t{0});
+        for (int i = 0; i < 200; i++) {
+            const vert_id s = vert(rng);
+            const vert_id d = vert(rng);
+            if (s == d) {
+                continue;
+            }
+            g.update_edge(s, weight(rng), d);
+            if (GraphOps::repair_potential(g, potential, s, d)) {
+                GraphOps::close_over_edge(g, s, d);
+            }
+        }
+        const auto p = [&](const vert_id v) { return potential[v]; };
+        GraphOps::apply_delta(g, GraphOps::close_after_assign(g, p, 0));
+        return g.num_edges();
+    };
+
+    BENCHMARK("close over edges, 64-bit weights") { return run(1000); };
+    BENCHMARK("close over edges, big weights") { return run(std::numeric_limits<int64_t>::max()); };
+}
+
+// A random graph of nonnegative weights, so that it is consistent, with about edges_per_vertex edges per vertex.
+static crab::AdaptGraph random_graph(const crab::AdaptGraph::vert_id n_verts, const int edges_per_vertex,
+                                     const int64_t max_weight, const unsigned seed = 42) {
+    std::mt19937 rng{seed};
+    std::uniform_int_distribution<crab::AdaptGraph::vert_id> vert(0, n_verts - 1);
+    std::uniform_int_distribution<int64_t> weight(0, max_weight);
+    crab::AdaptGraph g;
+    g.growTo(n_verts);
+    for (int i = 0; i < edges_per_vertex * static_cast<int>(n_verts); i++) {
+        const auto s = vert(rng);
+        const auto d = vert(rng);
+        if (s != d) {
+            g.update_edge(s, weight(rng), d);
+        }
+    }
+    return g;
+}
+
+// Close g from scratch with the sparse closure that SplitDBM uses after widening.
+static crab::GraphOps::edge_vector close_sparse(const crab::AdaptGraph& g) {
+    const std::vector<bool> stable(g.size(), false);
+    const crab::GraphOps::WeightVector potential(g.size(), number_t{0});
+    const auto p = [&](const crab::AdaptGraph::vert_id v) { return potential[v]; };
+    return crab::GraphOps::close_after_widen(g, p, stable);
+}
+
+TEST_CASE("dense closure finds the same edges as the sparse closure", "[graph]") {
+    using crab::AdaptGraph;
+    using crab::GraphOps;
+    for (const AdaptGraph::vert_id n_verts : {5u, 16u, 32u}) {
+        for (const int edges_per_vertex : {2, 4}) {
+            AdaptGraph sparse = random_graph(n_verts, edges_per_vertex, 100);
+            AdaptGraph dense = sparse;
+            GraphOps::apply_delta(sparse, close_sparse(sparse));
+            const auto delta = GraphOps::close_dense(dense);
+            REQUIRE(delta);
+            GraphOps::apply_delta(dense, *delta);
+            REQUIRE(dense.num_edges() == sparse.num_edges());
+            for (const AdaptGraph::vert_id s : sparse.verts()) {
+                for (const auto e : sparse.e_succs(s)) {
+                    REQUIRE(dense.lookup(s, e.vert) == e.val);
+                }
+            }
+        }
+    }
+
+    // Too many vertices and weights too big for a 64-bit matrix are left to the sparse closure.
+    REQUIRE(!GraphOps::close_dense(random_graph(GraphOps::max_dense_size + 1, 3, 100)));
+    REQUIRE(!GraphOps::close_dense(random_graph(4, 3, std::numeric_limits<int64_t>::max())));
+
+    // A graph with fewer edges than vertices is closed as well.
+    AdaptGraph g;
+    g.growTo(4);
+    g.add_edge(0, 1, 1);
+    g.add_edge(1, 2, 2);
+    const auto delta = GraphOps::close_dense(g);
+    REQUIRE(delta);
+    GraphOps::apply_delta(g, *delta);
+    REQUIRE(g.lookup(0, 2) == number_t{3});
+}
+
+// Run with: tests "[graph-benchmark]"
+// Compares the dense closure with the sparse closures it replaces in SplitDBM: close_after_meet after a meet of two
+// closed graphs, and close_after_widen after a widening leaves some vertices unstable.
+TEST_CASE("dense and sparse DBM closure benchmark", "[.][graph-benchmark]") {
+    using crab::AdaptGraph;
+    using crab::GraphOps;
+    const auto closed = [](AdaptGraph g) {
+        GraphOps::apply_delta(g, close_sparse(g));
+        return g;
+    };
+    for (const AdaptGraph::vert_id n_verts : {4u, 8u, 16u, 32u}) {
+        for (const int edges_per_vertex : {1, 4}) {
+            const std::string name = std::to_string(n_verts) + " vertices, " + std::to_string(edges_per_vertex) +
+                                     " edges per vertex, ";
+            const GraphOps::WeightVector potential(n_verts, number_t{0});
+            const auto p = [&](const AdaptGraph::vert_id v) { return potential[v]; };
+
+            const AdaptGraph l = closed(random_graph(n_verts, edges_per_vertex, 1000, 1));
+            const AdaptGraph r = closed(random_graph(n_verts, edges_per_vertex, 1000, 2));
+            AdaptGraph meet = l;
+            for (const AdaptGraph::vert_id s : r.verts()) {
+                for (const auto e : r.e_succs(s)) {
+                    meet.update_edge(s, e.val, e.vert);
+                }
+            }
+            BENCHMARK(name + "meet, sparse") { return GraphOps::close_after_meet(meet, p, l, r).size(); };
+            BENCHMARK(name + "meet, dense") { return GraphOps::close_dense(meet)->size(); };
+
+            for (const AdaptGraph::vert_id n_unstable : std::set{1u, n_verts / 4, n_verts}) {
+                AdaptGraph widened = closed(random_graph(n_verts, edges_per_vertex, 1000, 3));
+                std::vector<bool> stable(n_verts, true);
+                for (AdaptGraph::vert_id v = 0; v < n_unstable; v++) {
+                    stable[v] = false;
+                    widened.update_edge(v, 1, (v + n_verts / 2) % n_verts);
+                }
+                const std::string widen_name = name + std::to_string(n_unstable) + " unstable, ";
+                BENCHMARK(widen_name + "sparse") { return GraphOps::close_after_widen(widened, p, stable).size(); };
+                BENCHMARK(widen_name + "dense") { return GraphOps::close_dense(widened)->size(); };
+            }
+        }
+    }
+}
@@ -0,0 +1,171 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#include <catch2/catch_all.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+#include "ebpf_verifier.hpp"
+
+namespace {
+/// A fresh cache directory, removed with its content at the end of the test.
+struct temp_cache_dir_t {
+    std::filesystem::path path = std::filesystem::temp_directory_path() /
+                                 ("prevail-cache-test-" + std::to_string(std::random_device{}()));
+    ~temp_cache_dir_t() {
+        std::error_code ec;
+        std::filesystem::remove_all(path, ec);
+    }
+};
+
+raw_program make_raw_program(const std::vector<ebpf_inst>& insts) {
+    const program_info info{.platform = &g_ebpf_platform_linux,
+                            .type = g_ebpf_platform_linux.get_program_type("unspec", "unspec")};
+    return raw_program{"", "", 0, "", insts, info};
+}
+
+const std::vector<ebpf_inst> exit_zero{
+    {.opcode = INST_CLS_ALU64 | INST_SRC_IMM | INST_ALU_OP_MOV, .dst = 0, .imm = 0},
+    {.opcode = INST_OP_EXIT},
+};
+
+const std::vector<ebpf_inst> exit_uninitialized{
+    {.opcode = INST_OP_EXIT},
+};
+} // namespace
+
+TEST_CASE("result cache round trip", "[cache]") {
+    const temp_cache_dir_t dir;
+    const result_cache_t cache{dir.path};
+    // The build gives the verifier an id, without which nothing could be cached.
+    REQUIRE(!cache.off_reason());
+    const std::string key = result_cache_t::key(make_raw_program(exit_zero), {});
+
+    REQUIRE(!cache.lookup(key));
+    const verification_result_t result{.verified = false,
+                                       .warnings = {"0: first\nwith a newline", "1: back\\slash"},
+                                       .max_loop_count = 7,
+                                       .tier = numeric_domain_t::interval};
+    REQUIRE(cache.store(key, result));
+    REQUIRE(cache.lookup(key) == result);
+
+    // Entries are replaced, and another cache over the same directory sees them.
+    const verification_result_t replaced{.verified = true};
+    REQUIRE(cache.store(key, replaced));
+    REQUIRE(result_cache_t{dir.path}.lookup(key) == replaced);
+}
+
+TEST_CASE("result cache ignores corrupt entries", "[cache]") {
+    const temp_cache_dir_t dir;
+    const result_cache_t cache{dir.path};
+    const std::string key = result_cache_t::key(make_raw_program(exit_zero), {});
+    REQUIRE(cache.store(key, {.verified = true, .warnings = {"0: warning"}}));
+
+    const std::filesystem::path entry = dir.path / key.substr(0, 2) / key;
+    REQUIRE(std::filesystem::exists(entry));
+    // Cut the entry before its end marker.
+    std::filesystem::resize_file(entry, std::filesystem::file_size(entry) - 4);
+    REQUIRE(!cache.lookup(key));
+}
+
+TEST_CASE("result cache is off when its directory cannot be created", "[cache]") {
+    const temp_cache_dir_t dir;
+    std::filesystem::create_directories(dir.path);
+    const std::filesystem::path file = dir.path / "file";
+    std::ofstream{file} << "not a directory";
+
+    const result_cache_t cache{file / "cache"};
+    REQUIRE(cache.off_reason());
+    const raw_program raw_prog = make_raw_program(exit_zero);
+    const std::string key = result_cache_t::key(raw_prog, {});
+    REQUIRE(!cache.store(key, {.verified = true}));
+    REQUIRE(!cache.lookup(key));
+    // Programs are still verified, only without the cache.
+    REQUIRE(verify_cached(raw_prog, {}, cache).verified);
+}
+
+TEST_CASE("result cache keys depend on the program and the options", "[cache]") {
+    const raw_program raw_prog = make_raw_program(exit_zero);
+    const std::string key = result_cache_t::key(raw_prog, {});
+    REQUIRE(key.size() == 64);
+    REQUIRE(key == result_cache_t::key(raw_prog, {}));
+    REQUIRE(key != result_cache_t::key(make_raw_program(exit_uninitialized), {}));
+
+    ebpf_verifier_options_t options{};
+    options.strict = true;
+    REQUIRE(key != result_cache_t::key(raw_prog, options));
+
+    options = {};
+    options.cfg_opts.check_for_termination = true;
+    REQUIRE(key != result_cache_t::key(raw_prog, options));
+
+    // Options that do not change the result share the entry.
+    options = {};
+    options.analysis_threads = 4;
+    options.compact_invariants = true;
+    options.verbosity_opts.print_failures = true;
+    REQUIRE(key == result_cache_t::key(raw_prog, options));
+
+    raw_program with_map = raw_prog;
+    with_map.info.map_descriptors.push_back({.original_fd = 1, .type = 2, .key_size = 4, .value_size = 8,
+                                             .max_entries = 16, .inner_map_fd = DEFAULT_MAP_FD});
+    const std::string map_key = result_cache_t::key(with_map, {});
+    REQUIRE(key != map_key);
+    with_map.info.map_descriptors.back().max_entries = 32;
+    REQUIRE(map_key != result_cache_t::key(with_map, {}));
+}
+
+TEST_CASE("verify_cached stores and reuses results", "[cache]") {
+    const temp_cache_dir_t dir;
+    const result_cache_t cache{dir.path};
+
+    const raw_program good = make_raw_program(exit_zero);
+    const verification_result_t good_result = verify_cached(good, {}, cache);
+    REQUIRE(good_result.verified);
+    REQUIRE(good_result.warnings.empty());
+    REQUIRE(cache.lookup(result_cache_t::key(good, {})) == good_result);
+
+    const raw_program bad = make_raw_program(exit_uninitialized);
+    const verification_result_t bad_result = verify_cached(bad, {}, cache);
+    REQUIRE(!bad_result.verified);
+    REQUIRE(!bad_result.warnings.empty());
+
+    // A hit returns the stored entry without verifying again.
+    const verification_result_t planted{.verified = true, .warnings = {"planted"}};
+    REQUIRE(cache.store(result_cache_t::key(bad, {}), planted));
+    REQUIRE(verify_cached(bad, {}, cache) == planted);
+
+    // With tiers, the result records the one that decided it.
+    ebpf_verifier_options_t tiered{};
+    tiered.tiered_verification = true;
+    REQUIRE(result_cache_t::key(good, tiered) != result_cache_t::key(good, {}));
+    const verification_result_t tiered_good = verify_cached(good, tiered, cache);
+    REQUIRE(tiered_good.verified);
+    REQUIRE(tiered_good.tier == numeric_domain_t::interval);
+    REQUIRE(good_result.tier == numeric_domain_t::zone);
+    const verification_result_t tiered_bad = verify_cached(bad, tiered, cache);
+    REQUIRE(!tiered_bad.verified);
+    REQUIRE(tiered_bad.tier == numeric_domain_t::zone);
+    REQUIRE(tiered_bad.warnings == bad_result.warnings);
+}
+
+TEST_CASE("cache keys hash with SHA-256", "[cache]") {
+    // Known answers from FIPS 180-4 and its examples.
+    REQUIRE(sha256_hex("") == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    REQUIRE(sha256_hex("abc") == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    // 448 bits: the length no longer fits in the first block, so padding adds a second one.
+    REQUIRE(sha256_hex("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq") ==
+            "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+    // 896 bits: the message itself crosses a block boundary.
+    REQUIRE(sha256_hex("abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmno"
+                       "ijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu") ==
+            "cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1");
+    REQUIRE(sha256_hex(std::string(1000000, 'a')) ==
+            "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+
+    // Lengths around the padding boundary.
+    REQUIRE(sha256_hex(std::string(55, 'a')) == "9f4390f8d30c2dd92ec9f095b65e2b9ae9b0a925a5258e241c9f1e910f734318");
+    REQUIRE(sha256_hex(std::string(56, 'a')) == "b35439a4ac6f0948b6d6f9e3c6af0f5f590ce20f1bde7090ef7970686ec6738a");
+    REQUIRE(sha256_hex(std::string(64, 'a')) == "ffe054fe7ae0cb6dc65c3af9b61d5209f439851db43d0ba5997337df154668eb");
+}
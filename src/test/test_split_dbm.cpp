@@ -0,0 +1,265 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#include <catch2/catch_all.hpp>
+
+#include "crab/dsl_syntax.hpp"
+#include "crab/interval_domain.hpp"
+#include "crab/split_dbm.hpp"
+#include "crab_utils/adapt_sgraph.hpp"
+
+using crab::AdaptGraph;
+using crab::data_kind_t;
+using crab::variable_t;
+using crab::domains::IntervalDomain;
+using crab::domains::SplitDBM;
+using namespace crab::dsl_syntax;
+
+TEST_CASE("SplitDBM answers bound and difference queries from its graph", "[split_dbm]") {
+    const variable_t x = variable_t::reg(data_kind_t::svalues, 1);
+    const variable_t y = variable_t::reg(data_kind_t::svalues, 2);
+    const variable_t z = variable_t::reg(data_kind_t::svalues, 3);
+
+    SplitDBM dbm;
+    REQUIRE(dbm.add_constraint(x >= 0));
+    REQUIRE(dbm.add_constraint(x <= 10));
+    REQUIRE(dbm.add_constraint(y - x <= 4));
+    REQUIRE(dbm.add_constraint(x - y <= -2));
+
+    // Bounds.
+    REQUIRE(dbm.entail(x <= 10));
+    REQUIRE(!dbm.entail(x <= 9));
+    REQUIRE(dbm.intersect(x == 10));
+    REQUIRE(!dbm.intersect(x > 10));
+    REQUIRE(dbm.entail(y <= 14));
+    REQUIRE(dbm.entail(y >= 2));
+
+    // Differences, in both orientations, which the intervals alone do not decide.
+    REQUIRE(dbm.entail(y - x <= 4));
+    REQUIRE(dbm.entail(x - y <= -2));
+    REQUIRE(dbm.entail(x - y < 0));
+    REQUIRE(dbm.entail(neq(x, y)));
+    REQUIRE(!dbm.entail(y - x <= 3));
+    REQUIRE(!dbm.entail(y - x == 2));
+    REQUIRE(dbm.intersect(y - x == 2));
+    REQUIRE(!dbm.intersect(y - x == 5));
+    REQUIRE(!dbm.intersect(y - x < 0));
+
+    // Unrelated variables are only bounded by their intervals.
+    REQUIRE(!dbm.entail(x - z <= 100));
+    REQUIRE(dbm.intersect(x - z == 0));
+
+    // Other linear constraints still work.
+    REQUIRE(dbm.entail(x + y <= 24));
+    REQUIRE(!dbm.entail(x + y <= 23));
+
+    // None of the queries changed the domain.
+    REQUIRE(!dbm.entail(x <= 9));
+    REQUIRE(!dbm.entail(y - x <= 3));
+}
+
+TEST_CASE("SplitDBM keeps the most informative relations when they are limited", "[split_dbm]") {
+    const variable_t x = variable_t::reg(data_kind_t::svalues, 1);
+    const variable_t y = variable_t::reg(data_kind_t::svalues, 2);
+    const variable_t z = variable_t::reg(data_kind_t::svalues, 3);
+
+    SplitDBM dbm;
+    REQUIRE(dbm.add_constraint(x >= 0));
+    REQUIRE(dbm.add_constraint(x <= 100));
+    REQUIRE(dbm.add_constraint(y >= 0));
+    REQUIRE(dbm.add_constraint(y <= 100));
+    REQUIRE(dbm.add_constraint(z >= 0));
+    REQUIRE(dbm.add_constraint(z <= 100));
+    // y - x is much tighter than the bounds say, z - x only a little.
+    REQUIRE(dbm.add_constraint(y - x <= 1));
+    REQUIRE(dbm.add_constraint(z - x <= 90));
+
+    SplitDBM bounded = dbm;
+    REQUIRE(bounded.limit_relations(1, std::nullopt));
+    REQUIRE(bounded.entail(y - x <= 1));
+    REQUIRE(!bounded.entail(z - x <= 90));
+    REQUIRE(bounded.entail(z <= 100));
+
+    SplitDBM intervals = dbm;
+    REQUIRE(intervals.limit_relations(0, 0));
+    REQUIRE(!intervals.entail(y - x <= 1));
+    REQUIRE(intervals.entail(x >= 0));
+    REQUIRE(intervals.entail(y <= 100));
+    REQUIRE(intervals.size().second == 6);
+
+    // Enough room for every relation leaves the domain as it was.
+    SplitDBM unlimited = dbm;
+    REQUIRE(!unlimited.limit_relations(4, std::nullopt));
+    REQUIRE(unlimited.entail(y - x <= 1));
+    REQUIRE(unlimited.entail(z - x <= 90));
+
+    // A budget on all relations keeps the most informative ones.
+    SplitDBM small = dbm;
+    REQUIRE(small.limit_relations(std::nullopt, 1));
+    REQUIRE(small.entail(y - x <= 1));
+    REQUIRE(!small.entail(z - x <= 90));
+}
+
+TEST_CASE("SplitDBM joins, widens and compares the packs of variables that copies share", "[split_dbm]") {
+    const variable_t x = variable_t::reg(data_kind_t::svalues, 1);
+    const variable_t y = variable_t::reg(data_kind_t::svalues, 2);
+    const variable_t z = variable_t::reg(data_kind_t::svalues, 3);
+
+    SplitDBM dbm;
+    REQUIRE(dbm.add_constraint(x >= 0));
+    REQUIRE(dbm.add_constraint(x <= 100));
+    REQUIRE(dbm.add_constraint(y <= 100));
+    REQUIRE(dbm.add_constraint(y - x <= 1));
+    REQUIRE(dbm.add_constraint(x - y <= 0));
+    REQUIRE(dbm.add_constraint(z >= 0));
+    REQUIRE(dbm.add_constraint(z <= 100));
+
+    // A copy shares every pack.
+    const SplitDBM copy = dbm;
+    REQUIRE(dbm <= copy);
+    REQUIRE(copy <= dbm);
+    const SplitDBM same = dbm | copy;
+    REQUIRE(same.entail(y - x <= 1));
+    REQUIRE(same.entail(z <= 100));
+    REQUIRE(dbm.widen(copy).entail(y - x <= 1));
+
+    // Changing z leaves the pack of x and y shared.
+    SplitDBM narrower = dbm;
+    REQUIRE(narrower.add_constraint(z >= 50));
+    REQUIRE(narrower <= dbm);
+    REQUIRE(!(dbm <= narrower));
+    const SplitDBM joined = dbm | narrower;
+    REQUIRE(joined.entail(y - x <= 1));
+    REQUIRE(joined.entail(x - y <= 0));
+    REQUIRE(joined.entail(z >= 0));
+    REQUIRE(!joined.entail(z >= 50));
+
+    SplitDBM wider = dbm;
+    wider.set(z, crab::interval_t{0, 200});
+    const SplitDBM widened = dbm.widen(wider);
+    REQUIRE(widened.entail(y - x <= 1));
+    REQUIRE(widened.entail(z >= 0));
+    REQUIRE(!widened.entail(z <= 200));
+
+    // Changing a relation of the pack of x and y is seen in it.
+    SplitDBM tighter = dbm;
+    REQUIRE(tighter.add_constraint(y - x <= 0));
+    REQUIRE(tighter <= dbm);
+    REQUIRE(!(dbm <= tighter));
+    const SplitDBM loosened = dbm | tighter;
+    REQUIRE(loosened.entail(y - x <= 1));
+    REQUIRE(!loosened.entail(y - x <= 0));
+    REQUIRE(loosened.entail(z <= 100));
+}
+
+TEST_CASE("AdaptGraph keeps the packs of its vertices until it changes", "[split_dbm]") {
+    AdaptGraph g;
+    g.growTo(5);
+    g.add_edge(1, 0, 2);
+    g.add_edge(0, 5, 3);
+    g.add_edge(3, 1, 0);
+    g.add_edge(4, 0, 3);
+    REQUIRE(g.packs()[1] == g.packs()[2]);
+    REQUIRE(g.packs()[3] == g.packs()[4]);
+    REQUIRE(g.packs()[1] != g.packs()[3]);
+
+    // A copy that links two packs sees them merge, and the graph it was copied from does not.
+    AdaptGraph linked = g;
+    linked.add_edge(2, 0, 3);
+    REQUIRE(linked.packs()[1] == linked.packs()[4]);
+    REQUIRE(g.packs()[1] != g.packs()[4]);
+
+    // Forgetting the vertex that linked them splits them again.
+    linked.forget(3);
+    REQUIRE(linked.packs()[1] == linked.packs()[2]);
+    REQUIRE(linked.packs()[2] != linked.packs()[4]);
+}
+
+TEST_CASE("AdaptGraph and its copies change apart", "[split_dbm]") {
+    AdaptGraph g;
+    g.growTo(3);
+    g.add_edge(1, 4, 2);
+
+    // The graph that was copied changes without changing the copy, and the other way around.
+    const AdaptGraph copy = g;
+    g.set_edge(1, 3, 2);
+    g.add_edge(2, 1, 1);
+    REQUIRE(copy.edge_val(1, 2) == 4);
+    REQUIRE(!copy.elem(2, 1));
+
+    AdaptGraph copy_of_copy = copy;
+    copy_of_copy.forget(2);
+    REQUIRE(copy.elem(1, 2));
+    REQUIRE(g.edge_val(1, 2) == 3);
+
+    // Later changes to the graph still leave the copy as it was.
+    g.set_edge(1, 2, 2);
+    REQUIRE(g.edge_val(1, 2) == 2);
+    REQUIRE(g.edge_val(2, 1) == 1);
+    REQUIRE(copy.edge_val(1, 2) == 4);
+}
+
+TEST_CASE("IntervalDomain keeps the bounds that SplitDBM implies and none of its relations", "[interval_domain]") {
+    const variable_t x = variable_t::reg(data_kind_t::svalues, 1);
+    const variable_t y = variable_t::reg(data_kind_t::svalues, 2);
+
+    SplitDBM dbm;
+    REQUIRE(dbm.add_constraint(x >= 0));
+    REQUIRE(dbm.add_constraint(x <= 10));
+    REQUIRE(dbm.add_constraint(y - x <= 4));
+    REQUIRE(dbm.add_constraint(x - y <= -2));
+
+    const IntervalDomain intervals{dbm};
+    REQUIRE(intervals[x] == crab::interval_t{0, 10});
+    REQUIRE(intervals[y] == crab::interval_t{2, 14});
+    REQUIRE(!intervals.entail(y - x <= 4));
+    REQUIRE(intervals.intersect(y - x == 10));
+    REQUIRE(intervals.size() == std::pair<std::size_t, std::size_t>{2, 0});
+
+    // Constraints narrow the bounds of each of their variables, from the bounds of the others.
+    IntervalDomain narrowed = intervals;
+    REQUIRE(narrowed.add_constraint(x + y <= 6));
+    REQUIRE(narrowed.entail(x <= 4));
+    REQUIRE(narrowed.entail(y <= 6));
+    REQUIRE(!narrowed.add_constraint(x + y >= 30));
+
+    // Join and widening forget the variables that one side does not bound.
+    IntervalDomain other;
+    other.set(x, crab::interval_t{5, 20});
+    const IntervalDomain joined = intervals | other;
+    REQUIRE(joined.entail(x >= 0));
+    REQUIRE(joined.entail(x <= 20));
+    REQUIRE(!joined.entail(y >= 2));
+    REQUIRE(intervals <= joined);
+    REQUIRE(!(joined <= intervals));
+    REQUIRE(!intervals.widen(other).entail(x <= 20));
+    REQUIRE(intervals.widen(other).entail(x >= 0));
+}
+
+TEST_CASE("IntervalDomain knows that an operand equals itself", "[interval_domain]") {
+    using crab::arith_binop_t;
+    using crab::bitwise_binop_t;
+    const variable_t x = variable_t::reg(data_kind_t::uvalues, 1);
+    const variable_t y = variable_t::reg(data_kind_t::uvalues, 2);
+    const variable_t z = variable_t::reg(data_kind_t::uvalues, 3);
+
+    IntervalDomain intervals;
+    intervals.set(y, crab::interval_t{3, 10});
+    intervals.set(z, crab::interval_t{3, 10});
+
+    intervals.apply(arith_binop_t::SUB, x, y, y, 64);
+    REQUIRE(intervals[x] == crab::interval_t{0});
+    intervals.apply(bitwise_binop_t::XOR, x, y, y, 64);
+    REQUIRE(intervals[x] == crab::interval_t{0});
+    intervals.apply(bitwise_binop_t::AND, x, y, y, 64);
+    REQUIRE(intervals[x] == crab::interval_t{3, 10});
+    intervals.apply(bitwise_binop_t::OR, x, y, y, 64);
+    REQUIRE(intervals[x] == crab::interval_t{3, 10});
+
+    // Two variables with the same bounds may still differ.
+    intervals.apply(arith_binop_t::SUB, x, y, z, 64);
+    REQUIRE(intervals[x] == crab::interval_t{-7, 7});
+    intervals.apply(bitwise_binop_t::XOR, x, y, z, 64);
+    REQUIRE(intervals[x].contains(5));
+    intervals.apply(bitwise_binop_t::AND, x, y, z, 64);
+    REQUIRE(intervals[x].contains(0));
+}
@@ -0,0 +1,49 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#include <catch2/catch_all.hpp>
+
+#include <algorithm>
+
+#include "crab/variable.hpp"
+
+using crab::data_kind_t;
+using crab::number_t;
+using crab::variable_t;
+
+TEST_CASE("variables print the names they are made from", "[variable]") {
+    REQUIRE(variable_t::reg(data_kind_t::svalues, 0).name() == "r0.svalue");
+    REQUIRE(variable_t::reg(data_kind_t::stack_numeric_sizes, 10).name() == "r10.stack_numeric_size");
+    REQUIRE(variable_t::stack_frame_var(data_kind_t::types, 6, "1/2").name() == "1/2/r6.type");
+    REQUIRE(variable_t::cell_var(data_kind_t::svalues, 504, 8).name() == "s[504...511].svalue");
+    REQUIRE(variable_t::cell_var(data_kind_t::uvalues, 511, 1).name() == "s[511].uvalue");
+    REQUIRE(variable_t::loop_counter("3").name() == "pc[3]");
+    REQUIRE(variable_t::meta_offset().name() == "meta_offset");
+    REQUIRE(variable_t::packet_size().name() == "packet_size");
+
+    const number_t huge = number_t{1} << 40;
+    REQUIRE(variable_t::cell_var(data_kind_t::svalues, 0, huge).name() ==
+            "s[0..." + (huge - 1).to_string() + "].svalue");
+}
+
+TEST_CASE("variables are classified without looking at their names", "[variable]") {
+    const variable_t cell_type = variable_t::cell_var(data_kind_t::types, 8, 4);
+    REQUIRE(cell_type.is_type());
+    REQUIRE(cell_type.is_in_stack());
+    REQUIRE_FALSE(cell_type.is_unsigned());
+    REQUIRE(variable_t::kind_var(data_kind_t::uvalues, cell_type) == variable_t::cell_var(data_kind_t::uvalues, 8, 4));
+    REQUIRE(variable_t::kind_var(data_kind_t::uvalues, cell_type).is_unsigned());
+
+    const variable_t frame_type = variable_t::stack_frame_var(data_kind_t::types, 7, "5");
+    REQUIRE(frame_type.is_stack_frame_var());
+    REQUIRE_FALSE(frame_type.is_in_stack());
+    REQUIRE(variable_t::kind_var(data_kind_t::svalues, frame_type) ==
+            variable_t::stack_frame_var(data_kind_t::svalues, 7, "5"));
+
+    REQUIRE_FALSE(variable_t::loop_counter("3").is_type());
+    REQUIRE_FALSE(variable_t::packet_size().is_unsigned());
+
+    const auto types = variable_t::get_type_variables();
+    REQUIRE(std::ranges::find(types, cell_type) != types.end());
+    REQUIRE(std::ranges::find(types, frame_type) != types.end());
+    REQUIRE(std::ranges::find(types, variable_t::reg(data_kind_t::types, 10)) != types.end());
+}
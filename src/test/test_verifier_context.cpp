@@ -0,0 +1,77 @@
+// Copyright (c) Prevail Verifier contributors.
+// SPDX-License-Identifier: MIT
+#include <catch2/catch_all.hpp>
+
+#include "ebpf_verifier.hpp"
+
+using crab::data_kind_t;
+using crab::variable_t;
+
+namespace {
+Program make_program(const std::vector<ebpf_inst>& insts, const ebpf_verifier_options_t& options) {
+    const program_info info{.platform = &g_ebpf_platform_linux,
+                            .type = g_ebpf_platform_linux.get_program_type("unspec", "unspec")};
+    const raw_program raw_prog{"", "", 0, "", insts, info};
+    return Program::from_sequence(std::get<InstructionSeq>(unmarshal(raw_prog)), raw_prog.info, options);
+}
+
+const std::vector<ebpf_inst> exit_zero{
+    {.opcode = INST_CLS_ALU64 | INST_SRC_IMM | INST_ALU_OP_MOV, .dst = 0, .imm = 0},
+    {.opcode = INST_OP_EXIT},
+};
+
+const std::vector<ebpf_inst> exit_uninitialized{
+    {.opcode = INST_OP_EXIT},
+};
+} // namespace
+
+TEST_CASE("verifier contexts keep their state while others use the thread", "[context]") {
+    verifier_context_t first;
+    verifier_context_t second;
+
+    std::string first_name;
+    {
+        const verifier_context_t::scope_t scope(first);
+        thread_local_options.strict = true;
+        first_name = variable_t::stack_frame_var(data_kind_t::svalues, 1, "first").name();
+    }
+    REQUIRE(!thread_local_options.strict);
+    {
+        const verifier_context_t::scope_t scope(second);
+        REQUIRE(!thread_local_options.strict);
+        // The first context has the only name of this thread, so the second one gives the same index to another.
+        REQUIRE(variable_t::stack_frame_var(data_kind_t::svalues, 1, "second").name() != first_name);
+    }
+    {
+        const verifier_context_t::scope_t scope(first);
+        REQUIRE(thread_local_options.strict);
+        REQUIRE(variable_t::stack_frame_var(data_kind_t::svalues, 1, "first").name() == first_name);
+    }
+}
+
+TEST_CASE("verifier contexts interleave the analyses of programs on one thread", "[context]") {
+    const ebpf_verifier_options_t options{};
+    verifier_context_t safe_context;
+    verifier_context_t unsafe_context;
+
+    std::optional<Program> safe;
+    std::optional<Program> unsafe;
+    {
+        const verifier_context_t::scope_t scope(safe_context);
+        safe.emplace(make_program(exit_zero, options));
+    }
+    {
+        const verifier_context_t::scope_t scope(unsafe_context);
+        unsafe.emplace(make_program(exit_uninitialized, options));
+    }
+    for (int round = 0; round < 2; round++) {
+        {
+            const verifier_context_t::scope_t scope(safe_context);
+            REQUIRE(verify(*safe));
+        }
+        {
+            const verifier_context_t::scope_t scope(unsafe_context);
+            REQUIRE(!verify(*unsafe));
+        }
+    }
+}
@@ -1,6 +1,7 @@
 // Copyright (c) Prevail Verifier contributors.
 // SPDX-License-Identifier: MIT
 #include <catch2/catch_all.hpp>
+#include <cstring>
 #include <thread>
 
 #include "ebpf_verifier.hpp"
@@ -60,6 +61,7 @@ FAIL_ANALYZE("build", "badmapptr.o", "test")
                 REQUIRE(inst_seq != nullptr);                                                                 \
                 const Program prog = Program::from_sequence(*inst_seq, raw_prog.info, thread_local_options);  \
                 REQUIRE(verify(prog) == should_pass);                                                         \
+                REQUIRE(!verify_fail_fast(prog) == should_pass);                                              \
             }                                                                                                 \
         }                                                                                                     \
     } while (0)
@@ -637,3 +639,248 @@ TEST_CASE("multithreading", "[verify][multithreading]") {
     REQUIRE(res1);
     REQUIRE(res2);
 }
+
+TEST_CASE("loop statistics count skipped transfers", "[verify][loop]") {
+    const program_info info{.platform = &g_ebpf_platform_linux,
+                            .type = g_ebpf_platform_linux.get_program_type("unspec", "unspec")};
+    // r2 flips between 0 and 1, and the loop exits once it was 1 at the head. The loop reaches its fixpoint without
+    // widening, so the decreasing iteration finds the head unchanged and has no reason to compute the body again.
+    const std::vector<ebpf_inst> insts{
+        {.opcode = INST_CLS_ALU64 | INST_SRC_IMM | INST_ALU_OP_MOV, .dst = 2, .imm = 0},
+        {.opcode = INST_CLS_ALU64 | INST_SRC_REG | INST_ALU_OP_MOV, .dst = 3, .src = 2},
+        {.opcode = INST_CLS_ALU64 | INST_SRC_IMM | INST_ALU_OP_XOR, .dst = 2, .imm = 1},
+        {.opcode = INST_CLS_JMP | INST_SRC_IMM | 0x10, .dst = 3, .offset = -3, .imm = 0}, // if r3 == 0 goto 1
+        {.opcode = INST_CLS_ALU64 | INST_SRC_IMM | INST_ALU_OP_MOV, .dst = 0, .imm = 0},
+        {.opcode = INST_OP_EXIT},
+    };
+    const auto inst_seq = std::get<InstructionSeq>(unmarshal(raw_program{"", "", 0, "", insts, info}));
+    const Program prog = Program::from_sequence(inst_seq, info, {});
+    const Invariants invariants = analyze(prog);
+    REQUIRE(invariants.verified(prog));
+
+    const auto& stats = invariants.loop_statistics();
+    REQUIRE(stats.size() == 1);
+    REQUIRE(stats.contains(crab::label_t{1}));
+    REQUIRE(stats.at(crab::label_t{1}).transfers > 0);
+    REQUIRE(stats.at(crab::label_t{1}).skipped_transfers > 0);
+}
+
+TEST_CASE("fail-fast verification stops at a failed assertion", "[verify][fail-fast]") {
+    const program_info info{.platform = &g_ebpf_platform_linux,
+                            .type = g_ebpf_platform_linux.get_program_type("unspec", "unspec")};
+    // The loop is fine, but the program returns an uninitialized register after it.
+    const std::vector<ebpf_inst> insts{
+        {.opcode = INST_CLS_ALU64 | INST_SRC_IMM | INST_ALU_OP_MOV, .dst = 1, .imm = 0},
+        {.opcode = INST_CLS_ALU64 | INST_SRC_IMM | INST_ALU_OP_ADD, .dst = 1, .imm = 1},
+        {.opcode = INST_CLS_JMP | INST_SRC_IMM | 0xa0, .dst = 1, .offset = -2, .imm = 10}, // if r1 < 10 goto 1
+        {.opcode = INST_OP_EXIT},
+    };
+    const auto inst_seq = std::get<InstructionSeq>(unmarshal(raw_program{"", "", 0, "", insts, info}));
+    const Program prog = Program::from_sequence(inst_seq, info, {});
+
+    const std::set<std::string> warnings = analyze(prog).check_assertions(prog).warning_set();
+    REQUIRE(!warnings.empty());
+    const auto failure = verify_fail_fast(prog);
+    REQUIRE(failure);
+    REQUIRE(warnings.contains(to_string(failure->label) + ": " + failure->message));
+    REQUIRE(!verify(prog));
+}
+
+TEST_CASE("fail-fast verification of a valid program", "[verify][fail-fast]") {
+    const program_info info{.platform = &g_ebpf_platform_linux,
+                            .type = g_ebpf_platform_linux.get_program_type("unspec", "unspec")};
+    const std::vector<ebpf_inst> insts{
+        {.opcode = INST_CLS_ALU64 | INST_SRC_IMM | INST_ALU_OP_MOV, .dst = 0, .imm = 0},
+        {.opcode = INST_CLS_ALU64 | INST_SRC_IMM | INST_ALU_OP_ADD, .dst = 0, .imm = 1},
+        {.opcode = INST_CLS_JMP | INST_SRC_IMM | 0xa0, .dst = 0, .offset = -2, .imm = 10}, // if r0 < 10 goto 1
+        {.opcode = INST_OP_EXIT},
+    };
+    const auto inst_seq = std::get<InstructionSeq>(unmarshal(raw_program{"", "", 0, "", insts, info}));
+    const Program prog = Program::from_sequence(inst_seq, info, {});
+    REQUIRE(!verify_fail_fast(prog));
+    REQUIRE(verify(prog));
+}
+
+TEST_CASE("tiered verification needs relations only for relational facts", "[verify][tiered]") {
+    const program_info info{.platform = &g_ebpf_platform_linux,
+                            .type = g_ebpf_platform_linux.get_program_type("unspec", "unspec")};
+    const auto program_of = [&](const std::vector<ebpf_inst>& insts) {
+        const auto inst_seq = std::get<InstructionSeq>(unmarshal(raw_program{"", "", 0, "", insts, info}));
+        return Program::from_sequence(inst_seq, info, {});
+    };
+
+    // Bounds alone prove that r0 is a number at the exit.
+    const Program simple = program_of({
+        {.opcode = INST_CLS_ALU64 | INST_SRC_IMM | INST_ALU_OP_MOV, .dst = 0, .imm = 0},
+        {.opcode = INST_CLS_ALU64 | INST_SRC_IMM | INST_ALU_OP_ADD, .dst = 0, .imm = 1},
+        {.opcode = INST_CLS_JMP | INST_SRC_IMM | 0xa0, .dst = 0, .offset = -2, .imm = 10}, // if r0 < 10 goto 1
+        {.opcode = INST_OP_EXIT},
+    });
+    REQUIRE(analyze_intervals(simple));
+    const tiered_verdict_t simple_verdict = verify_tiered(simple);
+    REQUIRE(!simple_verdict.failure);
+    REQUIRE(simple_verdict.tier == numeric_domain_t::interval);
+
+    // Only the equality of r0 and r1 shows that r0 is never overwritten with the uninitialized r3.
+    const Program relational = program_of({
+        {.opcode = INST_CLS_ALU64 | INST_SRC_IMM | INST_ALU_OP_MOV, .dst = 0, .imm = 0},
+        {.opcode = INST_CLS_ALU64 | INST_SRC_IMM | INST_ALU_OP_MOV, .dst = 1, .imm = 0},
+        {.opcode = INST_CLS_ALU64 | INST_SRC_IMM | INST_ALU_OP_ADD, .dst = 0, .imm = 1},
+        {.opcode = INST_CLS_ALU64 | INST_SRC_IMM | INST_ALU_OP_ADD, .dst = 1, .imm = 1},
+        {.opcode = INST_CLS_JMP | INST_SRC_IMM | 0xa0, .dst = 0, .offset = -3, .imm = 10}, // if r0 < 10 goto 2
+        {.opcode = INST_CLS_JMP | INST_SRC_REG | 0x10, .dst = 1, .src = 0, .offset = 1},   // if r1 == r0 goto 7
+        {.opcode = INST_CLS_ALU64 | INST_SRC_REG | INST_ALU_OP_MOV, .dst = 0, .src = 3},
+        {.opcode = INST_OP_EXIT},
+    });
+    REQUIRE(!analyze_intervals(relational));
+    const tiered_verdict_t relational_verdict = verify_tiered(relational);
+    REQUIRE(!relational_verdict.failure);
+    REQUIRE(relational_verdict.tier == numeric_domain_t::zone);
+    REQUIRE(verify(relational));
+
+    // A program that is not safe is rejected by the relational analysis.
+    const Program unsafe = program_of({
+        {.opcode = INST_CLS_ALU64 | INST_SRC_REG | INST_ALU_OP_MOV, .dst = 0, .src = 3},
+        {.opcode = INST_OP_EXIT},
+    });
+    const tiered_verdict_t unsafe_verdict = verify_tiered(unsafe);
+    REQUIRE(unsafe_verdict.failure);
+    REQUIRE(unsafe_verdict.tier == numeric_domain_t::zone);
+}
+
+TEST_CASE("bounded zones forget relations over budget", "[verify][bounded_zone]") {
+    const program_info info{.platform = &g_ebpf_platform_linux,
+                            .type = g_ebpf_platform_linux.get_program_type("unspec", "unspec")};
+    const std::vector<ebpf_inst> insts{
+        {.opcode = INST_CLS_ALU64 | INST_SRC_IMM | INST_ALU_OP_MOV, .dst = 0, .imm = 0},
+        {.opcode = INST_CLS_ALU64 | INST_SRC_IMM | INST_ALU_OP_ADD, .dst = 0, .imm = 1},
+        {.opcode = INST_CLS_JMP | INST_SRC_IMM | 0xa0, .dst = 0, .offset = -2, .imm = 10}, // if r0 < 10 goto 1
+        {.opcode = INST_OP_EXIT},
+    };
+    const auto inst_seq = std::get<InstructionSeq>(unmarshal(raw_program{"", "", 0, "", insts, info}));
+
+    const Program zone = Program::from_sequence(inst_seq, info, {});
+    const Invariants zone_invariants = analyze(zone);
+    REQUIRE(zone_invariants.over_budget_count() == 0);
+
+    ebpf_verifier_options_t options{};
+    options.numeric_domain = numeric_domain_t::bounded_zone;
+    options.max_relations_per_variable = 1;
+    const Program prog = Program::from_sequence(inst_seq, info, options);
+    const Invariants invariants = analyze(prog);
+    REQUIRE(invariants.over_budget_count() > 0);
+    REQUIRE(invariants.verified(prog));
+    REQUIRE(invariants.max_numeric_size().second <= zone_invariants.max_numeric_size().second);
+}
+
+TEST_CASE("summarized local calls share calling contexts", "[verify][summaries]") {
+    const program_info info{.platform = &g_ebpf_platform_linux,
+                            .type = g_ebpf_platform_linux.get_program_type("unspec", "unspec")};
+    // The subprogram at 7 is called twice with the same arguments.
+    const std::vector<ebpf_inst> insts{
+        {.opcode = INST_CLS_ALU64 | INST_SRC_IMM | INST_ALU_OP_MOV, .dst = 0, .imm = 0},
+        {.opcode = INST_CLS_ALU64 | INST_SRC_IMM | INST_ALU_OP_MOV, .dst = 1, .imm = 1},
+        {.opcode = INST_OP_CALL, .src = INST_CALL_LOCAL, .imm = 4},
+        {.opcode = INST_CLS_ALU64 | INST_SRC_IMM | INST_ALU_OP_MOV, .dst = 0, .imm = 0},
+        {.opcode = INST_CLS_ALU64 | INST_SRC_IMM | INST_ALU_OP_MOV, .dst = 1, .imm = 1},
+        {.opcode = INST_OP_CALL, .src = INST_CALL_LOCAL, .imm = 1},
+        {.opcode = INST_OP_EXIT},
+        {.opcode = INST_CLS_ALU64 | INST_SRC_REG | INST_ALU_OP_MOV, .dst = 0, .src = 1},
+        {.opcode = INST_OP_EXIT},
+    };
+    const auto inst_seq = std::get<InstructionSeq>(unmarshal(raw_program{"", "", 0, "", insts, info}));
+
+    const Program inlined = Program::from_sequence(inst_seq, info, {});
+    const crab::interval_t inlined_exit_value = analyze(inlined).exit_value();
+
+    ebpf_verifier_options_t options{};
+    options.cfg_opts.summarize_local_calls = true;
+    const Program prog = Program::from_sequence(inst_seq, info, options);
+    REQUIRE(prog.subprograms().size() == 1);
+    const auto result = crab::run_forward_analyzer(prog, crab::ebpf_domain_t::setup_entry(true));
+    REQUIRE(result.call_contexts.size() == 1);
+
+    const Invariants invariants = analyze(prog);
+    REQUIRE(invariants.exit_value() == inlined_exit_value);
+    REQUIRE(invariants.verified(prog));
+    REQUIRE(verify(prog));
+}
+
+static std::vector<raw_program> read_elf_stream(const std::string& path, const ebpf_verifier_options_t& options) {
+    std::ifstream stream{path, std::ios::in | std::ios::binary};
+    return read_elf(stream, path, "", options, &g_ebpf_platform_linux);
+}
+
+TEST_CASE("mapped and streamed ELF files give the same programs", "[verify][elf]") {
+    ebpf_verifier_options_t options{};
+    options.verbosity_opts.print_line_info = true;
+    for (const std::string path : {"ebpf-samples/cilium/bpf_lxc.o", "ebpf-samples/bpf_cilium_test/bpf_netdev.o",
+                                   "ebpf-samples/build/map_in_map.o"}) {
+        const auto mapped = read_elf(path, "", options, &g_ebpf_platform_linux);
+        const auto streamed = read_elf_stream(path, options);
+        REQUIRE(mapped.size() == streamed.size());
+        for (size_t i = 0; i < mapped.size(); i++) {
+            REQUIRE(mapped[i].section_name == streamed[i].section_name);
+            REQUIRE(mapped[i].function_name == streamed[i].function_name);
+            REQUIRE(mapped[i].prog.size() == streamed[i].prog.size());
+            REQUIRE(std::memcmp(mapped[i].prog.data(), streamed[i].prog.data(),
+                                mapped[i].prog.size() * sizeof(ebpf_inst)) == 0);
+            REQUIRE(mapped[i].info.map_descriptors.size() == streamed[i].info.map_descriptors.size());
+            REQUIRE(mapped[i].info.line_info.size() == streamed[i].info.line_info.size());
+        }
+    }
+}
+
+TEST_CASE("ELF loading benchmark", "[.][elf-benchmark]") {
+    for (const std::string path : {"ebpf-samples/cilium/bpf_lxc.o", "ebpf-samples/ovs/datapath.o",
+                                   "ebpf-samples/falco/probe.o", "ebpf-samples/bpf_cilium_test/bpf_lxc_jit.o"}) {
+        BENCHMARK(path + " mapped") { return read_elf(path, "", {}, &g_ebpf_platform_linux).size(); };
+        BENCHMARK(path + " streamed") { return read_elf_stream(path, {}).size(); };
+    }
+}
+
+TEST_CASE("source lines are only read when they are printed", "[verify][elf]") {
+    const std::string path = "ebpf-samples/build/map_in_map.o";
+    for (const raw_program& raw_prog : read_elf(path, "", {}, &g_ebpf_platform_linux)) {
+        REQUIRE(raw_prog.info.line_info.empty());
+    }
+    ebpf_verifier_options_t options{};
+    options.verbosity_opts.print_line_info = true;
+    const auto with_lines = read_elf(path, "", options, &g_ebpf_platform_linux);
+    REQUIRE(std::ranges::any_of(with_lines,
+                                [](const raw_program& raw_prog) { return !raw_prog.info.line_info.empty(); }));
+}
+
+TEST_CASE("loop statistics count the transfers of a nested loop skipped on outer iterations", "[verify][loop]") {
+    const program_info info{.platform = &g_ebpf_platform_linux,
+                            .type = g_ebpf_platform_linux.get_program_type("unspec", "unspec")};
+    // The outer loop widens r2 at its head, but resets r2 before the inner loop, so the inner loop starts from the
+    // same state on every outer iteration and needs computing only once.
+    const std::vector<ebpf_inst> insts{
+        {.opcode = INST_OP_CALL, .imm = 7}, // r0 = bpf_get_prandom_u32()
+        {.opcode = INST_CLS_ALU64 | INST_SRC_REG | INST_ALU_OP_MOV, .dst = 6, .src = 0},
+        {.opcode = INST_CLS_ALU64 | INST_SRC_IMM | INST_ALU_OP_MOV, .dst = 2, .imm = 0},
+        {.opcode = INST_CLS_JMP | INST_SRC_IMM | 0x10, .dst = 6, .offset = 4, .imm = 0}, // if r6 == 0 goto 8
+        {.opcode = INST_CLS_ALU64 | INST_SRC_IMM | INST_ALU_OP_MOV, .dst = 2, .imm = 0},
+        {.opcode = INST_CLS_ALU64 | INST_SRC_IMM | INST_ALU_OP_ADD, .dst = 2, .imm = 1},
+        {.opcode = INST_CLS_JMP | INST_SRC_IMM | 0xa0, .dst = 2, .offset = -2, .imm = 10}, // if r2 < 10 goto 5
+        {.opcode = INST_OP_JA16, .offset = -5},                                            // goto 3
+        {.opcode = INST_CLS_ALU64 | INST_SRC_IMM | INST_ALU_OP_MOV, .dst = 0, .imm = 0},
+        {.opcode = INST_OP_EXIT},
+    };
+    const auto inst_seq = std::get<InstructionSeq>(unmarshal(raw_program{"", "", 0, "", insts, info}));
+    const Program prog = Program::from_sequence(inst_seq, info, {});
+    const Invariants invariants = analyze(prog);
+    REQUIRE(invariants.verified(prog));
+
+    const auto& stats = invariants.loop_statistics();
+    REQUIRE(stats.size() == 2);
+    const crab::loop_statistics_t& inner = stats.at(crab::label_t{5});
+    const crab::loop_statistics_t& outer = stats.at(crab::label_t{3});
+    INFO("inner: " << inner.transfers << " applied, " << inner.skipped_transfers << " skipped");
+    INFO("outer: " << outer.transfers << " applied, " << outer.skipped_transfers << " skipped");
+    // The outer loop goes around more than once, and the inner loop is skipped as a whole after the first time.
+    REQUIRE(outer.transfers > 0);
+    REQUIRE(inner.transfers > 0);
+    REQUIRE(inner.skipped_transfers > 0);
+}
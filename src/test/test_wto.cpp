@@ -54,3 +54,23 @@ TEST_CASE("wto figure 2b", "[wto]") {
     os << wto;
     REQUIRE(os.str() == "entry ( 1 4 2 3 ) exit \n");
 }
+
+TEST_CASE("frozen cfg numbers labels in order", "[wto]") {
+    const crab::frozen_cfg_t cfg(crab::cfg_from_adjacency_list({{label_t::entry, {label_t{1}}},
+                                                                {label_t{1}, {label_t{3}, label_t{2}}},
+                                                                {label_t{2}, {label_t{3}}},
+                                                                {label_t{3}, {label_t{1}, label_t::exit}}}));
+
+    REQUIRE(cfg.size() == 5);
+    REQUIRE(cfg.label(cfg.entry()) == label_t::entry);
+    REQUIRE(cfg.label(cfg.exit()) == label_t::exit);
+    for (crab::node_id_t node = 0; node < cfg.size(); node++) {
+        REQUIRE(cfg.node(cfg.label(node)) == node);
+    }
+    const auto children = cfg.children_of(cfg.node(label_t{1}));
+    REQUIRE(std::vector(children.begin(), children.end()) ==
+            std::vector{cfg.node(label_t{2}), cfg.node(label_t{3})});
+    const auto parents = cfg.parents_of(cfg.node(label_t{3}));
+    REQUIRE(std::vector(parents.begin(), parents.end()) == std::vector{cfg.node(label_t{1}), cfg.node(label_t{2})});
+    REQUIRE(cfg.parents_of(cfg.entry()).empty());
+}
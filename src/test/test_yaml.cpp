@@ -1,22 +1,48 @@
 // Copyright (c) Prevail Verifier contributors.
 // SPDX-License-Identifier: MIT
 #include <catch2/catch_all.hpp>
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <string>
+#include <vector>
 
 #include "ebpf_verifier.hpp"
 #include "ebpf_yaml.hpp"
 
 // TODO: move out of this framework
 
-#define YAML_CASE(path)                                                     \
-    TEST_CASE("YAML suite: " path, "[yaml]") {                              \
-        foreach_suite(path, [&](const TestCase& test_case) {                \
-            std::optional<Failure> failure = run_yaml_test_case(test_case); \
-            if (failure) {                                                  \
-                std::cout << "test case: " << test_case.name << "\n";       \
-                print_failure(*failure);                                    \
-            }                                                               \
-            REQUIRE(!failure);                                              \
-        });                                                                 \
+namespace {
+/// Options under which every suite must give the expected results.
+struct yaml_configuration_t {
+    const char* name;
+    void (*configure)(ebpf_verifier_options_t& options);
+};
+
+constexpr std::array<yaml_configuration_t, 3> yaml_configurations{{
+    {"serial analysis", [](ebpf_verifier_options_t&) {}},
+    {"parallel analysis", [](ebpf_verifier_options_t& options) { options.analysis_threads = 4; }},
+    {"compact invariants", [](ebpf_verifier_options_t& options) { options.compact_invariants = true; }},
+}};
+} // namespace
+
+static void test_yaml_suite(const std::string& path) {
+    const yaml_configuration_t configuration = GENERATE(from_range(yaml_configurations));
+    INFO(configuration.name);
+    foreach_suite(path, [&](TestCase test_case) {
+        configuration.configure(test_case.options);
+        std::optional<Failure> failure = run_yaml_test_case(test_case);
+        if (failure) {
+            std::cout << "test case: " << test_case.name << " (" << configuration.name << ")\n";
+            print_failure(*failure);
+        }
+        REQUIRE(!failure);
+    });
+}
+
+#define YAML_CASE(path)                        \
+    TEST_CASE("YAML suite: " path, "[yaml]") { \
+        test_yaml_suite(path);                 \
     }
 
 YAML_CASE("test-data/add.yaml")
@@ -44,3 +70,32 @@ YAML_CASE("test-data/subtract.yaml")
 YAML_CASE("test-data/uninit.yaml")
 YAML_CASE("test-data/unop.yaml")
 YAML_CASE("test-data/unsigned.yaml")
+
+// The suites only check the invariant at the exit, and share the variable names of the thread, so they would not
+// notice invariants elsewhere that depend on the order in which a parallel analysis happens to create names.
+TEST_CASE("YAML suites have the same invariants with parallel analysis", "[yaml][parallel]") {
+    std::vector<std::filesystem::path> paths;
+    for (const auto& entry : std::filesystem::directory_iterator("test-data")) {
+        if (entry.path().extension() == ".yaml") {
+            paths.push_back(entry.path());
+        }
+    }
+    std::ranges::sort(paths);
+    REQUIRE(!paths.empty());
+    for (const std::filesystem::path& path : paths) {
+        foreach_suite(path.string(), [&](TestCase test_case) {
+            INFO(path.string() << ": " << test_case.name);
+            std::string serial;
+            {
+                // Each analysis gets its own names, created in the order it asks for them.
+                verifier_context_t context;
+                const verifier_context_t::scope_t scope(context);
+                serial = yaml_test_case_invariants(test_case);
+            }
+            test_case.options.analysis_threads = 4;
+            verifier_context_t context;
+            const verifier_context_t::scope_t scope(context);
+            REQUIRE(yaml_test_case_invariants(test_case) == serial);
+        });
+    }
+}